@@ -0,0 +1,498 @@
+/// @file config.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <getopt.h>
+#include <math.h>
+#include "config.h"
+#include "pds_telecom.h"
+
+/**
+ * @brief Fills a sweep specification with the default values.
+ *
+ * No antenna pair, SNR or input file is set: they must come from the configuration file or from
+ * the command line. The seed is taken from the clock, so runs are reproducible only when a seed
+ * is given.
+ *
+ * @param cfg The specification to be filled.
+ */
+void config_defaults(sim_config *cfg){
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->reference = SNR_ESN0;
+    cfg->modulation = 4;
+    cfg->channel = CHANNEL_REAL;
+    cfg->realizations = 1;
+    cfg->seed = (uint64_t) time(NULL);
+    cfg->block_width = TX_BLOCK_WIDTH;
+    cfg->chunk_width = TX_CHUNK_WIDTH;
+    cfg->max_bits = 100000000;
+    cfg->frame_length = TX_BLOCK_WIDTH;
+    cfg->confidence = 0.95;
+    cfg->write_files = 1;
+    strcpy(cfg->output, "output.csv");
+}
+
+/** Copies `value` into a path field of the specification, failing if it does not fit. */
+static int set_path(char *dst, size_t size, const char *key, const char *value){
+    if (strlen(value) >= size){
+        printf("Value of '%s' is too long\n", key);
+        return -1;
+    }
+    strcpy(dst, value);
+    return 0;
+}
+
+/** Parses an integer, failing on anything but a whole number not below `min`. */
+static int parse_int(const char *key, const char *value, int min, int *out){
+    char *fim;
+    long v = strtol(value, &fim, 10);
+    if (fim == value || *fim != '\0' || v < min || v > 1 << 30){
+        printf("Invalid value for '%s': %s\n", key, value);
+        return -1;
+    }
+    *out = (int) v;
+    return 0;
+}
+
+/** Parses a non-negative count that may exceed the range of an int, such as a bit budget (`1e9` is accepted). */
+static int parse_count(const char *key, const char *value, long long *out){
+    char *fim;
+    double v = strtod(value, &fim);
+    if (fim == value || *fim != '\0' || v < 0 || v > 9e18 || v != floor(v)){
+        printf("Invalid value for '%s': %s\n", key, value);
+        return -1;
+    }
+    *out = (long long) v;
+    return 0;
+}
+
+/** Parses a yes/no value (`yes`, `no`, `true`, `false`, `1` or `0`). */
+static int parse_bool(const char *key, const char *value, int *out){
+    if (strcmp(value, "yes") == 0 || strcmp(value, "true") == 0 || strcmp(value, "1") == 0){
+        *out = 1;
+    }else if (strcmp(value, "no") == 0 || strcmp(value, "false") == 0 || strcmp(value, "0") == 0){
+        *out = 0;
+    }else{
+        printf("Invalid value for '%s': %s (expected yes or no)\n", key, value);
+        return -1;
+    }
+    return 0;
+}
+
+/** Parses a list of antenna pairs such as `2x4,4x8,32x16`. */
+static int parse_antennas(sim_config *cfg, const char *value){
+    const char *p = value;
+    cfg->Nantennas = 0;
+    while (*p != '\0'){
+        char *fim;
+        long nr = strtol(p, &fim, 10);
+        if (fim == p || (*fim != 'x' && *fim != 'X')){
+            printf("Invalid antenna pair in '%s' (expected NrxNt)\n", value);
+            return -1;
+        }
+        p = fim + 1;
+        long nt = strtol(p, &fim, 10);
+        if (fim == p || nr <= 0 || nt <= 0){
+            printf("Invalid antenna pair in '%s' (expected NrxNt)\n", value);
+            return -1;
+        }
+        if (cfg->Nantennas == CONFIG_MAX_ANTENNAS){
+            printf("Too many antenna pairs (at most %d)\n", CONFIG_MAX_ANTENNAS);
+            return -1;
+        }
+        cfg->Nr[cfg->Nantennas] = (int) nr;
+        cfg->Nt[cfg->Nantennas] = (int) nt;
+        cfg->Nantennas++;
+        p = fim;
+        if (*p == ','){
+            p++;
+        }else if (*p != '\0'){
+            printf("Invalid antenna pair in '%s' (expected NrxNt)\n", value);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/** Adds one SNR to the grid. */
+static int add_snr(sim_config *cfg, double snr){
+    if (cfg->Nsnr == CONFIG_MAX_SNR){
+        printf("Too many SNR points (at most %d)\n", CONFIG_MAX_SNR);
+        return -1;
+    }
+    cfg->snr_dB[cfg->Nsnr++] = snr;
+    return 0;
+}
+
+/**
+ * Parses an SNR grid: a comma-separated list whose items are either a value or a range
+ * `start:step:stop`, with stop included, e.g. `0:2.5:20,30,inf`.
+ */
+static int parse_snr(sim_config *cfg, const char *value){
+    const char *p = value;
+    cfg->Nsnr = 0;
+    while (*p != '\0'){
+        char *fim;
+        double inicio = strtod(p, &fim);
+        if (fim == p){
+            printf("Invalid SNR grid '%s'\n", value);
+            return -1;
+        }
+        p = fim;
+        if (*p == ':'){
+            double passo = strtod(p + 1, &fim);
+            if (fim == p + 1 || *fim != ':' || passo == 0){
+                printf("Invalid SNR range in '%s' (expected start:step:stop)\n", value);
+                return -1;
+            }
+            p = fim + 1;
+            double fim_faixa = strtod(p, &fim);
+            if (fim == p || (fim_faixa - inicio) / passo < 0){
+                printf("Invalid SNR range in '%s' (expected start:step:stop)\n", value);
+                return -1;
+            }
+            p = fim;
+            // Counting the points avoids accumulating the rounding of the step
+            long n = (long) ((fim_faixa - inicio) / passo + 1e-9);
+            for (long i = 0; i <= n; i++){
+                if (add_snr(cfg, inicio + i * passo) != 0){
+                    return -1;
+                }
+            }
+        }else if (add_snr(cfg, inicio) != 0){
+            return -1;
+        }
+        if (*p == ','){
+            p++;
+        }else if (*p != '\0'){
+            printf("Invalid SNR grid '%s'\n", value);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Sets one parameter of a sweep specification.
+ *
+ * The keys are the ones of the configuration file; dashes and underscores are equivalent, so the
+ * long command-line options map to the same keys:
+ * - `antennas`: antenna pairs, e.g. `2x4,4x8`.
+ * - `snr`: SNR grid in dB, e.g. `0:2:20,30`.
+ * - `snr_type`: `esn0` or `ebn0`.
+ * - `modulation`: order of the QAM constellation (4, 16, 64, 256 or 1024).
+ * - `channel`: `real` or `rayleigh`.
+ * - `streams`: number of strongest eigenmodes used as streams (0, the default, for all of them).
+ * - `realizations`: channel realizations per point.
+ * - `seed`: seed of the random streams.
+ * - `block_width`: columns per transmission block (0 for the whole matrix).
+ * - `chunk_width`: columns of the stream matrix streamed through the link at once (0 for the whole matrix).
+ * - `pipeline`: `yes` runs the transmitter, channel and receiver of each test on threads of their own.
+ * - `threads`: worker threads (0 for one per processor).
+ * - `target_errors`: bit errors per Monte Carlo point; 0 (default) transmits the input file instead.
+ * - `max_bits`: bit budget per Monte Carlo point.
+ * - `frame_length`: symbols per stream in a Monte Carlo frame.
+ * - `confidence`: confidence level of the BER intervals.
+ * - `input`, `output`, `tests_dir`: input file, output CSV and directory of the received files.
+ * - `write_files`: `no` skips writing the received files, when only the statistics are needed.
+ * - `write_llr`: `yes` also writes the LLRs of the received bits of each test, as float32 values.
+ *
+ * @param cfg The specification.
+ * @param key The parameter name.
+ * @param value The parameter value.
+ *
+ * @return 0 on success, or -1 (after printing the reason) for an unknown key or an invalid value.
+ */
+int config_set(sim_config *cfg, const char *key, const char *value){
+    char k[64];
+    size_t n = strlen(key);
+    if (n >= sizeof(k)){
+        printf("Unknown parameter '%s'\n", key);
+        return -1;
+    }
+    for (size_t i = 0; i <= n; i++){
+        k[i] = (key[i] == '-') ? '_' : key[i];
+    }
+
+    if (strcmp(k, "antennas") == 0){
+        return parse_antennas(cfg, value);
+    }else if (strcmp(k, "snr") == 0){
+        return parse_snr(cfg, value);
+    }else if (strcmp(k, "snr_type") == 0){
+        if (strcmp(value, "esn0") == 0){
+            cfg->reference = SNR_ESN0;
+        }else if (strcmp(value, "ebn0") == 0){
+            cfg->reference = SNR_EBN0;
+        }else{
+            printf("Invalid value for 'snr_type': %s (expected esn0 or ebn0)\n", value);
+            return -1;
+        }
+        return 0;
+    }else if (strcmp(k, "modulation") == 0){
+        return parse_int(k, value, 2, &cfg->modulation);
+    }else if (strcmp(k, "channel") == 0){
+        if (strcmp(value, "real") == 0){
+            cfg->channel = CHANNEL_REAL;
+        }else if (strcmp(value, "rayleigh") == 0){
+            cfg->channel = CHANNEL_RAYLEIGH;
+        }else{
+            printf("Invalid value for 'channel': %s (expected real or rayleigh)\n", value);
+            return -1;
+        }
+        return 0;
+    }else if (strcmp(k, "streams") == 0){
+        return parse_int(k, value, 0, &cfg->streams);
+    }else if (strcmp(k, "realizations") == 0){
+        return parse_int(k, value, 1, &cfg->realizations);
+    }else if (strcmp(k, "block_width") == 0){
+        return parse_int(k, value, 0, &cfg->block_width);
+    }else if (strcmp(k, "chunk_width") == 0){
+        return parse_int(k, value, 0, &cfg->chunk_width);
+    }else if (strcmp(k, "pipeline") == 0){
+        return parse_bool(k, value, &cfg->pipeline);
+    }else if (strcmp(k, "threads") == 0){
+        return parse_int(k, value, 0, &cfg->threads);
+    }else if (strcmp(k, "target_errors") == 0){
+        return parse_count(k, value, &cfg->target_errors);
+    }else if (strcmp(k, "max_bits") == 0){
+        return parse_count(k, value, &cfg->max_bits);
+    }else if (strcmp(k, "frame_length") == 0){
+        return parse_int(k, value, 1, &cfg->frame_length);
+    }else if (strcmp(k, "confidence") == 0){
+        char *fim;
+        cfg->confidence = strtod(value, &fim);
+        if (fim == value || *fim != '\0' || !(cfg->confidence > 0 && cfg->confidence < 1)){
+            printf("Invalid value for 'confidence': %s (expected a level between 0 and 1)\n", value);
+            return -1;
+        }
+        return 0;
+    }else if (strcmp(k, "seed") == 0){
+        char *fim;
+        cfg->seed = strtoull(value, &fim, 0);
+        if (fim == value || *fim != '\0'){
+            printf("Invalid value for 'seed': %s\n", value);
+            return -1;
+        }
+        return 0;
+    }else if (strcmp(k, "input") == 0){
+        return set_path(cfg->input, sizeof(cfg->input), k, value);
+    }else if (strcmp(k, "output") == 0){
+        return set_path(cfg->output, sizeof(cfg->output), k, value);
+    }else if (strcmp(k, "tests_dir") == 0){
+        return set_path(cfg->tests_dir, sizeof(cfg->tests_dir), k, value);
+    }else if (strcmp(k, "write_files") == 0){
+        return parse_bool(k, value, &cfg->write_files);
+    }else if (strcmp(k, "write_llr") == 0){
+        return parse_bool(k, value, &cfg->write_llr);
+    }
+    printf("Unknown parameter '%s'\n", key);
+    return -1;
+}
+
+/** Removes the leading and trailing blanks of `s`, in place. */
+static char *trim(char *s){
+    while (isspace((unsigned char) *s)){
+        s++;
+    }
+    char *fim = s + strlen(s);
+    while (fim > s && isspace((unsigned char) fim[-1])){
+        fim--;
+    }
+    *fim = '\0';
+    return s;
+}
+
+/**
+ * @brief Reads a sweep specification from a configuration file.
+ *
+ * Each line holds one `key = value` pair, with the keys of `config_set`. Blank lines and
+ * everything after a `#` are ignored. Example:
+ *
+ *     antennas = 2x4,4x8,8x16
+ *     snr = 0:2:20
+ *     snr_type = ebn0
+ *     realizations = 100
+ *     input = message.txt
+ *     seed = 42
+ *
+ * @param cfg The specification, usually filled with `config_defaults` first.
+ * @param path The path of the configuration file.
+ *
+ * @return 0 on success, or -1 (after printing the file, line and reason) on the first error.
+ */
+int config_read_file(sim_config *cfg, const char *path){
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL){
+        printf("Unable to open the configuration file %s\n", path);
+        return -1;
+    }
+    char linha[8192];
+    int num = 0;
+    while (fgets(linha, sizeof(linha), fp) != NULL){
+        num++;
+        char *comentario = strchr(linha, '#');
+        if (comentario != NULL){
+            *comentario = '\0';
+        }
+        char *s = trim(linha);
+        if (*s == '\0'){
+            continue;
+        }
+        char *igual = strchr(s, '=');
+        if (igual == NULL){
+            printf("%s:%d: expected key = value\n", path, num);
+            fclose(fp);
+            return -1;
+        }
+        *igual = '\0';
+        if (config_set(cfg, trim(s), trim(igual + 1)) != 0){
+            printf("%s:%d: invalid line\n", path, num);
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * @brief Prints the command-line usage of the batch driver.
+ *
+ * @param program The name of the executable.
+ */
+void config_usage(const char *program){
+    printf("Usage: %s [options]\n"
+           "Runs a sweep without prompts. Without options, the interactive mode is started.\n\n"
+           "  -c, --config FILE        read the parameters from FILE (key = value lines)\n"
+           "  -a, --antennas LIST      antenna pairs, e.g. 2x4,4x8,32x16\n"
+           "  -s, --snr GRID           SNR grid in dB, values or start:step:stop ranges, e.g. 0:2:20,30\n"
+           "  -e, --snr-type TYPE      esn0 (default) or ebn0\n"
+           "  -m, --modulation M       order of the QAM constellation: 4 (default), 16, 64, 256 or 1024\n"
+           "  -H, --channel MODEL      real (default) Gaussian channels or complex rayleigh channels\n"
+           "  -r, --streams N          transmit on the N strongest eigenmodes only, 0 for all of them (default)\n"
+           "  -n, --realizations N     channel realizations per point (default 1)\n"
+           "  -i, --input FILE         file to be transmitted\n"
+           "  -o, --output FILE        CSV file the statistics are appended to (default output.csv)\n"
+           "  -d, --tests-dir DIR      directory of the received files (default: testes next to the executable)\n"
+           "  -w, --write-files BOOL   write the received files, yes (default) or no for statistics only\n"
+           "  -l, --write-llr BOOL     write the LLRs of the received bits as float32 (Test_*_llr), yes or no (default)\n"
+           "  -S, --seed N             seed of the random streams (default: from the clock)\n"
+           "  -b, --block-width N      columns per transmission block, 0 for the whole matrix\n"
+           "  -k, --chunk-width N      columns streamed through the link at once, 0 for the whole matrix (default 4096)\n"
+           "  -p, --pipeline BOOL      run the transmitter, channel and receiver of a test on their own threads, yes or no (default)\n"
+           "  -t, --threads N          worker threads, 0 for one per processor (default)\n"
+           "  -E, --target-errors N    Monte Carlo mode: simulate random frames until N bit errors per point\n"
+           "  -B, --max-bits N         Monte Carlo mode: bit budget per point (default 1e8)\n"
+           "  -L, --frame-length N     Monte Carlo mode: symbols per stream in a frame (default 256)\n"
+           "  -C, --confidence P       Monte Carlo mode: confidence level of the BER interval (default 0.95)\n"
+           "  -h, --help               show this help\n"
+           "Options given on the command line override the ones of the configuration file.\n",
+           program);
+}
+
+/**
+ * @brief Reads a sweep specification from the command line.
+ *
+ * The configuration file given with `--config` is read first, wherever it appears, and the other
+ * options override its values. See `config_usage` for the options.
+ *
+ * @param cfg The specification, usually filled with `config_defaults` first.
+ * @param argc The argument count of `main`.
+ * @param argv The arguments of `main`.
+ *
+ * @return 0 on success, 1 if the help was requested, or -1 (after printing the reason) on error.
+ */
+int config_read_args(sim_config *cfg, int argc, char *argv[]){
+    static const struct option opcoes[] = {
+        {"config", required_argument, NULL, 'c'},
+        {"antennas", required_argument, NULL, 'a'},
+        {"snr", required_argument, NULL, 's'},
+        {"snr-type", required_argument, NULL, 'e'},
+        {"modulation", required_argument, NULL, 'm'},
+        {"channel", required_argument, NULL, 'H'},
+        {"streams", required_argument, NULL, 'r'},
+        {"realizations", required_argument, NULL, 'n'},
+        {"input", required_argument, NULL, 'i'},
+        {"output", required_argument, NULL, 'o'},
+        {"tests-dir", required_argument, NULL, 'd'},
+        {"write-files", required_argument, NULL, 'w'},
+        {"write-llr", required_argument, NULL, 'l'},
+        {"seed", required_argument, NULL, 'S'},
+        {"block-width", required_argument, NULL, 'b'},
+        {"chunk-width", required_argument, NULL, 'k'},
+        {"pipeline", required_argument, NULL, 'p'},
+        {"threads", required_argument, NULL, 't'},
+        {"target-errors", required_argument, NULL, 'E'},
+        {"max-bits", required_argument, NULL, 'B'},
+        {"frame-length", required_argument, NULL, 'L'},
+        {"confidence", required_argument, NULL, 'C'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    const char *curtas = "c:a:s:e:m:H:r:n:i:o:d:w:l:S:b:k:p:t:E:B:L:C:h";
+    int c;
+
+    // First pass: only the configuration file, so the command line can override it
+    opterr = 0;
+    optind = 0;
+    while ((c = getopt_long(argc, argv, curtas, opcoes, NULL)) != -1){
+        if (c == 'c' && config_read_file(cfg, optarg) != 0){
+            return -1;
+        }
+    }
+
+    opterr = 1;
+    optind = 0;
+    while ((c = getopt_long(argc, argv, curtas, opcoes, NULL)) != -1){
+        const char *chave = NULL;
+        for (int i = 0; opcoes[i].name != NULL; i++){
+            if (opcoes[i].val == c){
+                chave = opcoes[i].name;
+            }
+        }
+        if (c == 'h'){
+            config_usage(argv[0]);
+            return 1;
+        }else if (c == '?' || chave == NULL){
+            config_usage(argv[0]);
+            return -1;
+        }else if (c != 'c' && config_set(cfg, chave, optarg) != 0){
+            return -1;
+        }
+    }
+    if (optind < argc){
+        printf("Unexpected argument '%s'\n", argv[optind]);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Checks that a sweep specification can be run.
+ *
+ * @param cfg The specification.
+ *
+ * @return 0 if it is complete and supported, or -1 after printing what is missing.
+ */
+int config_validate(const sim_config *cfg){
+    if (cfg->Nantennas == 0){
+        printf("No antenna pairs given (antennas)\n");
+        return -1;
+    }
+    if (cfg->Nsnr == 0){
+        printf("No SNR grid given (snr)\n");
+        return -1;
+    }
+    if (cfg->input[0] == '\0' && cfg->target_errors == 0){
+        printf("No input file given (input)\n");
+        return -1;
+    }
+    if (modulation_get(cfg->modulation) == NULL){
+        printf("Modulation %d-QAM is not supported: the orders are 4, 16, 64, 256 and 1024\n", cfg->modulation);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef PDS_CONFIG
+#define PDS_CONFIG
+
+#include <stdint.h>
+
+/** Largest number of antenna pairs in a sweep. */
+#define CONFIG_MAX_ANTENNAS 256
+/** Largest number of points in the SNR grid of a sweep. */
+#define CONFIG_MAX_SNR 1024
+
+/** How the SNR values of a sweep are given. */
+typedef enum snr_reference {
+    SNR_ESN0, ///< Energy per symbol to noise density ratio
+    SNR_EBN0  ///< Energy per bit to noise density ratio
+} snr_reference;
+
+/**
+ * @brief The specification of a batch sweep.
+ *
+ * Every antenna pair is simulated at every SNR of the grid, `realizations` times, each time with
+ * a new channel. Filled by `config_defaults` and then by `config_read_file` and `config_read_args`.
+ */
+typedef struct sim_config {
+    int Nantennas; ///< Number of antenna pairs
+    int Nr[CONFIG_MAX_ANTENNAS]; ///< Receiving antennas of each pair
+    int Nt[CONFIG_MAX_ANTENNAS]; ///< Transmitting antennas of each pair
+    int Nsnr; ///< Number of points in the SNR grid
+    double snr_dB[CONFIG_MAX_SNR]; ///< SNR grid, in dB
+    snr_reference reference; ///< Whether the grid is Es/N0 or Eb/N0
+    int modulation; ///< Order of the QAM constellation
+    int channel; ///< Channel model (`channel_model`): real Gaussian or complex Rayleigh
+    int streams; ///< Strongest eigenmodes of the channel used as streams (0 for all, min(Nr, Nt))
+    int realizations; ///< Channel realizations per point
+    uint64_t seed; ///< Seed of the random streams
+    int block_width; ///< Columns sent through the channel per block (0 for the whole matrix)
+    int chunk_width; ///< Columns of the stream matrix kept in memory at once (0 for the whole matrix)
+    int pipeline; ///< Whether the stages of each test run on threads of their own
+    int threads; ///< Worker threads (0 for one per processor)
+    long long target_errors; ///< Bit errors per Monte Carlo point (0 transmits the input file instead)
+    long long max_bits; ///< Bit budget per Monte Carlo point
+    int frame_length; ///< Symbols per stream in a Monte Carlo frame
+    double confidence; ///< Confidence level of the BER intervals
+    int write_files; ///< Whether the received files (`Test_*`) are written; 0 keeps only the statistics
+    int write_llr; ///< Whether the LLRs of the received bits (`Test_*_llr`) are written
+    char input[4096]; ///< File to be transmitted
+    char output[4096]; ///< CSV file the statistics are appended to
+    char tests_dir[4096]; ///< Directory of the received files (empty for the `testes` folder next to the executable)
+} sim_config;
+
+void config_defaults(sim_config *cfg);
+int config_read_file(sim_config *cfg, const char *path);
+int config_set(sim_config *cfg, const char *key, const char *value);
+int config_read_args(sim_config *cfg, int argc, char *argv[]);
+int config_validate(const sim_config *cfg);
+void config_usage(const char *program);
+
+#endif
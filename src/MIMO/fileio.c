@@ -0,0 +1,138 @@
+/// @file fileio.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../matrix/arena.h"
+#include "pds_telecom.h"
+#include "fileio.h"
+#ifdef __unix__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * @brief Opens a file to be transmitted.
+ *
+ * On Unix systems the file is memory-mapped read-only, so the pages are read by the kernel as the
+ * tests go through them and are shared by all the tests and threads of a run. Elsewhere, or if the
+ * mapping fails, the file is read into memory once with `tx_data_read`.
+ *
+ * @param in The input, filled by this function.
+ * @param filename The path of the file.
+ *
+ * @return 0 on success, or -1 (after printing the reason) if the file cannot be read.
+ */
+int tx_input_open(tx_input *in, const char *filename){
+    static const uint8_t vazio[1] = {0};
+    in->dados = vazio;
+    in->numBytes = 0;
+    in->mapa = NULL;
+    in->copia = NULL;
+#ifdef __unix__
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0){
+        printf("Unable to open the file %s\n", filename);
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0){
+        void *mapa = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapa != MAP_FAILED){
+            madvise(mapa, info.st_size, MADV_SEQUENTIAL);
+            in->mapa = mapa;
+            in->dados = mapa;
+            in->numBytes = info.st_size;
+            close(fd);
+            return 0;
+        }
+    }
+    close(fd);
+#endif
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL){
+        printf("Unable to open the file %s\n", filename);
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long int numBytes = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (numBytes > 0){
+        // The copy outlives the arenas of the tests, so it comes from the heap
+        arena *anterior = arena_usar(NULL);
+        in->copia = tx_data_read(fp, numBytes);
+        arena_usar(anterior);
+        if (in->copia == NULL){
+            fclose(fp);
+            return -1;
+        }
+        in->dados = in->copia;
+        in->numBytes = numBytes;
+    }
+    fclose(fp);
+    return 0;
+}
+
+/** Releases a file opened with `tx_input_open`. */
+void tx_input_close(tx_input *in){
+#ifdef __unix__
+    if (in->mapa != NULL){
+        munmap(in->mapa, in->numBytes);
+    }
+#endif
+    arena_free(in->copia);
+    in->mapa = NULL;
+    in->copia = NULL;
+    in->numBytes = 0;
+}
+
+/**
+ * @brief Creates a received file, to be written through a buffer of FILEIO_BUFFER bytes.
+ *
+ * @param out The output, filled by this function.
+ * @param fileName The path of the file.
+ *
+ * @return 0 on success, or -1 (after printing the reason) if the file cannot be created.
+ */
+int rx_output_open(rx_output *out, const char *fileName){
+    out->fp = fopen(fileName, "wb");
+    if (out->fp == NULL){
+        printf("Error opening file %s for writing.\n", fileName);
+        return -1;
+    }
+    out->buffer = malloc(FILEIO_BUFFER);
+    if (out->buffer != NULL){
+        setvbuf(out->fp, out->buffer, _IOFBF, FILEIO_BUFFER);
+    }
+    return 0;
+}
+
+/**
+ * @brief Appends bytes to a received file.
+ *
+ * @return 0 on success, or -1 if the bytes could not be written.
+ */
+int rx_output_write(rx_output *out, const uint8_t *dados, long int numBytes){
+    if (numBytes > 0 && fwrite(dados, 1, numBytes, out->fp) != (size_t) numBytes){
+        printf("Error writing the received file\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Flushes and closes a received file.
+ *
+ * @return 0 on success, or -1 if the buffered bytes could not be written.
+ */
+int rx_output_close(rx_output *out){
+    int ret = fclose(out->fp) == 0 ? 0 : -1;
+    if (ret != 0){
+        printf("Error writing the received file\n");
+    }
+    free(out->buffer);
+    out->fp = NULL;
+    out->buffer = NULL;
+    return ret;
+}
@@ -0,0 +1,40 @@
+#ifndef PDS_FILEIO
+#define PDS_FILEIO
+
+#include <stdio.h>
+#include <stdint.h>
+
+/** Size of the write buffer of a received file, in bytes. */
+#ifndef FILEIO_BUFFER
+#define FILEIO_BUFFER (1 << 20)
+#endif
+
+/**
+ * @brief A file to be transmitted, opened once and shared read-only by every test.
+ *
+ * The bytes of the file are the packed payload of `tx_qam_mapper`, so the tests map them straight
+ * from `dados`, without a copy of their own.
+ */
+typedef struct tx_input {
+    const uint8_t *dados; ///< Bytes of the file
+    long int numBytes; ///< Size of the file
+    void *mapa; ///< Memory mapping of the file, or NULL when it was read into memory
+    uint8_t *copia; ///< Heap copy of the file when it could not be mapped, or NULL
+} tx_input;
+
+/**
+ * @brief A received file, written through a large buffer.
+ */
+typedef struct rx_output {
+    FILE *fp; ///< The file
+    char *buffer; ///< Write buffer of FILEIO_BUFFER bytes
+} rx_output;
+
+int tx_input_open(tx_input *in, const char *filename);
+void tx_input_close(tx_input *in);
+
+int rx_output_open(rx_output *out, const char *fileName);
+int rx_output_write(rx_output *out, const uint8_t *dados, long int numBytes);
+int rx_output_close(rx_output *out);
+
+#endif
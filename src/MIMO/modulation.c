@@ -0,0 +1,329 @@
+/// @file modulation.c
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "../matrix/simd.h"
+#include "modulation.h"
+
+/** Number of supported orders: 4, 16, 64, 256 and 1024-QAM, with 2, 4, 6, 8 and 10 bits per symbol. */
+#define MOD_ORDENS (MOD_MAX_BITS / 2)
+
+/** The constellation of each order, indexed by bits/2 - 1. */
+static modulacao tabelas[MOD_ORDENS];
+static pthread_once_t tabelas_criadas = PTHREAD_ONCE_INIT;
+
+/** Gray code of j. */
+static unsigned gray(unsigned j){
+    return j ^ (j >> 1);
+}
+
+/** Builds the Gray-coded PAM of one axis, with the codes given by level. */
+static void eixo_criar(mod_eixo *e, int niveis, int invertido){
+    for (int j = 0; j < niveis; j++){
+        // The imaginary axis runs the other way, so 4-QAM keeps the points of the original mapper
+        e->codigo[j] = (uint16_t) gray(invertido ? niveis - 1 - j : j);
+    }
+}
+
+/** Builds the constellation with `bits` bits per symbol. */
+static void tabela_criar(modulacao *mod, int bits){
+    int m = bits / 2;
+    mod->M = 1 << bits;
+    mod->bits = bits;
+    mod->niveis = 1 << m;
+    // The levels +-1, +-3, ... of a square M-QAM have the average energy 2(M - 1)/3
+    mod->escala = sqrt(3.0 / (2.0 * (mod->M - 1)));
+    eixo_criar(&mod->eixo[0], mod->niveis, 0);
+    eixo_criar(&mod->eixo[1], mod->niveis, 1);
+    for (int j = 0; j < mod->niveis; j++){
+        for (int d = 0; d < mod->M; d++){
+            double nivel = mod->escala * (2 * j - mod->niveis + 1);
+            if (mod->eixo[0].codigo[j] == (d >> m)){
+                mod->pontos[d].real = nivel;
+            }
+            if (mod->eixo[1].codigo[j] == (d & (mod->niveis - 1))){
+                mod->pontos[d].img = nivel;
+            }
+        }
+    }
+    if (8 % bits == 0){
+        int por_byte = 8 / bits;
+        for (int b = 0; b < 256; b++){
+            for (int s = 0; s < por_byte; s++){
+                mod->bytes[b * por_byte + s] = mod->pontos[(b >> (s * bits)) & (mod->M - 1)];
+            }
+        }
+    }
+}
+
+static void tabelas_criar(void){
+    for (int i = 0; i < MOD_ORDENS; i++){
+        tabela_criar(&tabelas[i], 2 * (i + 1));
+    }
+}
+
+/**
+ * @brief Returns the constellation of order M.
+ *
+ * The tables of every order are built on the first call, once whatever the number of threads.
+ *
+ * @param M The order of the constellation: 4, 16, 64, 256 or 1024.
+ *
+ * @return The constellation, or NULL if the order is not supported.
+ */
+const modulacao *modulation_get(int M){
+    pthread_once(&tabelas_criadas, tabelas_criar);
+    for (int i = 0; i < MOD_ORDENS; i++){
+        if (tabelas[i].M == M){
+            return &tabelas[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Number of symbols needed to carry a message.
+ *
+ * When the bits of the message do not fill the last symbol, its missing bits are sent as zeros.
+ */
+long int modulation_symbols(const modulacao *mod, long int numBytes){
+    return (numBytes * 8 + mod->bits - 1) / mod->bits;
+}
+
+/*
+ * The kernels below are written once for any number of bits per symbol and inlined into a switch
+ * over the supported values, so each order gets its own code with the sizes, shifts and masks as
+ * constants: the bit reader of 4-QAM never looks at a second byte and 256-QAM reads one byte per symbol.
+ */
+#define MOD_ESPECIALIZADO static inline __attribute__((always_inline))
+
+/** Symbol i of a packed payload: bits [i*bits, (i+1)*bits), least significant bit first. */
+MOD_ESPECIALIZADO unsigned simbolo_ler(const uint8_t *dados, long int i, int bits){
+    long int bit = i * bits;
+    unsigned v = dados[bit >> 3] >> (bit & 7);
+    if ((bit & 7) + bits > 8){
+        v |= (unsigned) dados[(bit >> 3) + 1] << (8 - (bit & 7));
+    }
+    return v & ((1u << bits) - 1);
+}
+
+MOD_ESPECIALIZADO void map_ordem(const modulacao *mod, complexo *v, const uint8_t *dados, long int primeiro, long int salto, long int n, int bits){
+    long int j = 0;
+    if (8 % bits == 0 && salto == 1 && (primeiro * bits) % 8 == 0){
+        // Consecutive symbols from the start of a byte: the symbols of each whole byte are one row of the byte table
+        const int por_byte = 8 / bits;
+        const uint8_t *d = dados + primeiro * bits / 8;
+        for (; j + por_byte <= n; j += por_byte){
+            memcpy(&v[j], &mod->bytes[d[j / por_byte] * por_byte], por_byte * sizeof(complexo));
+        }
+    }
+    for (long int i = primeiro + j * salto; j < n; j++, i += salto){
+        v[j] = mod->pontos[simbolo_ler(dados, i, bits)];
+    }
+}
+
+/** Bits of the level of an axis nearest to y: the decision thresholds are halfway between the levels. */
+MOD_ESPECIALIZADO unsigned eixo_decidir(const mod_eixo *e, double y, double inverso, int niveis){
+    double u = fmin(fmax((y * inverso + niveis) * 0.5, 0), niveis - 1);
+    return e->codigo[(int) u];
+}
+
+MOD_ESPECIALIZADO void slice_ordem(const modulacao *mod, uint8_t *dados, const complexo *xf, long int ld, int Nstream, long int Ndados, int bits){
+    const int m = bits / 2, niveis = 1 << m;
+    const double inverso = 1.0 / mod->escala;
+    uint64_t acumulado = 0;
+    int Nbits = 0;
+    long int o = 0, c = 0;
+    int l = 0;
+    for (long int i = 0; i < Ndados; i++){
+        const complexo *y = &xf[l * ld + c];
+        unsigned d = (eixo_decidir(&mod->eixo[0], y->real, inverso, niveis) << m) | eixo_decidir(&mod->eixo[1], y->img, inverso, niveis);
+        acumulado |= (uint64_t) d << Nbits;
+        Nbits += bits;
+        while (Nbits >= 8){
+            dados[o++] = (uint8_t) acumulado;
+            acumulado >>= 8;
+            Nbits -= 8;
+        }
+        if (++l == Nstream){
+            l = 0;
+            c++;
+        }
+    }
+    if (Nbits > 0){
+        dados[o] = (uint8_t) acumulado;
+    }
+}
+
+/** Symbols per block of the LLR kernel. */
+#define MOD_LLR_BLOCO 64
+
+/**
+ * Max-log LLRs of the m bits of an axis for a block of n samples, bit b of sample i going to
+ * `llr[b*MOD_LLR_BLOCO + i]`. The nearest level j is the nearest point with its own value of every
+ * bit. Along a Gray-coded axis bit b keeps its value over runs of 2^(b+1) levels (2^b for the first
+ * one), with boundaries at the amplitudes 2^(b+1)(2t+1) - niveis, so the nearest point with the other
+ * value of the bit is the level one unit past the boundary nearest to the sample. Each bit is then a
+ * few arithmetic operations without branches or table lookups, which the compiler turns into vector
+ * code over the samples of the block.
+ */
+MOD_ESPECIALIZADO void eixo_llr(float *llr, const float *u, size_t n, float k, int m, int niveis, int invertido){
+    int nivel[MOD_LLR_BLOCO];
+    float d0[MOD_LLR_BLOCO];
+    for (size_t i = 0; i < n; i++){
+        int j = (int) ((u[i] + niveis) * 0.5f);
+        j = j > 0 ? j : 0;
+        j = j < niveis - 1 ? j : niveis - 1;
+        float dj = u[i] - (float) (2 * j - niveis + 1);
+        d0[i] = dj * dj;
+        // Index of the level in the Gray sequence of the axis
+        nivel[i] = invertido ? niveis - 1 - j : j;
+    }
+    for (int b = 0; b < m; b++){
+        const float periodo = (float) (4 << b), ultima = (float) ((niveis >> (b + 1)) - 1);
+        float *l = &llr[b * MOD_LLR_BLOCO];
+        for (size_t i = 0; i < n; i++){
+            // Nearest boundary t, clamped to the ones inside the axis
+            float t = (u[i] + niveis) / periodo;
+            t = t > 0 ? t : 0;
+            t = t < ultima ? t : ultima;
+            t = (float) (int) t;
+            float d1 = fabsf(u[i] - ((2 * t + 1) * (periodo * 0.5f) - niveis)) + 1;
+            float sinal = (float) (1 - 2 * (((nivel[i] + (1 << b)) >> (b + 1)) & 1));
+            l[i] = (d1 * d1 - d0[i]) * k * sinal;
+        }
+    }
+}
+
+MOD_ESPECIALIZADO void llr_ordem(const modulacao *mod, float *llr, size_t passo, const complexo *a, double variancia, size_t n, int bits){
+    const int m = bits / 2, niveis = 1 << m;
+    const double inverso = 1.0 / mod->escala;
+    // The distances are in units of escala
+    const float k = (float) (mod->escala * mod->escala / variancia);
+    float re[MOD_LLR_BLOCO], im[MOD_LLR_BLOCO];
+    float l_re[MOD_MAX_BITS / 2 * MOD_LLR_BLOCO], l_im[MOD_MAX_BITS / 2 * MOD_LLR_BLOCO];
+    for (size_t i0 = 0; i0 < n; i0 += MOD_LLR_BLOCO){
+        size_t nb = n - i0 < MOD_LLR_BLOCO ? n - i0 : MOD_LLR_BLOCO;
+        for (size_t i = 0; i < nb; i++){
+            re[i] = (float) (a[i0 + i].real * inverso);
+            im[i] = (float) (a[i0 + i].img * inverso);
+        }
+        eixo_llr(l_re, re, nb, k, m, niveis, 0);
+        eixo_llr(l_im, im, nb, k, m, niveis, 1);
+        for (size_t i = 0; i < nb; i++){
+            float *o = &llr[(i0 + i) * passo];
+            for (int b = 0; b < m; b++){
+                o[b] = l_im[b * MOD_LLR_BLOCO + i];
+                o[m + b] = l_re[b * MOD_LLR_BLOCO + i];
+            }
+        }
+    }
+}
+
+MOD_ESPECIALIZADO void llr_qam(const modulacao *mod, float *llr, size_t passo, const complexo *a, double variancia, size_t n){
+    switch (mod->bits){
+    case 4: llr_ordem(mod, llr, passo, a, variancia, n, 4); break;
+    case 6: llr_ordem(mod, llr, passo, a, variancia, n, 6); break;
+    case 8: llr_ordem(mod, llr, passo, a, variancia, n, 8); break;
+    default: llr_ordem(mod, llr, passo, a, variancia, n, 10); break;
+    }
+}
+
+/** LLRs of the higher orders compiled for the SSE2 baseline. */
+static void llr_qam_sse2(const modulacao *mod, float *llr, size_t passo, const complexo *a, double variancia, size_t n){
+    llr_qam(mod, llr, passo, a, variancia, n);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/** LLRs of the higher orders compiled for AVX2 + FMA, eight samples per instruction. */
+__attribute__((target("avx2,fma"))) static void llr_qam_avx2(const modulacao *mod, float *llr, size_t passo, const complexo *a, double variancia, size_t n){
+    llr_qam(mod, llr, passo, a, variancia, n);
+}
+
+/** LLRs of the higher orders compiled for AVX-512F, sixteen samples per instruction. */
+__attribute__((target("avx512f"))) static void llr_qam_avx512(const modulacao *mod, float *llr, size_t passo, const complexo *a, double variancia, size_t n){
+    llr_qam(mod, llr, passo, a, variancia, n);
+}
+#endif
+
+/**
+ * @brief Maps symbols of a packed payload to the points of a constellation.
+ *
+ * Point j of `v` is symbol `primeiro + j*salto` of the payload, so a row of the stream matrix is
+ * mapped with `primeiro` = row and `salto` = Nstream, and a plain sequence with `salto` = 1. When
+ * the symbols are consecutive and fill whole bytes (4, 16 and 256-QAM), each byte is copied from
+ * the byte table.
+ *
+ * @param mod The constellation.
+ * @param v The destination of the n points.
+ * @param dados The packed payload.
+ * @param primeiro The first symbol to be mapped.
+ * @param salto The distance between the symbols to be mapped.
+ * @param n The number of symbols to be mapped.
+ */
+void modulation_map(const modulacao *mod, complexo *v, const uint8_t *dados, long int primeiro, long int salto, long int n){
+    switch (mod->bits){
+    case 2: map_ordem(mod, v, dados, primeiro, salto, n, 2); break;
+    case 4: map_ordem(mod, v, dados, primeiro, salto, n, 4); break;
+    case 6: map_ordem(mod, v, dados, primeiro, salto, n, 6); break;
+    case 8: map_ordem(mod, v, dados, primeiro, salto, n, 8); break;
+    default: map_ordem(mod, v, dados, primeiro, salto, n, 10); break;
+    }
+}
+
+/**
+ * @brief Decides the symbols of a stream matrix and packs their bits in message order.
+ *
+ * Each axis is decided on its own, against thresholds halfway between its levels, which for a
+ * square constellation is the nearest point. Symbol i of the message is read from row i % Nstream
+ * and column i / Nstream, as in `rx_layer_demapper`, and its bits are appended to the payload, so
+ * the layer demapping needs no copy.
+ *
+ * @param mod The constellation.
+ * @param dados The packed payload, with room for Ndados symbols. It is written in whole bytes.
+ * @param xf The equalized stream matrix, element (l, c) at `xf[l*ld + c]`.
+ * @param ld The distance between the rows of `xf`.
+ * @param Nstream The number of streams.
+ * @param Ndados The number of symbols to decide.
+ */
+void modulation_slice(const modulacao *mod, uint8_t *dados, const complexo *xf, long int ld, int Nstream, long int Ndados){
+    switch (mod->bits){
+    case 2: slice_ordem(mod, dados, xf, ld, Nstream, Ndados, 2); break;
+    case 4: slice_ordem(mod, dados, xf, ld, Nstream, Ndados, 4); break;
+    case 6: slice_ordem(mod, dados, xf, ld, Nstream, Ndados, 6); break;
+    case 8: slice_ordem(mod, dados, xf, ld, Nstream, Ndados, 8); break;
+    default: slice_ordem(mod, dados, xf, ld, Nstream, Ndados, 10); break;
+    }
+}
+
+/**
+ * @brief Computes the log-likelihood ratios ln(P(0)/P(1)) of the bits of a vector of received symbols.
+ *
+ * Bit b of symbol i goes to `llr[i*passo + b]`, in the bit order of the payload. For 4-QAM each bit
+ * is a BPSK on one axis, whose max-log and exact LLRs are the same linear function of the sample,
+ * computed by the `cvec_llr_qpsk` kernel. For the higher orders the LLRs are max-log, from the
+ * nearest point with each value of the bit, computed in closed form over blocks of symbols.
+ *
+ * @param mod The constellation.
+ * @param llr The destination of the LLRs.
+ * @param passo The distance between the LLRs of consecutive symbols (at least `bits`).
+ * @param a The received symbols.
+ * @param variancia The variance of the complex noise of the symbols, half of it on each axis.
+ * @param n The number of symbols.
+ */
+void modulation_llr(const modulacao *mod, float *llr, size_t passo, const complexo *a, double variancia, size_t n){
+    if (mod->bits == 2){
+        cvec_llr_qpsk(llr, passo, a, 4.0 * mod->escala / variancia, n);
+        return;
+    }
+    // The kernel of the higher orders is plain C, compiled for each instruction set like the micro-kernel of gemm.c
+    switch (simd_get_nivel()){
+#if defined(__x86_64__) || defined(__i386__)
+    case SIMD_AVX512: llr_qam_avx512(mod, llr, passo, a, variancia, n); break;
+    case SIMD_AVX2: llr_qam_avx2(mod, llr, passo, a, variancia, n); break;
+#endif
+    default: llr_qam_sse2(mod, llr, passo, a, variancia, n); break;
+    }
+}
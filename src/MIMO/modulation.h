@@ -0,0 +1,52 @@
+#ifndef PDS_MODULATION
+#define PDS_MODULATION
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../matrix/matrix.h"
+
+/** Largest number of bits per symbol of a constellation (1024-QAM). */
+#define MOD_MAX_BITS 10
+/** Largest number of amplitude levels on each axis of a constellation. */
+#define MOD_MAX_NIVEIS (1 << (MOD_MAX_BITS / 2))
+
+/** Number of bytes of the packed payload that holds `n` symbols of `bits` bits. */
+#define PAYLOAD_BYTES(n, bits) (((n) * (bits) + 7) / 8)
+
+/**
+ * @brief One axis of a square QAM constellation: a Gray-coded PAM.
+ *
+ * The levels are numbered in increasing amplitude, level j being `escala * (2j - niveis + 1)`.
+ */
+typedef struct mod_eixo {
+    uint16_t codigo[MOD_MAX_NIVEIS]; ///< Bits of the axis carried by level j; neighbouring levels differ in one bit
+} mod_eixo;
+
+/**
+ * @brief A square Gray-coded QAM constellation with unit average energy.
+ *
+ * A symbol is a group of `bits` consecutive bits of the packed payload, least significant bit
+ * first. Its high half selects the level of the real axis and its low half the level of the
+ * imaginary axis, so every axis is a Gray-coded PAM and the points next to each other differ in a
+ * single bit. For 4-QAM this gives the mapping of `tx_qam_mapper`: 0 -> (-a, a), 1 -> (-a, -a),
+ * 2 -> (a, a) and 3 -> (a, -a), with a = 1/sqrt(2).
+ *
+ * The tables are built once, the first time `modulation_get` is called, and only read afterwards.
+ */
+typedef struct modulacao {
+    int M; ///< Order of the constellation (4, 16, 64, 256 or 1024)
+    int bits; ///< Bits per symbol, log2(M)
+    int niveis; ///< Amplitude levels per axis, sqrt(M)
+    double escala; ///< Half the distance between neighbouring levels, which gives the constellation unit average energy
+    _Alignas(64) complexo pontos[1 << MOD_MAX_BITS]; ///< Point of each symbol
+    _Alignas(64) complexo bytes[256 * 4]; ///< Points of the 8/bits symbols of each payload byte, in symbol order, when `bits` divides 8
+    mod_eixo eixo[2]; ///< The real [0] and imaginary [1] axes
+} modulacao;
+
+const modulacao *modulation_get(int M);
+long int modulation_symbols(const modulacao *mod, long int numBytes);
+void modulation_map(const modulacao *mod, complexo *v, const uint8_t *dados, long int primeiro, long int salto, long int n);
+void modulation_slice(const modulacao *mod, uint8_t *dados, const complexo *xf, long int ld, int Nstream, long int Ndados);
+void modulation_llr(const modulacao *mod, float *llr, size_t passo, const complexo *a, double variancia, size_t n);
+
+#endif
@@ -0,0 +1,180 @@
+/// @file montecarlo.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <gsl/gsl_cdf.h>
+#include "../matrix/matrix.h"
+#include "../matrix/arena.h"
+#include "pds_telecom.h"
+#include "montecarlo.h"
+
+/**
+ * @brief Computes the Wilson score interval of an error rate.
+ *
+ * Unlike the normal approximation, the Wilson interval stays inside [0, 1] and is meaningful with
+ * few or no errors, which is the usual situation at the high-SNR end of a BER curve.
+ *
+ * @param errors The number of errors observed.
+ * @param trials The number of trials (bits).
+ * @param confidence The confidence level, e.g. 0.95.
+ * @param low The lower bound of the interval.
+ * @param high The upper bound of the interval.
+ */
+void mc_confidence_interval(long long errors, long long trials, double confidence, double *low, double *high){
+    if (trials <= 0){
+        *low = 0;
+        *high = 1;
+        return;
+    }
+    double z = gsl_cdf_ugaussian_Pinv(0.5 + confidence / 2);
+    double n = (double) trials;
+    double p = errors / n;
+    double z2n = z * z / n;
+    double centro = (p + z2n / 2) / (1 + z2n);
+    double meia = z / (1 + z2n) * sqrt(p * (1 - p) / n + z2n / (4 * n));
+    *low = centro - meia > 0 ? centro - meia : 0;
+    *high = centro + meia < 1 ? centro + meia : 1;
+}
+
+/** Fills the packed payload `dados` (`Nbytes` bytes) with random bits, 16 bytes per block of the generator. */
+static void random_payload(rng_fluxo *f, uint8_t *dados, long int Nbytes){
+    uint32_t b[4];
+    for (long int i = 0; i < Nbytes; i += 16){
+        rng_bloco(f, b);
+        for (int j = 0; j < 16 && i + j < Nbytes; j++){
+            dados[i + j] = (uint8_t) (b[j >> 2] >> ((j & 3) * 8));
+        }
+    }
+}
+
+/**
+ * @brief Estimates the BER of one sweep point by Monte Carlo simulation with early termination.
+ *
+ * Each frame carries `frame_length` random symbols per stream, goes through a new channel
+ * realization and through the same transmitter, channel and receiver stages as a file test, and
+ * its bit and symbol errors are counted. Frames are simulated until the stopping rule of `mc` is
+ * met, so the work spent on a point follows the number of errors it needs rather than the size
+ * of a message: high-BER points stop after a few frames and low-BER points run until they have
+ * enough errors or exhaust the bit budget.
+ *
+ * Frame f draws its payload, channel and noise from the substream f of `fluxo`, so a point is
+ * reproducible from its stream alone. The errors of each frame are counted in its own accumulator
+ * (`stats_add_symbols`), which is then merged into the accumulator of the point. The symbols are
+ * decided as in a file test: from the sign bits of the FEQ for 4-QAM (`rx_qam_slicer_into`) and
+ * by the constellation of `mc->modulation` otherwise (`rx_qam_layer_demapper_into`).
+ *
+ * @param Nr The number of receiving antennas.
+ * @param Nt The number of transmitting antennas.
+ * @param EsN0_dB The Es/N0 of the noise stage, in dB.
+ * @param mc The stopping rule, frame size, modulation, channel model and number of streams.
+ * @param fluxo The random stream of the point.
+ * @param res The result, filled by this function (except `teste`, left to the caller).
+ */
+void mc_ber_point(int Nr, int Nt, double EsN0_dB, const mc_config *mc, const rng_fluxo *fluxo, ber_point *res){
+    int Nstream = channel_streams(Nr, Nt, mc->streams);
+    int L = mc->frame_length > 0 ? mc->frame_length : TX_BLOCK_WIDTH;
+    long int Nsymbol = (long int) Nstream * L;
+    const modulacao *mod = modulation_get(mc->modulation);
+
+    res->Nr = Nr;
+    res->Nt = Nt;
+    res->EsN0_dB = EsN0_dB;
+    res->frames = 0;
+    res->bits = 0;
+    res->bit_errors = 0;
+
+    // The buffers of a frame are reused by every frame of the point
+    long int Nbytes = PAYLOAD_BYTES(Nsymbol, mod->bits);
+    uint8_t *s = (uint8_t *) arena_malloc(Nbytes);
+    uint8_t *finals = (uint8_t *) arena_malloc(Nbytes);
+    cmatrix tx = cmatrix_alloc(Nstream, L);
+    cmatrix rx = cmatrix_alloc(Nstream, L);
+    uint8_t *sinais = mod->bits == 2 ? (uint8_t *) arena_malloc((size_t) Nstream * rx.ld) : NULL;
+    stats_acc ponto, quadro_acc;
+    stats_init(&ponto, Nstream, mod->bits);
+    stats_init(&quadro_acc, Nstream, mod->bits);
+    arena *a = arena_ativa();
+
+    while (res->frames < mc->min_frames || (res->bit_errors < mc->target_errors && res->bits < mc->max_bits)){
+        rng_fluxo quadro = rng_subfluxo(fluxo, res->frames);
+        rng_fluxo *anterior = rng_usar(&quadro);
+        // The channel of the frame is released by rewinding the active arena
+        arena_marca marca = {NULL, 0};
+        if (a != NULL){
+            marca = arena_marcar(a);
+        }
+
+        random_payload(&quadro, s, Nbytes);
+        tx_qam_layer_mapper_into(mod, tx.rows, s, Nsymbol, Nsymbol, Nstream);
+        complexo **H = channel_draw((channel_model) mc->channel, Nr, Nt);
+        channel_context *ctx = channel_context_create(H, Nr, Nt, Nstream);
+        channel_context_transmit_into(ctx, &tx, &rx, sinais, EsN0_dB);
+        channel_context_free(ctx);
+        LiberarMatriz(H, Nr);
+        if (sinais != NULL){
+            rx_qam_slicer_into(finals, sinais, rx.ld, Nstream, Nsymbol);
+        }else{
+            rx_qam_layer_demapper_into(mod, finals, &rx, Nsymbol);
+        }
+
+        stats_reset(&quadro_acc);
+        stats_add_symbols(&quadro_acc, s, finals, Nsymbol, 0);
+        stats_merge(&ponto, &quadro_acc);
+        stats_stream total = stats_total(&ponto);
+        res->bit_errors = total.bit_errors;
+        res->bits = total.symbols * mod->bits;
+        res->frames++;
+
+        if (a != NULL){
+            arena_voltar(a, marca);
+        }
+        rng_usar(anterior);
+    }
+
+    stats_stream total = stats_total(&ponto);
+    res->symbols = total.symbols;
+    res->symbol_errors = total.symbol_errors;
+    stats_free(&quadro_acc);
+    stats_free(&ponto);
+    cmatrix_free(&tx);
+    cmatrix_free(&rx);
+    arena_free(s);
+    arena_free(finals);
+    arena_free(sinais);
+
+    res->ber = (double) res->bit_errors / res->bits;
+    mc_confidence_interval(res->bit_errors, res->bits, mc->confidence, &res->ber_low, &res->ber_high);
+}
+
+/**
+ * @brief Appends a Monte Carlo BER point to a CSV file.
+ *
+ * The CSV file contains the following columns:
+ * 1. `test`: The point number.
+ * 2. `Nr`: The number of receive antennas.
+ * 3. `Nt`: The number of transmit antennas.
+ * 4. `esn0_dB`: The Es/N0 of the noise stage, in decibels.
+ * 5. `frames`: The number of frames (channel realizations) simulated.
+ * 6. `bits`: The number of bits sent.
+ * 7. `bit_errors`: The number of bits received with errors.
+ * 8. `ber`: The Bit Error Rate.
+ * 9. `ber_low`, 10. `ber_high`: The confidence interval of the BER.
+ * 11. `ser`: The Symbol Error Rate.
+ *
+ * @param csv The path of the CSV file. It is created if it does not exist.
+ * @param p The point.
+ *
+ * @return 0 on success, or -1 if the file could not be opened.
+ */
+int mc_write_point(const char *csv, const ber_point *p){
+    FILE *file = fopen(csv, "a");
+    if (file == NULL){
+        printf("Could not open the file\n");
+        return -1;
+    }
+    fprintf(file, "%d,%d,%d,%f,%lld,%lld,%lld,%e,%e,%e,%e\n", p->teste, p->Nr, p->Nt, p->EsN0_dB, p->frames, p->bits, p->bit_errors,
+            p->ber, p->ber_low, p->ber_high, (double) p->symbol_errors / p->symbols);
+    fclose(file);
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef PDS_MONTECARLO
+#define PDS_MONTECARLO
+
+#include "../matrix/rng.h"
+
+/**
+ * @brief The stopping rule of a Monte Carlo BER point.
+ *
+ * Frames are simulated until `target_errors` bit errors are seen or `max_bits` bits are sent,
+ * but never fewer than `min_frames` frames.
+ */
+typedef struct mc_config {
+    long long target_errors; ///< Bit errors after which the point stops
+    long long max_bits; ///< Bit budget of the point
+    int min_frames; ///< Minimum number of frames (channel realizations)
+    int frame_length; ///< Columns of the stream matrix per frame (symbols per stream)
+    double confidence; ///< Confidence level of the BER interval, e.g. 0.95
+    int modulation; ///< Order of the QAM constellation
+    int channel; ///< Channel model (`channel_model`)
+    int streams; ///< Eigenmodes used by the link (`channel_streams`), 0 for all of them
+} mc_config;
+
+/**
+ * @brief The result of a Monte Carlo BER point.
+ */
+typedef struct ber_point {
+    int teste; ///< Point number
+    int Nr; ///< Number of receiving antennas
+    int Nt; ///< Number of transmitting antennas
+    double EsN0_dB; ///< Es/N0 of the noise stage, in dB
+    long long frames; ///< Frames simulated, each with its own channel realization
+    long long bits; ///< Bits sent
+    long long bit_errors; ///< Bits received with errors
+    long long symbols; ///< Symbols sent
+    long long symbol_errors; ///< Symbols received with errors
+    double ber; ///< Bit error rate
+    double ber_low; ///< Lower bound of the confidence interval of the BER
+    double ber_high; ///< Upper bound of the confidence interval of the BER
+} ber_point;
+
+void mc_confidence_interval(long long errors, long long trials, double confidence, double *low, double *high);
+void mc_ber_point(int Nr, int Nt, double EsN0_dB, const mc_config *mc, const rng_fluxo *fluxo, ber_point *res);
+int mc_write_point(const char *csv, const ber_point *p);
+
+#endif
@@ -3,15 +3,27 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "../matrix/matrix.h"
-#include <gsl/gsl_linalg.h>
-#include <gsl/gsl_rng.h>
-#include <gsl/gsl_randist.h>
+#include "../matrix/simd.h"
+#include "../matrix/gemm.h"
+#include "../matrix/arena.h"
+#include "../matrix/rng.h"
+#include "../matrix/blas.h"
+#include "../matrix/svd.h"
+#include "pds_telecom.h"
+#include "config.h"
+#include "scheduler.h"
+#include "montecarlo.h"
+#include "fileio.h"
+#include "pipeline.h"
 #include <time.h>
 #include <math.h>
+#include <limits.h>
 #include <string.h>
 #include <libgen.h> 
 #include <stdbool.h> 
 #include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 /**
  * @brief This function calculates the capacity of a communication channel.
@@ -34,31 +46,17 @@ double calculate_capacity(double snr_dB) {
  * A lower EVM means a better performance. In this function, the EVM is calculated 
  * by comparing the original transmitted signal with the received signal.
  * 
- * The function first calculates the power of the error signal and the power of the received signal.
- * Then, it calculates the EVM as the square root of the ratio of the error power to the signal power.
- * If the signal power is zero, the function returns infinity.
+ * The powers of the error signal and of the received signal are accumulated block by block during
+ * the transmission (`stats_add_signal`). The EVM is the square root of the ratio of the error power
+ * to the signal power. If the signal power is zero, the function returns infinity.
  * Finally, the EVM is converted to decibels (dB) before being returned.
  * 
- * @param original_signal A 2D array of complex numbers representing the original transmitted signal.
- * @param received_signal A 2D array of complex numbers representing the signal received after transmission.
- * @param Nstream The number of streams in the signal.
- * @param Nsymbol The total number of symbols in the signal.
+ * @param error_power The accumulated power of the difference between the transmitted and received signals.
+ * @param signal_power The accumulated power of the received signal.
  * @return The calculated EVM of the signal in dB. If the signal power is zero, returns infinity.
  */
 
-double calculate_EVM(complexo **original_signal, complexo **received_signal, int Nstream, long int Nsymbol) {
-    double error_power = 0.0;
-    double signal_power = 0.0;
-
-    for (int i = 0; i < Nstream; i++) {
-        for (int j = 0; j < Nsymbol/Nstream; j++) {
-            double real_diff = original_signal[i][j].real - received_signal[i][j].real;
-            double img_diff = original_signal[i][j].img - received_signal[i][j].img;
-            error_power += real_diff * real_diff + img_diff * img_diff;
-            signal_power += received_signal[i][j].real * received_signal[i][j].real + received_signal[i][j].img * received_signal[i][j].img;
-        }
-    }
-
+double calculate_EVM(double error_power, double signal_power) {
     if (signal_power == 0) {
         return INFINITY; // If there's no signal, return infinity
     } else {
@@ -75,30 +73,16 @@ double calculate_EVM(complexo **original_signal, complexo **received_signal, int
  * less affected by noise. In this function, the SNR is calculated by comparing the original 
  * transmitted signal with the received signal.
  * 
- * The function takes as input two 2D arrays of complex numbers representing the original and 
- * received signals, the number of streams in the signal, and the total number of symbols in the signal.
+ * The function takes as input the powers of the noise (the difference between the original and
+ * received signals) and of the received signal, accumulated block by block during the transmission.
  * 
  * The calculated SNR is returned in decibels (dB).
  * 
- * @param original_signal A 2D array of complex numbers representing the original transmitted signal.
- * @param received_signal A 2D array of complex numbers representing the signal received after transmission.
- * @param Nstream The number of streams in the signal.
- * @param Nsymbol The total number of symbols in the signal.
+ * @param noise_power The accumulated power of the difference between the transmitted and received signals.
+ * @param signal_power The accumulated power of the received signal.
  * @return The calculated SNR of the signal in dB.
  */
-double calculate_SNR(complexo **original_signal, complexo **received_signal, int Nstream, long int Nsymbol) {
-    double signal_power = 0.0;
-    double noise_power = 0.0;
-
-    for (int i = 0; i < Nstream; i++) {
-        for (int j = 0; j < Nsymbol/Nstream; j++) {
-            double real_diff = original_signal[i][j].real - received_signal[i][j].real;
-            double img_diff = original_signal[i][j].img - received_signal[i][j].img;
-            noise_power += real_diff * real_diff + img_diff * img_diff;
-            signal_power += received_signal[i][j].real * received_signal[i][j].real + received_signal[i][j].img * received_signal[i][j].img;
-        }
-    }
-
+double calculate_SNR(double noise_power, double signal_power) {
     if (noise_power == 0) {
         return INFINITY; // If there's no noise, return infinity
     } else {
@@ -107,104 +91,83 @@ double calculate_SNR(complexo **original_signal, complexo **received_signal, int
 }
 
 /**
- * @brief Get user input for the values of Nr, Nt, and r to custom mode.
+ * @brief Get user input for the values of Nr, Nt and the SNR to custom mode.
+ *
+ * The SNR can be given either as Es/N0 or as Eb/N0; it is returned as Es/N0.
  * 
  * @param Nr Pointer to an integer where the value for Nr will be stored.
  * @param Nt Pointer to an integer where the value for Nt will be stored.
- * @param r Pointer to an integer where the value for r will be stored.
+ * @param EsN0_dB Pointer to a double where the Es/N0, in dB, will be stored.
  */
-void getUserInput(int* Nr, int* Nt, int* r) {
+void getUserInput(int* Nr, int* Nt, double* EsN0_dB) {
+    int referencia;
+    double snr_dB;
     printf("Enter the value for Nr: ");
     scanf("%d", Nr);
 
     printf("Enter the value for Nt: ");
     scanf("%d", Nt);
 
-    printf("Enter the value for r:f ");
-    scanf("%d", r);
+    printf("Enter 1 to give the SNR as Es/N0 or 2 to give it as Eb/N0: ");
+    scanf("%d", &referencia);
+
+    printf("Enter the SNR in dB: ");
+    scanf("%lf", &snr_dB);
+
+    *EsN0_dB = (referencia == 2) ? snr_ebn0_to_esn0(snr_dB, modulation_get(TX_MODULATION)->bits) : snr_dB;
 }
 /**
- * @brief Reads data from a file and converts it into an array of integers.
+ * @brief Reads data from a file into a packed payload.
  *
- * This function reads binary data from a file and converts it into an array of integers.
- * Each integer in the array represents 2 bits of the original data. The conversion is done by reading
- * two bits at a time from the binary data and storing their combined value as an integer in the array.
+ * The bytes of the file are kept as they are: the symbols of a constellation with b bits per
+ * symbol are the consecutive groups of b bits of the file, least significant bit of each byte first
+ * (see `modulacao`). The mapper and demapper read and write these bits directly, so the payload
+ * takes one byte of memory per byte of the file whatever the order of the constellation.
  *
  * @param fp Pointer to the file to be read. The file should be opened in binary read mode before calling this function.
  * @param numBytes The number of bytes to be read from the file. This should be the size of the data that you want to convert.
- * @return A pointer to the integer array that contains the converted data, or NULL
+ * @return A pointer to the packed payload (numBytes bytes), or NULL
  *         in case of memory allocation error or if the file cannot be read.
  *
- * @note The caller is responsible for freeing the memory allocated for the integer array
- *       when it is no longer needed, using the free() function. The caller is also responsible for closing the file when it's no longer needed.
+ * @note The caller is responsible for freeing the memory allocated for the payload
+ *       when it is no longer needed, using the arena_free() function. The caller is also responsible for closing the file when it's no longer needed.
  */
-int * tx_data_read(FILE *fp, long int numBytes){
-    // Allocates memory for the integer array
-    int *s = (int *)malloc(numBytes * 4 * sizeof(int));
-    if (s == NULL) {
+uint8_t * tx_data_read(FILE *fp, long int numBytes){
+    // Allocates memory for the payload
+    uint8_t *dados = (uint8_t *)arena_malloc(numBytes > 0 ? numBytes : 1);
+    if (dados == NULL) {
         printf("Error in memory allocation\n");
-        fclose(fp);
-        return (int *)1;
+        return NULL;
     }
-    // Reads the bytes from the file and converts them into 2-bit integers
-    for (int i = 0; i < numBytes; i++) {
-        char byte;
-        fread(&byte, sizeof(byte), 1, fp);
-
-        for (int j = 0; j <= 7; j=j+2) {
-            int bit = (byte >> j) & 3;
-            s[(i*4) + (j/2)]= bit;
-        }
-        
+    if (fread(dados, 1, numBytes, fp) != (size_t) numBytes) {
+        printf("Error reading the file\n");
+        arena_free(dados);
+        return NULL;
     }
-    return s;
+    return dados;
 }
 
-/**
- * @brief Performs padding of the data with zeros.
- *
- * This function performs padding of the data with zeros to ensure
- * that the size of the integer array is an integer multiple of the number of streams (Nstream).
- * Padding is necessary when the number of bytes in the data is not a multiple of the number of streams.
- * In such cases, padding with zeros ensures that the data can be evenly divided among the streams.
- *
- * @param s Pointer to the integer array containing the data. This array should contain the binary representation of the data to be transmitted.
- * @param numBytes The original number of bytes in the data before padding. This is the size of the array pointed to by `s`.
- * @param Nstream The number of streams for which the array size should be a multiple. This represents the number of separate data streams that the data will be divided among.
- * @return A pointer to the integer array with the padding performed, or NULL
- *         in case of memory allocation error. The caller is responsible for freeing this memory when it is no longer needed.
- */
-int * tx_data_padding(int* s, long int numBytes, int Npadding){
-    // Checks if the number of bytes is a multiple of the number of streams.
-    if(Npadding == 0){
-        return s;
-    }
-    else{
-        // Memory allocation for the integer array with the necessary additional space.
-        int *resized_s = (int*) malloc((numBytes*4 + Npadding)*sizeof(int));
-        // Fills the additional space with nulls - represented by the integer 4 -.
-        for (long int i = 0; i < numBytes*4; i++)
-            resized_s[i] = s[i];
-        for(long int i = numBytes*4; i < ((numBytes*4) + Npadding); i++){
-            resized_s[i] = 4;
-        }
-        return resized_s;
-    }     
-}
+/** Sign bits of a received sample (bit 0: real part negative, bit 1: imaginary part negative). */
+#define QAM4_SINAIS(v) ((signbit((v).real) ? 1 : 0) | (signbit((v).img) ? 2 : 0))
+/** 2-bit symbol decided from the sign bits of a sample: the nearest point is the one in the same quadrant. */
+static const uint8_t qam4_decisao[4] = {2, 0, 3, 1};
 
 /**
- * @brief Maps binary data into a sequence of QAM symbols.
+ * @brief Maps a packed payload into a sequence of QAM symbols.
  *
  * This function maps binary data into a sequence of QAM (Quadrature
  * Amplitude Modulation) symbols represented by complex numbers. The function dynamically allocates
  * memory for the complex vector and returns a pointer to this vector.
  *
- * The mapping is as follows:
- * 0 -> (-1, 1)
- * 1 -> (-1, -1)
- * 2 -> (1, 1)
- * 3 -> (1, -1)
- * Any other value -> (0, 0)
+ * Each group of `mod->bits` bits of the payload is mapped to a point of the Gray-coded constellation
+ * `mod`, which has unit average energy (see `modulacao`). For 4-QAM, with a = 1/sqrt(2):
+ * 0 -> (-a, a)
+ * 1 -> (-a, -a)
+ * 2 -> (a, a)
+ * 3 -> (a, -a)
+ *
+ * The symbols from `Ndados` to `numQAM` are the padding that makes the number of symbols a
+ * multiple of the number of streams. They are null symbols (0, 0) and are not read from the payload.
  *
  * The `complexo` type is a struct with two members: `real` and `img`, representing the real and imaginary parts of a complex number.
  *
@@ -212,42 +175,77 @@ int * tx_data_padding(int* s, long int numBytes, int Npadding){
  *
  * The caller is also responsible for freeing the memory allocated by this function when it's no longer needed.
  *
- * @param s Pointer to the integer array containing the binary data.
- * @param numBytes The number of bytes contained in the integer array.
+ * @param mod The constellation.
+ * @param dados Pointer to the packed payload (see `tx_data_read`).
+ * @param Ndados The number of data symbols in the payload.
+ * @param numQAM The number of symbols to be produced, including the padding.
  * @return A pointer to the complex vector that contains the mapped QAM symbols, or NULL
  *         in case of memory allocation error.
  */
-complexo* tx_qam_mapper(int *s, long int numQAM){
+complexo* tx_qam_mapper(const modulacao *mod, const uint8_t *dados, long int Ndados, long int numQAM){
     // Allocates memory for the complex vector
-    complexo *c1 = (complexo *)malloc(numQAM * sizeof(complexo));   
+    complexo *c1 = (complexo *)arena_malloc(numQAM * sizeof(complexo));   
     if (c1 == NULL) {
         printf("Error in memory allocation\n");
         return NULL;
     }
-    for(int i= 0; i<numQAM;i++){
-        switch(s[i]){
-            case 0:
-                c1[i].real = -1;
-                c1[i].img = 1;
-                break;
-            case 1:
-                c1[i].real = -1;
-                c1[i].img = -1;
-                break;
-            case 2:
-                c1[i].real = 1;
-                c1[i].img = 1;
-                break;
-            case 3:
-                c1[i].real = 1;
-                c1[i].img = -1;
-                break;
-            default:
-                c1[i].real = 0;
-                c1[i].img = 0;
+    tx_qam_mapper_into(mod, c1, dados, Ndados, numQAM);
+    return c1;
+}
+/**
+ * @brief Maps a packed payload into QAM symbols stored in a caller-provided vector.
+ *
+ * Same mapping as `tx_qam_mapper`, without allocating. With 4, 16 and 256-QAM each whole byte of
+ * the payload is mapped by copying its symbols from a 256-entry table, which the compiler turns
+ * into vector loads and stores, so the mapping is bound by the memory traffic of the output
+ * rather than by a decision per symbol (see `modulation_map`).
+ *
+ * @param mod The constellation.
+ * @param c1 The destination vector, with room for numQAM symbols.
+ * @param dados Pointer to the packed payload.
+ * @param Ndados The number of data symbols in the payload.
+ * @param numQAM The number of symbols to be mapped, including the null padding symbols.
+ */
+void tx_qam_mapper_into(const modulacao *mod, complexo *c1, const uint8_t *dados, long int Ndados, long int numQAM){
+    modulation_map(mod, c1, dados, 0, 1, Ndados);
+    // Null padding symbols
+    if (numQAM > Ndados){
+        memset(&c1[Ndados], 0, (numQAM - Ndados) * sizeof(complexo));
+    }
+}
+/**
+ * @brief Maps a packed payload straight into the stream matrix (QAM mapping and layer mapping in one pass).
+ *
+ * Symbol i of the payload goes to row i % Nstream, column i / Nstream, as with `tx_qam_mapper`
+ * followed by `tx_layer_mapper`, but without the intermediate vector. Each row is filled in
+ * order, so the writes, which are most of the traffic (16 bytes per symbol read), are sequential.
+ * With a single stream the row is the mapped vector itself and is filled from the byte table.
+ *
+ * @param mod The constellation.
+ * @param mtx_stream The stream matrix (Nstream x Nsymbol/Nstream).
+ * @param dados Pointer to the packed payload.
+ * @param Ndados The number of data symbols in the payload.
+ * @param Nsymbol The number of symbols to be mapped, including the null padding symbols.
+ * @param Nstream The number of streams.
+ */
+void tx_qam_layer_mapper_into(const modulacao *mod, complexo **mtx_stream, const uint8_t *dados, long int Ndados, long int Nsymbol, int Nstream){
+    if (Nstream == 1){
+        tx_qam_mapper_into(mod, mtx_stream[0], dados, Ndados, Nsymbol);
+        return;
+    }
+    long int Ncolunas = Nsymbol / Nstream;
+    for (int l = 0; l < Nstream; l++){
+        complexo *linha = mtx_stream[l];
+        // Columns of the row that hold data symbols; the rest are padding
+        long int Nj = (Ndados > l) ? (Ndados - l + Nstream - 1) / Nstream : 0;
+        if (Nj > Ncolunas){
+            Nj = Ncolunas;
+        }
+        modulation_map(mod, linha, dados, l, Nstream, Nj);
+        if (Ncolunas > Nj){
+            memset(&linha[Nj], 0, (Ncolunas - Nj) * sizeof(complexo));
         }
     }
-    return c1;
 }
 /**
  * @brief Maps data from a complex vector to a complex matrix.
@@ -264,18 +262,21 @@ complexo* tx_qam_mapper(int *s, long int numQAM){
  */
 
 complexo ** tx_layer_mapper(complexo *v, int Nstream, long int Nsymbol){
-    // Allocates memory for the complex matrix
-    complexo **mtx_stream;
-    mtx_stream = (complexo**) malloc(Nstream*sizeof(complexo*));
-
-    for(int i = 0; i < Nstream; i++){
-        mtx_stream[i] = (complexo *) malloc((Nsymbol/Nstream)*sizeof(complexo));
-    }
+    // Allocates memory for the complex matrix in a single contiguous block
+    complexo **mtx_stream = allocateComplexMatrix(Nstream, Nsymbol/Nstream);
+    tx_layer_mapper_into(mtx_stream, v, Nstream, Nsymbol);
+    return mtx_stream;
+}
+/**
+ * @brief Maps data from a complex vector to a caller-provided stream matrix (Nstream x Nsymbol/Nstream).
+ *
+ * Same mapping as `tx_layer_mapper`, without allocating.
+ */
+void tx_layer_mapper_into(complexo **mtx_stream, complexo *v, int Nstream, long int Nsymbol){
     // Maps the data from the vector to the complex matrix
     for (int i = 0; i < Nsymbol; i++){
         mtx_stream[i%Nstream][i/Nstream] = v[i];
     }
-    return mtx_stream;
 }
 /**
  * @brief Maps data from a complex matrix to a complex vector.
@@ -291,134 +292,196 @@ complexo ** tx_layer_mapper(complexo *v, int Nstream, long int Nsymbol){
  *         in case of memory allocation error.
  *
  * @note The caller is responsible for freeing the memory allocated for the complex vector
- *       when it is no longer needed, using the free() function.
+ *       when it is no longer needed, using the arena_free() function.
  */
 
 complexo* rx_layer_demapper(complexo** mtx_stream, int Nstream, long int numBytes) {
     // Allocates memory for the complex vector
-    complexo* v = (complexo*) malloc(numBytes * sizeof(complexo));
+    complexo* v = (complexo*) arena_malloc(numBytes * sizeof(complexo));
     if (v == NULL) {
         printf("Error in memory allocation\n");
         return NULL;
     }
+    rx_layer_demapper_into(v, mtx_stream, Nstream, numBytes);
 
+    return v;
+}
+/**
+ * @brief Maps data from a stream matrix to a caller-provided complex vector.
+ *
+ * Same mapping as `rx_layer_demapper`, without allocating.
+ */
+void rx_layer_demapper_into(complexo *v, complexo** mtx_stream, int Nstream, long int numBytes) {
     // Maps the data from the matrix to the complex vector
     for (int i = 0; i < numBytes; i++) {
         v[i] = mtx_stream[i % Nstream][i / Nstream];
     }
-
-    return v;
 }
 /**
- * @brief Demaps QAM symbols to binary data.
+ * @brief Demaps QAM symbols to a packed payload.
+ *
+ * This function takes a vector of complex numbers representing received QAM symbols and decides
+ * each one by thresholds, packing the bits of the decided symbols as in `tx_data_read`. The
+ * constellations are square, so the nearest point to a received sample is found on each axis on
+ * its own, against thresholds halfway between the levels of the axis (`modulation_slice`). For
+ * 4-QAM the thresholds are the two axes:
+ * - real < 0, imaginary > 0 -> 0 (-a, a)
+ * - real < 0, imaginary < 0 -> 1 (-a, -a)
+ * - real > 0, imaginary > 0 -> 2 (a, a)
+ * - real > 0, imaginary < 0 -> 3 (a, -a)
  *
- * This function takes a vector of complex numbers representing QAM symbols and performs the demapping
- * of these symbols to binary data. Each QAM symbol is associated with a binary value, according to
- * the following table:
- * - (-1, 1)  -> 0
- * - (-1, -1) -> 1
- * - (1, 1)   -> 2
- * - (1, -1)  -> 3
- * - Others   -> 4
+ * Every sample is decided, however noisy, so a symbol is only wrong in the bits whose threshold
+ * the noise crossed; with the Gray code that is usually one bit.
  *
+ * Only the data symbols are demapped: the null padding symbols added by the mapper after them are
+ * simply not passed to this function.
+ *
+ * @param mod The constellation.
  * @param vmap Vector of complex numbers representing the QAM symbols.
  * @param numQAM The number of QAM symbols in the vector.
  *
- * @return A vector of integers containing the binary data demapped from the QAM symbols.
- *         The caller is responsible for freeing the allocated memory using the free() function.
- *
- * @note The function returns a pointer to integer 1 if memory allocation fails. This is a non-standard
- *       practice and it's recommended to return NULL in such cases. The caller should check for NULL
- *       to ensure that memory allocation was successful.
+ * @return The packed payload demapped from the QAM symbols, or NULL in case of memory allocation error.
+ *         The caller is responsible for freeing the allocated memory using the arena_free() function.
  */
-int* rx_qam_demapper(complexo *vmap, long int numQAM) {
-    // Allocates memory for the integer vector
-    int *vetor = (int *)malloc(numQAM * sizeof(int));
-    if (vetor == NULL) {
+uint8_t* rx_qam_demapper(const modulacao *mod, const complexo *vmap, long int numQAM) {
+    // Allocates memory for the payload
+    long int Nbytes = PAYLOAD_BYTES(numQAM, mod->bits);
+    uint8_t *dados = (uint8_t *)arena_malloc(Nbytes > 0 ? Nbytes : 1);
+    if (dados == NULL) {
         printf("Error in memory allocation\n");
-        return (int *)1;
-    }
-
-    // Demaps the QAM symbols to binary data
-    for (int i = 0; i < numQAM; i++) {
-        if (vmap[i].real == -1.0 && vmap[i].img == 1.0) {
-            vetor[i] = 0;
-        } else if (vmap[i].real == -1.0 && vmap[i].img == -1.0) {
-            vetor[i] = 1;
-        } else if (vmap[i].real == 1.0 && vmap[i].img == 1.0) {
-            vetor[i] = 2;
-        } else if (vmap[i].real == 1.0 && vmap[i].img == -1.0) {
-            vetor[i] = 3;
-        } else {
-            vetor[i] = 4;
-        }
+        return NULL;
     }
+    rx_qam_demapper_into(mod, dados, vmap, numQAM);
 
-    return vetor;
+    return dados;
 }
 /**
- * @brief Removes the "null" symbols that were filled (padding).
+ * @brief Demaps QAM symbols to a caller-provided packed payload.
  *
- * This function undoes the processing done by the data_padding function,
- * returning our vector to its original size.
- * @param s Pointer to the integer array containing the data.
- * @param numBytes The original number of bytes before padding.
- * @param Nstream The number of streams for which the array size should be a multiple.
- * @return A pointer to the integer array with the original values.
- *         
- * @note The function returns a new array if the original number of bytes is not a multiple of the number of streams.
- *       The caller is responsible for freeing the allocated memory using the free() function.
+ * Same thresholds as `rx_qam_demapper`, without allocating. The payload is written in whole
+ * bytes, so the bits after the last symbol of a partial byte are cleared.
  */
-
-int *rx_data_depadding(int *s, long int numBytes, int Nstream) {
-    // Checks if the number of bytes is a multiple of the number of streams
-    if ((4*numBytes) % Nstream == 0) {
-        return s;
-    } 
-    else {
-        // Creates a new array to store the original values
-        int *resized_s = (int *)malloc(4*numBytes*sizeof(int));
-
-        // Copies the original values back to the resized array
-        for (long int i = 0; i < 4*numBytes; i++) {
-            resized_s[i] = s[i];
+void rx_qam_demapper_into(const modulacao *mod, uint8_t *dados, const complexo *vmap, long int numQAM) {
+    modulation_slice(mod, dados, vmap, 0, 1, numQAM);
+}
+/**
+ * @brief Layer and QAM demapping of an equalized stream matrix, in one pass.
+ *
+ * Same decisions as `rx_qam_demapper`, reading symbol i of the message from row i % Nstream and
+ * column i / Nstream of `xf`, as in `rx_layer_demapper`, without the intermediate vector.
+ *
+ * @param mod The constellation.
+ * @param dados The packed payload, with room for Ndados symbols. It is written in whole bytes.
+ * @param xf The equalized stream matrix (Nstream x n). It may be a view of a larger matrix.
+ * @param Ndados The number of data symbols to demap.
+ */
+void rx_qam_layer_demapper_into(const modulacao *mod, uint8_t *dados, const cmatrix *xf, long int Ndados) {
+    modulation_slice(mod, dados, xf->data, xf->ld, xf->linhas, Ndados);
+}
+/**
+ * @brief Layer and QAM demapping, in one pass, of the sign bits left by the FEQ (4-QAM only).
+ *
+ * `channel_context_transmit_into` writes the sign bits of each equalized sample (see
+ * `cvec_scale_sign`) next to it, and the sign bits alone decide the symbol (see
+ * `rx_qam_demapper`). This function reads them in message order, symbol i from row i % Nstream
+ * and column i / Nstream as in `rx_layer_demapper`, and packs the decided symbols straight into
+ * the payload, so the received samples are neither copied nor read again.
+ *
+ * @param dados The packed payload, with room for Ndados symbols. It is written in whole bytes.
+ * @param sinais The sign bits of the equalized stream matrix, element (l, c) at `sinais[l*ld + c]`.
+ * @param ld The distance between the rows of `sinais`.
+ * @param Nstream The number of streams.
+ * @param Ndados The number of data symbols to demap.
+ */
+void rx_qam_slicer_into(uint8_t *dados, const uint8_t *sinais, long int ld, int Nstream, long int Ndados) {
+    int l = 0;
+    long int c = 0;
+    for (long int b = 0; b < PAYLOAD_BYTES(Ndados, 2); b++) {
+        uint8_t byte = 0;
+        for (int j = 0; j < 4 && 4*b + j < Ndados; j++) {
+            byte |= qam4_decisao[sinais[l*ld + c]] << (2*j);
+            if (++l == Nstream) {
+                l = 0;
+                c++;
+            }
         }
-        return resized_s;
+        dados[b] = byte;
     }
 }
 /**
- * @brief Recovers the original bytes.
+ * @brief Computes the log-likelihood ratios of the bits of the QAM symbols received in a stream matrix.
+ *
+ * The LLR of a bit is L = ln(P(bit = 0 | y) / P(bit = 1 | y)), so a positive value favours 0 and
+ * the hard decision of a bit is the sign of its LLR. The noise of stream l is complex Gaussian with
+ * the variance var_l, half of it on each part of the sample (see `modulation_llr`). With 4-QAM,
+ * bit 0 of a symbol only depends on the imaginary part and bit 1 only on the real part, each a BPSK
+ * of amplitude a = 1/sqrt(2), for which the max-log and the exact LLR are the same:
+ * - L(bit 0) = 4a*Im(y)/var_l
+ * - L(bit 1) = -4a*Re(y)/var_l
+ * With the higher orders the LLRs are max-log, from the distances to the nearest point with each
+ * value of the bit.
  *
- * This function recovers the original bytes every 4 digits by performing the inverse process of the data_read function.
- * It takes the integer array 's' and decodes it into character bytes to generate the file named 'fileName'.
+ * The LLRs are written in message order with the layout of the packed payload: symbol i of the
+ * message, on row i % Nstream and column i / Nstream of `xf` (as in `rx_layer_demapper`), takes
+ * `llr[b*i]` to `llr[b*i + b - 1]`, with b = `mod->bits`. Each row of `xf` is read once.
  *
- * @param s Pointer to the integer array containing the data.
+ * @param mod The constellation.
+ * @param xf The equalized stream matrix (Nstream x n), the output of the FEQ. It may be a view of a larger matrix.
+ * @param variancia The complex noise variance of each stream (see `channel_context_noise_variance`).
+ *        A variance of 0 (no noise) gives infinite LLRs.
+ * @param Ndados The number of data symbols in `xf`; the padding symbols after them are skipped.
+ *
+ * @return The b*Ndados LLRs, or NULL in case of memory allocation error. The caller is responsible
+ *         for freeing the allocated memory using the arena_free() function.
+ */
+float* rx_llr_demapper(const modulacao *mod, const cmatrix *xf, const double *variancia, long int Ndados) {
+    float *llr = (float *)arena_malloc((Ndados > 0 ? mod->bits*Ndados : 1) * sizeof(float));
+    if (llr == NULL) {
+        printf("Error in memory allocation\n");
+        return NULL;
+    }
+    rx_llr_demapper_into(mod, llr, xf, variancia, Ndados);
+
+    return llr;
+}
+/**
+ * @brief Computes the LLRs of the bits of a stream matrix into a caller-provided buffer.
+ *
+ * Same LLRs as `rx_llr_demapper`, without allocating. `llr` has room for mod->bits*Ndados values.
+ */
+void rx_llr_demapper_into(const modulacao *mod, float *llr, const cmatrix *xf, const double *variancia, long int Ndados) {
+    int Nstream = xf->linhas;
+    for (int l = 0; l < Nstream && l < Ndados; l++) {
+        // Columns of row l that hold data symbols
+        long int n = (Ndados - l + Nstream - 1) / Nstream;
+        modulation_llr(mod, &llr[(size_t)mod->bits*l], (size_t)mod->bits*Nstream, &CMATRIX_AT(*xf, l, 0), variancia[l], n);
+    }
+}
+/**
+ * @brief Writes a packed payload to a file.
+ *
+ * The payload already holds the original bytes (see `tx_data_read`), so it is written as it is to
+ * the file named 'fileName', through the buffer of `rx_output_open`.
+ *
+ * @param dados Pointer to the packed payload.
  * @param numBytes The original number of bytes before padding.
  * @param fileName The name of the file to be written.
  *
- * @note The function does not return a value. It writes the decoded bytes directly to the file named 'fileName'.
+ * @note The function does not return a value. It writes the bytes directly to the file named 'fileName'.
  *       If the file cannot be opened for writing, an error message is printed to the console.
  */
 
-void rx_data_write(int* s, long int numBytes, char* fileName) {
-    FILE* out = fopen(fileName, "wb");
-    if (out == NULL) {
-        printf("Error opening file %s for writing.\n", fileName);
+void rx_data_write(const uint8_t *dados, long int numBytes, const char* fileName) {
+    rx_output out;
+    if (rx_output_open(&out, fileName) != 0) {
         return;
     } else {
         printf("File %s successfully created.\n", fileName);
     }
 
-    for (int i = 0; i < numBytes; i++) {
-        unsigned char byte = 0;
-        for (int j = 0; j < 4; j++) {
-            unsigned int bit = s[(i * 4) + j];
-            byte |= (bit << (2 * j));
-        }
-        fwrite(&byte, sizeof(byte), 1, out);
-    }
+    rx_output_write(&out, dados, numBytes);
 
-    fclose(out);
+    rx_output_close(&out);
 }
 /**
  * @brief Performs the multiplication of two complex matrices.
@@ -437,10 +500,11 @@ void rx_data_write(int* s, long int numBytes, char* fileName) {
  * @param colunas_b The number of columns of the matrix `mtx_b`.
  *
  * @return A new complex matrix resulting from the multiplication of `mtx_a` and `mtx_b`.
- *         The caller is responsible for freeing the allocated memory using the free() function.
+ *         The caller is responsible for freeing the allocated memory with `LiberarMatriz`.
  *
- * @note This function assumes that the matrices `mtx_a` and `mtx_b` have been correctly allocated
- *       and have compatible dimensions for multiplication.
+ * @note This function assumes that the matrices `mtx_a` and `mtx_b` have been allocated with
+ *       `allocateComplexMatrix` (contiguous storage) and have compatible dimensions for multiplication.
+ *       The product itself is computed by `cmatrix_produto`.
  */
 
 complexo** general_matrix_product(complexo** mtx_a, complexo** mtx_b, int linhas_a, int colunas_a, int linhas_b, int colunas_b)
@@ -451,29 +515,32 @@ complexo** general_matrix_product(complexo** mtx_a, complexo** mtx_b, int linhas
         printf("\nError: The product cannot be performed (incompatibility between matrices)\n");
         exit(1);
     }
-    
-    complexo** matriz;
-    matriz = allocateComplexMatrix(linhas_a, colunas_b);
-    
-    for (int l = 0; l < linhas_a; l++)
+
+    cmatrix a = cmatrix_view(mtx_a, linhas_a, colunas_a);
+    cmatrix b = cmatrix_view(mtx_b, linhas_b, colunas_b);
+    cmatrix matriz = cmatrix_produto(&a, &b);
+
+    return matriz.rows;
+}
+/**
+ * @brief Multiplies two complex matrices into a caller-provided matrix.
+ *
+ * Same product as `general_matrix_product`, written into `dst` (linhas_a x colunas_b) without
+ * allocating. `dst` must have been allocated with `allocateComplexMatrix` and must not be one of the operands.
+ */
+void general_matrix_product_into(complexo** dst, complexo** mtx_a, complexo** mtx_b, int linhas_a, int colunas_a, int linhas_b, int colunas_b)
+{
+    // Validation of the multiplication operation (colunas_a == linhas_b).
+    if (colunas_a != linhas_b)
     {
-        for (int c = 0; c < colunas_b; c++)
-        {
-            complexo accumulator;
-            accumulator.real = 0;
-            accumulator.img = 0;
-            
-            for (int i = 0; i < colunas_a; i++)
-            {
-                accumulator = soma_complexo(accumulator, multcomp(mtx_a[l][i], mtx_b[i][c]));
-            }
-            
-            matriz[l][c].real = accumulator.real;
-            matriz[l][c].img = accumulator.img;
-        }
+        printf("\nError: The product cannot be performed (incompatibility between matrices)\n");
+        exit(1);
     }
-    
-    return matriz;
+
+    cmatrix a = cmatrix_view(mtx_a, linhas_a, colunas_a);
+    cmatrix b = cmatrix_view(mtx_b, linhas_b, colunas_b);
+    cmatrix r = cmatrix_view(dst, linhas_a, colunas_b);
+    cmatrix_produto_into(&r, &a, &b);
 }
 
 /**
@@ -481,43 +548,26 @@ complexo** general_matrix_product(complexo** mtx_a, complexo** mtx_b, int linhas
  *
  * This function generates a complex matrix that represents a transfer channel between
  * transmitting antennas and receiving antennas. The elements of the matrix are random complex numbers
- * with the imaginary part set to zero.
+ * with the imaginary part set to zero, drawn from the active random stream of the thread (`rng_ativo`).
  *
  * @param Nr The number of receiving antennas.
  * @param Nt The number of transmitting antennas.
  * @param sigma The standard deviation value for the channel creation.
  *
  * @return A complex matrix representing the generated transfer channel.
- *         The caller is responsible for freeing the allocated memory using the free() function.
+ *         The caller is responsible for freeing the allocated memory with `LiberarMatriz`.
  *
- * @note This function assumes that the GSL library is correctly installed and linked to the project.
  */
 complexo ** channel_gen(int Nr, int Nt, double sigma){
-    complexo** H = (complexo **) malloc(Nr * sizeof(complexo*));
-    if (H == NULL) {
-        printf("Memory allocation failed.\n");
-        return NULL;
-    }
+    complexo** H = allocateComplexMatrix(Nr, Nt);
+    rng_fluxo *f = rng_ativo();
 
     for (int i = 0; i < Nr; i++) {
-        H[i] = (complexo *) malloc(Nt * sizeof(complexo));
-        if (H[i] == NULL) {
-            printf("Memory allocation failed\n");
-            // Free previously allocated memory
-            for (int j = 0; j < i; j++) {
-                free(H[j]);
-            }
-            free(H);
-            return NULL;
-        }
-    }
-    gsl_rng * r = gsl_rng_alloc (gsl_rng_default);
-    sigma = 1.0;
-
-    for (int i = 0; i < Nr; i++) {
-        for (int j = 0; j < Nt; j++) {
-            gsl_rng_set(r, rand()%10000);
-            H[i][j].real = gsl_ran_gaussian(r, sigma);
+        // The real parts are drawn into the first half of the row and spread from the end, so nothing is overwritten early
+        double *g = (double *) H[i];
+        rng_gaussiana(f, g, Nt, sigma);
+        for (int j = Nt - 1; j >= 0; j--) {
+            H[i][j].real = g[j];
             H[i][j].img = 0;
         }
     }
@@ -527,7 +577,8 @@ complexo ** channel_gen(int Nr, int Nt, double sigma){
 /**
  * @brief Generates a complex matrix representing the noise in the communication channel.
  *
- * This function generates a complex matrix representing the noise in the communication channel.
+ * This function generates a complex matrix representing the noise in the communication channel,
+ * or a Rayleigh fading channel (`channel_draw`).
  * The resulting matrix has dimensions Nr x Nt, where Nr is the number of receiving antennas
  * and Nt is the number of transmitting antennas. The values of the matrix elements are generated
  * randomly with a Gaussian distribution with mean 0 and standard deviation sigma.
@@ -537,62 +588,141 @@ complexo ** channel_gen(int Nr, int Nt, double sigma){
  * @param sigma The standard deviation of the noise.
  *
  * @return A complex matrix representing the noise in the communication channel.
- *         The caller is responsible for freeing the allocated memory using the free() function.
- *
- * @note This function assumes that the GSL library is correctly installed and linked to the project.
+ *         The caller is responsible for freeing the allocated memory with `LiberarMatriz`.
  */
 complexo ** channel_rd_gen(int Nr, int Nt, double sigma){
-    complexo** H = (complexo **) malloc(Nr * sizeof(complexo*));
-    if (H == NULL) {
-        printf("Memory allocation failed.\n");
-        return NULL;
-    }
-
+    complexo** H = allocateComplexMatrix(Nr, Nt);
     for (int i = 0; i < Nr; i++) {
-        H[i] = (complexo *) malloc(Nt * sizeof(complexo));
-        if (H[i] == NULL) {
-            printf("Memory allocation failed\n");
-            // Free previously allocated memory
-            for (int j = 0; j < i; j++) {
-                free(H[j]);
-            }
-            free(H);
-            return NULL;
-        }
+        memset(H[i], 0, Nt * sizeof(complexo));
     }
-    gsl_rng * r = gsl_rng_alloc (gsl_rng_default);
-    
-    sigma = 1.0;
+    channel_rd_add(H, Nr, Nt, sigma);
+    return H;
+}
+/**
+ * @brief Adds channel noise to a matrix in place.
+ *
+ * Draws the same Gaussian noise as `channel_rd_gen` and adds it directly onto `xh`, so the
+ * received signal needs no separate noise matrix. The samples come from the active random
+ * stream of the thread (`rng_ativo`), a whole row at a time.
+ *
+ * @param xh The matrix that receives the noise (Nr x Nt).
+ * @param Nr The number of rows of xh.
+ * @param Nt The number of columns of xh.
+ * @param sigma The standard deviation of the noise.
+ */
+void channel_rd_add(complexo **xh, int Nr, int Nt, double sigma){
+    rng_fluxo *f = rng_ativo();
 
     for (int i = 0; i < Nr; i++) {
-        for (int j = 0; j < Nt; j++) {
-            gsl_rng_set(r, rand()%10000);
-            H[i][j].real = gsl_ran_gaussian(r, sigma);
-            H[i][j].img = gsl_ran_gaussian(r, sigma);
-        }
+        rng_cgaussiana_add(f, xh[i], Nt, sigma);
     }
-
-    return H;
+}
+/**
+ * @brief Converts an Eb/N0 into the corresponding Es/N0.
+ *
+ * @param EbN0_dB The energy per bit to noise density ratio, in dB.
+ * @param bits_per_symbol The number of bits carried by each symbol of the constellation.
+ *
+ * @return The energy per symbol to noise density ratio, in dB.
+ */
+double snr_ebn0_to_esn0(double EbN0_dB, int bits_per_symbol){
+    return EbN0_dB + 10 * log10(bits_per_symbol);
+}
+/**
+ * @brief Adds white Gaussian noise with a given Es/N0 to a signal, in place.
+ *
+ * The symbol energy Es is measured on the signal itself, as the mean power of its elements, so
+ * the noise follows the power that actually reaches the receiving antennas whatever the channel
+ * gain. The noise is complex and circular, with N0 = Es / 10^(EsN0_dB/10) split evenly between
+ * the real and imaginary parts, and is drawn from the active random stream straight onto the
+ * signal, without a separate noise matrix.
+ *
+ * @param xt The signal that receives the noise (linhas x colunas).
+ * @param linhas The number of rows of xt.
+ * @param colunas The number of columns of xt.
+ * @param EsN0_dB The energy per symbol to noise density ratio, in dB. +INFINITY adds no noise.
+ *
+ * @return The noise density N0 that was added.
+ */
+double channel_awgn_add(complexo **xt, int linhas, int colunas, double EsN0_dB){
+    if (isinf(EsN0_dB) && EsN0_dB > 0){
+        return 0;
+    }
+    double Es = 0;
+    for (int i = 0; i < linhas; i++){
+        Es += cvec_power(xt[i], colunas);
+    }
+    Es /= (double) linhas * colunas;
+    double N0 = Es / pow(10, EsN0_dB / 10);
+    channel_rd_add(xt, linhas, colunas, sqrt(N0 / 2));
+    return N0;
+}
+/**
+ * @brief Draws a channel realization of the given model.
+ *
+ * Both models have unit average power per element, E|h|^2 = 1, so the received power and the
+ * statistics of the two are comparable.
+ *
+ * @param modelo The channel model.
+ * @param Nr The number of receiving antennas.
+ * @param Nt The number of transmitting antennas.
+ *
+ * @return The channel matrix (Nr x Nt). The caller is responsible for freeing it with `LiberarMatriz`.
+ */
+complexo ** channel_draw(channel_model modelo, int Nr, int Nt){
+    if (modelo == CHANNEL_RAYLEIGH){
+        return channel_rd_gen(Nr, Nt, M_SQRT1_2);
+    }
+    return channel_gen(Nr, Nt, 1);
+}
+/**
+ * @brief Number of streams of an Nr x Nt link.
+ *
+ * A link carries one stream per eigenmode of the channel, min(Nr, Nt) of them. Rank-adaptive
+ * transmission keeps only the `streams` strongest eigenmodes, which have the largest gains.
+ *
+ * @param Nr The number of receiving antennas.
+ * @param Nt The number of transmitting antennas.
+ * @param streams The number of eigenmodes to keep, or 0 for all of them.
+ *
+ * @return min(Nr, Nt, streams), or min(Nr, Nt) when `streams` is 0.
+ */
+int channel_streams(int Nr, int Nt, int streams){
+    int Nstream = (Nr <= Nt) ? Nr : Nt;
+    return (streams > 0 && streams < Nstream) ? streams : Nstream;
+}
+/**
+ * @brief Truncated SVD of a complex matrix into `complexo**` factors, H ~ U S V^H.
+ *
+ * Only the k largest singular values are computed (`cmatrix_svd_truncada`): U is linhas x k,
+ * S is k x k (the singular values on the diagonal, in decreasing order) and V is colunas x k.
+ * With k = min(linhas, colunas) it is the reduced SVD.
+ */
+static void channel_svd(complexo **H, complexo **Uh, complexo **Sh, complexo **Vh, int linhas, int colunas, int k){
+    cmatrix A = cmatrix_view(H, linhas, colunas);
+    cmatrix U = cmatrix_view(Uh, linhas, k);
+    cmatrix V = cmatrix_view(Vh, colunas, k);
+    double *S = (double *) arena_malloc(k * sizeof(double));
+    cmatrix_svd_truncada(&A, k, &U, S, &V);
+    for (int l = 0; l < k; l++){
+        memset(Sh[l], 0, k * sizeof(complexo));
+        Sh[l][l].real = S[l];
+    }
+    arena_free(S);
 }
 /**
  * @brief Performs Singular Value Decomposition (SVD) on a transposed matrix.
  *
- * This function performs SVD on a transposed matrix, represented by a matrix of complex numbers.
- * The function only uses the real part of the matrix elements for the SVD calculation. It dynamically
- * allocates memory for the matrices U, V, and the vector S, and stores the decomposition results in
- * the matrices Uh, Sh, and Vh.
+ * This function performs the reduced SVD H = U S V^H of a transposed channel matrix (Tlinhas >= Tcolunas),
+ * over the complex elements of H (`cmatrix_svd`), and stores the factors in the matrices Uh, Sh, and Vh.
  *
  * @param H Transposed complex matrix to be decomposed.
- * @param Uh Resulting U matrix from the decomposition, containing the left eigenvectors.
- * @param Sh Resulting S matrix from the decomposition, containing the singular values on the diagonal.
- * @param Vh Resulting V matrix from the decomposition, containing the right eigenvectors.
+ * @param Uh Resulting U matrix from the decomposition (Tlinhas x Tcolunas), containing the left singular vectors.
+ * @param Sh Resulting S matrix from the decomposition (Tcolunas x Tcolunas), containing the singular values on the diagonal.
+ * @param Vh Resulting V matrix from the decomposition (Tcolunas x Tcolunas), containing the right singular vectors.
  * @param Tlinhas The number of rows of the transposed matrix H.
  * @param Tcolunas The number of columns of the transposed matrix H.
  *
- * @note This function only considers the real part of the matrix H elements for the SVD calculation.
- *       The function prints a warning if complex elements are detected in the matrix H, but ignores
- *       the imaginary part for the calculation.
- *
  * @remark The `transposed_channel_svd` function is similar to the `square_channel_svd` function, but there's a crucial
  *         difference between them. The `square_channel_svd` function takes a square matrix as a parameter, while the
  *         `transposed_channel_svd` function takes the transposed matrix as a parameter. The transposed matrix is obtained
@@ -601,120 +731,23 @@ complexo ** channel_rd_gen(int Nr, int Nt, double sigma){
  */
 
 void transposed_channel_svd(complexo **H, complexo **Uh, complexo **Sh, complexo **Vh, int Tlinhas, int Tcolunas){
-    for (int l = 0; l < Tlinhas; l++){
-        for (int c = 0; c < Tcolunas; c++){
-            if (H[l][c].img != 0){
-                printf("Warning: complex matrix injected as parameter, function will use only real part from matrix\n");
-                break;
-            }
-        }
-    }
-    gsl_matrix * U = gsl_matrix_alloc(Tlinhas, Tcolunas); // U matrix lxc
-    gsl_matrix * V = gsl_matrix_alloc(Tcolunas, Tcolunas); // V matrix cxc
-    gsl_vector * S = gsl_vector_alloc(Tcolunas); // S vector cx1
-    gsl_vector * work = gsl_vector_alloc(Tcolunas);
-    
-    for(int l=0; l<Tlinhas; l++){
-        for(int c=0; c<Tcolunas; c++){
-            gsl_matrix_set(U, l, c, H[l][c].real);
-        }
-    }
-
-    gsl_linalg_SV_decomp(U, V, S, work);
-    for(int l=0; l<Tlinhas; l++){
-        for(int c=0; c<Tcolunas; c++){
-            Uh[l][c].real = gsl_matrix_get(U, l, c);
-            Uh[l][c].img = 0;
-        }
-    }
-    for(int l=0; l<Tcolunas; l++){
-        for(int c=0; c<Tcolunas; c++){
-            Vh[l][c].real = gsl_matrix_get(V, l, c);
-            Vh[l][c].img = 0;
-        }
-    }
-    for (int l = 0; l < Tcolunas; l++){
-        for (int c = 0; c < Tcolunas; c++){
-            if (l == c){
-                Sh[l][c].real = gsl_vector_get(S,c);
-                Sh[l][c].img = 0;
-            }else{
-                Sh[l][c].real = 0;
-                Sh[l][c].img = 0;
-            }
-        }
-    }
+    channel_svd(H, Uh, Sh, Vh, Tlinhas, Tcolunas, Tcolunas);
 }
 /**
  * @brief Performs Singular Value Decomposition (SVD) on a square matrix.
  *
- * This function performs SVD on a square matrix, represented by a matrix of complex numbers.
- * The function only uses the real part of the matrix elements for the SVD calculation.
- * It dynamically allocates memory for the U, V matrices and the S vector, and stores the 
- * decomposition results in the Uh, Sh, and Vh matrices.
+ * This function performs the reduced SVD H = U S V^H of a complex matrix with at least as many rows
+ * as columns (`cmatrix_svd`), and stores the factors in the Uh, Sh, and Vh matrices.
  *
  * @param H The square complex matrix to be decomposed.
- * @param Uh The resulting U matrix from the decomposition, containing the left eigenvectors.
- * @param Sh The resulting S matrix from the decomposition, containing the singular values on the diagonal.
- * @param Vh The resulting V matrix from the decomposition, containing the right eigenvectors.
+ * @param Uh The resulting U matrix from the decomposition (linhas x colunas), containing the left singular vectors.
+ * @param Sh The resulting S matrix from the decomposition (colunas x colunas), containing the singular values on the diagonal.
+ * @param Vh The resulting V matrix from the decomposition (colunas x colunas), containing the right singular vectors.
  * @param linhas The number of rows in the H matrix.
  * @param colunas The number of columns in the H matrix.
- *
- * @note This function only considers the real part of the H matrix elements for the SVD calculation.
- *       The function returns immediately if complex elements are detected in the H matrix.
  */
 void square_channel_svd(complexo **H,  complexo **Uh, complexo **Sh, complexo **Vh, int linhas, int colunas) {
-    // Check for complex elements in the matrix
-    for (int l = 0; l < linhas; l++) {
-        for (int c = 0; c < colunas; c++) {
-            if (H[l][c].img != 0) {
-                return;
-            }
-        }
-    }
-    
-    // Allocate memory for the matrices and vectors
-    gsl_matrix *U = gsl_matrix_alloc(linhas, colunas);
-    gsl_matrix *V = gsl_matrix_alloc(colunas, colunas);
-    gsl_vector *S = gsl_vector_alloc(colunas);
-    gsl_vector *work = gsl_vector_alloc(colunas);
-    
-    // Copy the real part of the elements from H to U
-    for (int l = 0; l < linhas; l++) {
-        for (int c = 0; c < colunas; c++) {
-            gsl_matrix_set(U, l, c, H[l][c].real);
-        }
-    }
-
-    // Perform the SVD
-    gsl_linalg_SV_decomp(U, V, S, work);
-    
-    // Copy the results to the output matrices and set the imaginary parts to 0
-    for (int l = 0; l < linhas; l++) {
-        for (int c = 0; c < colunas; c++) {
-            Uh[l][c].real = gsl_matrix_get(U, l, c);
-            Uh[l][c].img = 0;
-        }
-    }
-    
-    for (int l = 0; l < colunas; l++) {
-        for (int c = 0; c < colunas; c++) {
-            Vh[l][c].real = gsl_matrix_get(V, l, c);
-            Vh[l][c].img = 0;
-        }
-    }
-    
-    for (int l = 0; l < colunas; l++) {
-        for (int c = 0; c < colunas; c++) {
-            if (l == c) {
-                Sh[l][c].real = gsl_vector_get(S, c);
-                Sh[l][c].img = 0;
-            } else {
-                Sh[l][c].real = 0;
-                Sh[l][c].img = 0;
-            }
-        }
-    }
+    channel_svd(H, Uh, Sh, Vh, linhas, colunas, colunas);
 }
 /**
  * @brief Performs the multiplication of the stream symbols by the V matrix resulting from the SVD decomposition
@@ -736,13 +769,21 @@ complexo ** tx_precoder(complexo ** V, complexo **x, int Vlinhas, int Vcolunas,
     complexo **xp = general_matrix_product(V, x, Vlinhas, Vcolunas, xlinhas, xcolunas);
     return xp;
 }
+/**
+ * @brief Precodes the stream symbols into a caller-provided xp matrix (Vlinhas x xcolunas).
+ *
+ * Same operation as `tx_precoder`, without allocating.
+ */
+void tx_precoder_into(complexo **xp, complexo ** V, complexo **x, int Vlinhas, int Vcolunas, int xlinhas, int xcolunas){
+    general_matrix_product_into(xp, V, x, Vlinhas, Vcolunas, xlinhas, xcolunas);
+}
 /**
  * @brief Performs the transmission of the signal through the communication channel.
  *
  * This function performs the transmission of the input signal xp through the communication channel
  * represented by the H matrix. The result of the transmission is calculated by multiplying the H matrix
- * by the xp vector. In addition, a Rd noise is added to the transmitted signal to simulate the
- * characteristics of the communication channel.
+ * by the xp vector. In addition, white Gaussian noise with the requested Es/N0 is added to the
+ * transmitted signal with `channel_awgn_add`, to simulate the characteristics of the communication channel.
  *
  * @param H Matrix representing the communication channel.
  * @param xp Input vector to be transmitted through the channel.
@@ -750,57 +791,35 @@ complexo ** tx_precoder(complexo ** V, complexo **x, int Vlinhas, int Vcolunas,
  * @param Hcolunas The number of columns in the H matrix.
  * @param xpLinhas The number of rows in the xp vector.
  * @param xpColunas The number of columns in the xp vector.
- * @param r The value that defines the range of the noise to be added: 0 for [-0.001, 0.001],
- *          1 for [-0.01, 0.01], 2 for [-0.5, 0.5], 3 for [-1, 1].
+ * @param EsN0_dB The energy per symbol to noise density ratio at the receiving antennas, in dB.
  *
  * @return The resulting matrix of the signal transmission through the channel, plus the noise.
  */
 
-complexo ** channel_transmission(complexo ** H, complexo ** xp, int Hlinhas, int Hcolunas, int xpLinhas, int xpColunas, int r){
-    complexo **xh = general_matrix_product(H, xp, Hlinhas, Hcolunas, xpLinhas, xpColunas);
-    if (xh == NULL) {
-        printf("Error in matrix multiplication\n");
-        return NULL;
-    }
-
-    complexo ** Rd;
-    switch(r){
-        case 0:
-            Rd = channel_rd_gen(Hlinhas, xpColunas, 0.001);
-            break;
-        case 1:
-            Rd = channel_rd_gen(Hlinhas, xpColunas, 0.01);
-            break;
-        case 2:
-            Rd = channel_rd_gen(Hlinhas, xpColunas, 0.5);
-            break;
-        case 3:
-            Rd = channel_rd_gen(Hlinhas, xpColunas, 1);
-            break;
-    }
-    if (Rd == NULL) {
-        printf("Error in channel noise generation\n");
-        free(xh);
-        return NULL;
-    }
-
-    complexo ** xt = soma(xh, Rd, Hlinhas, xpColunas);
-    if (xt == NULL) {
-        printf("Error in matrix addition\n");
-        free(xh);
-        free(Rd);
-        return NULL;
-    }
-
-    free(xh);
-    free(Rd);
-
+complexo ** channel_transmission(complexo ** H, complexo ** xp, int Hlinhas, int Hcolunas, int xpLinhas, int xpColunas, double EsN0_dB){
+    complexo **xt = allocateComplexMatrix(Hlinhas, xpColunas);
+    channel_transmission_into(xt, H, xp, Hlinhas, Hcolunas, xpLinhas, xpColunas, EsN0_dB);
     return xt;
 }
+/**
+ * @brief Transmits the signal through the channel into a caller-provided matrix.
+ *
+ * Same operation as `channel_transmission`: xt = H*xp, and the noise is then added in place
+ * onto xt with `channel_awgn_add`, so neither the noiseless product nor the noise matrix is stored.
+ *
+ * @param xt The destination matrix (Hlinhas x xpColunas).
+ * @param EsN0_dB The Es/N0 in dB, as in `channel_transmission`.
+ *
+ * @return The noise density N0 that was added (see `channel_awgn_add`).
+ */
+double channel_transmission_into(complexo **xt, complexo ** H, complexo ** xp, int Hlinhas, int Hcolunas, int xpLinhas, int xpColunas, double EsN0_dB){
+    general_matrix_product_into(xt, H, xp, Hlinhas, Hcolunas, xpLinhas, xpColunas);
+    return channel_awgn_add(xt, Hlinhas, xpColunas, EsN0_dB);
+}
 /**
  * @brief Performs the multiplication of signals received by Nr antennas by the U matrix.
  *
- * This function uses the transposed U matrix and multiplies it by the xt vector that we are transmitting,
+ * This function uses the conjugate transpose of the U matrix and multiplies it by the xt vector that we are transmitting,
  * generating the combined vector xc.
  *
  * @param U Allocated U matrix.
@@ -814,15 +833,33 @@ complexo ** channel_transmission(complexo ** H, complexo ** xp, int Hlinhas, int
  */
 
 complexo ** rx_combiner(complexo ** U, complexo ** xt, int Ulinhas, int Ucolunas, int xtLinhas, int xtColunas){
-    // Transpose the U matrix and multiply it by the xt vector to generate the combined vector xc
-    complexo ** xc = general_matrix_product(transposta(U, Ulinhas, Ucolunas), xt, Ucolunas, Ulinhas, xtLinhas, xtColunas);
+    complexo ** xc = allocateComplexMatrix(Ucolunas, xtColunas);
+    rx_combiner_into(xc, U, xt, Ulinhas, Ucolunas, xtLinhas, xtColunas);
     return xc;
 }
+/**
+ * @brief Combines the received signals into a caller-provided xc matrix (Ucolunas x xtColunas).
+ *
+ * Same operation as `rx_combiner`. The conjugate transpose of U is applied as an operand flag of
+ * the matrix product, so U^H is never formed and nothing is allocated.
+ */
+void rx_combiner_into(complexo **xc, complexo ** U, complexo ** xt, int Ulinhas, int Ucolunas, int xtLinhas, int xtColunas){
+    if (Ulinhas != xtLinhas) {
+        printf("\nError: The product cannot be performed (incompatibility between matrices)\n");
+        exit(1);
+    }
+    cmatrix u = cmatrix_view(U, Ulinhas, Ucolunas);
+    cmatrix t = cmatrix_view(xt, xtLinhas, xtColunas);
+    cmatrix c = cmatrix_view(xc, Ucolunas, xtColunas);
+    complexo um = {1, 0}, zero = {0, 0};
+    cmatrix_gemm(GEMM_H, &u, GEMM_N, &t, um, zero, &c);
+}
 /**
  * @brief Removes the interference from the H channel (S matrix from the SVD decomposition)
  *
  * This function uses each non-zero element of the S matrix and
  * divides it by each element of the xc vector in the same row.
+ * When xc has more than one column (block transmission), every column is equalized.
  *
  * @param S Allocated S matrix.
  * @param xc Transmitted xc vector.
@@ -836,124 +873,361 @@ complexo ** rx_combiner(complexo ** U, complexo ** xt, int Ulinhas, int Ucolunas
 complexo ** rx_feq(complexo ** S, complexo ** xc, int Slinhas, int Scolunas, int xcLinhas, int xcColunas){
     // Allocate memory for the xf vector
     complexo ** xf = allocateComplexMatrix(xcLinhas, xcColunas);
+    rx_feq_into(xf, S, xc, Slinhas, Scolunas, xcLinhas, xcColunas);
 
-    // For each row in the S matrix
-    for (int l = 0; l < Slinhas; l++){
-        // For each column in the S matrix
-        for (int c = 0; c < Scolunas; c++){
-            // If the row index is equal to the column index
-            if (l == c){
-                // Divide the real part of the xc vector by the real part of the S matrix
-                xf[l][0].real = xc[l][0].real/S[l][c].real;
-                // Divide the imaginary part of the xc vector by the real part of the S matrix
-                xf[l][0].img = xc[l][0].img/S[l][c].real;
-            }
-        }
+    // Return the xf vector
+    return xf;
+}
+/**
+ * @brief Equalizes xc into a caller-provided xf matrix (xcLinhas x xcColunas).
+ *
+ * Same operation as `rx_feq`. Each element is only read before being written, so xf may be
+ * xc itself (in-place equalization).
+ */
+void rx_feq_into(complexo ** xf, complexo ** S, complexo ** xc, int Slinhas, int Scolunas, int xcLinhas, int xcColunas){
+    (void) xcLinhas;
+    // For each element on the diagonal of the S matrix, divide the whole row of the xc block
+    // by the (real) singular value. A real scale needs no shuffles, so it runs directly on the
+    // interleaved layout instead of converting the block to split planes.
+    for (int l = 0; l < Slinhas && l < Scolunas; l++){
+        cvec_scale(xf[l], xc[l], 1.0/S[l][l].real, xcColunas);
     }
+}
 
-    // Return the xf vector
+/**
+ * @brief Builds the channel context for one channel realization.
+ *
+ * The SVD of the channel matrix H only depends on the channel realization, so it is computed
+ * once here instead of once per transmitted vector. The context keeps H, the SVD factors and
+ * the matrices derived from them: the precoder V, the combiner U^H and the FEQ gains on the
+ * diagonal of S. Every transmitted vector of the same realization (or coherence block) reuses them.
+ *
+ * The decomposition H = U S V^H is the complex SVD of `cmatrix_svd_truncada`, so real and complex
+ * (Rayleigh) channels are both decomposed exactly, and only the Nstream eigenmodes carried by the
+ * link are computed: U is Nr x Nstream, S is Nstream x Nstream and V is Nt x Nstream. For channels
+ * far from square the SVD comes from the eigenvectors of the small Gram matrix (H H^H when
+ * Nr < Nt), which is several times faster than decomposing H itself.
+ *
+ * @param H The channel matrix (Nr x Nt), allocated with `allocateComplexMatrix`. The context takes ownership of it.
+ * @param Nr The number of receiving antennas.
+ * @param Nt The number of transmitting antennas.
+ * @param Nstream The number of streams, the strongest eigenmodes of H (`channel_streams`).
+ *
+ * @return A pointer to the channel context, or NULL in case of memory allocation error.
+ *         The caller is responsible for releasing it with `channel_context_free`.
+ */
+channel_context * channel_context_create(complexo **H, int Nr, int Nt, int Nstream){
+    channel_context *ctx = (channel_context *) arena_malloc(sizeof(channel_context));
+    if (ctx == NULL) {
+        printf("Error in memory allocation\n");
+        return NULL;
+    }
+    ctx->Nr = Nr;
+    ctx->Nt = Nt;
+    ctx->Nstream = Nstream;
+    ctx->H = cmatrix_view(H, Nr, Nt);
+    ctx->U = cmatrix_alloc(Nr, ctx->Nstream);
+    ctx->S = cmatrix_alloc(ctx->Nstream, ctx->Nstream);
+    ctx->V = cmatrix_alloc(Nt, ctx->Nstream);
+
+    channel_svd(H, ctx->U.rows, ctx->S.rows, ctx->V.rows, Nr, Nt, Nstream);
+    // The combiner is applied to every received vector, so U^H is formed only once
+    ctx->Ut = cmatrix_hermitiana(&ctx->U);
+    // The transmission workspace is allocated by the first call to channel_context_reserve
+    ctx->largura = 0;
+    ctx->xp.rows = NULL;
+    ctx->xt.rows = NULL;
+    ctx->xc.rows = NULL;
+    return ctx;
+}
+
+/**
+ * @brief Makes sure the workspace of a channel context holds blocks of `largura` columns.
+ *
+ * `channel_context_transmit_into` keeps the precoded, transmitted and combined signals of a
+ * block in this workspace, so a transmission allocates nothing once the workspace is large
+ * enough. The workspace only grows; calling this before the transmission loop moves the
+ * allocation out of it.
+ *
+ * @param ctx The channel context.
+ * @param largura The largest number of columns that will be transmitted at once.
+ */
+void channel_context_reserve(channel_context *ctx, int largura){
+    if (largura <= ctx->largura){
+        return;
+    }
+    if (ctx->largura > 0){
+        cmatrix_free(&ctx->xp);
+        cmatrix_free(&ctx->xt);
+        cmatrix_free(&ctx->xc);
+    }
+    ctx->xp = cmatrix_alloc(ctx->Nt, largura);
+    ctx->xt = cmatrix_alloc(ctx->Nr, largura);
+    ctx->xc = cmatrix_alloc(ctx->Nstream, largura);
+    ctx->largura = largura;
+}
+
+/**
+ * @brief Releases a channel context and every matrix owned by it, including H.
+ *
+ * @param ctx The channel context created by `channel_context_create`.
+ */
+void channel_context_free(channel_context *ctx){
+    if (ctx == NULL){
+        return;
+    }
+    cmatrix_free(&ctx->H);
+    cmatrix_free(&ctx->U);
+    cmatrix_free(&ctx->S);
+    cmatrix_free(&ctx->V);
+    cmatrix_free(&ctx->Ut);
+    if (ctx->largura > 0){
+        cmatrix_free(&ctx->xp);
+        cmatrix_free(&ctx->xt);
+        cmatrix_free(&ctx->xc);
+    }
+    arena_free(ctx);
+}
+
+/**
+ * @brief Transmits one block of stream vectors through a channel realization.
+ *
+ * Runs the precoder, the channel, the combiner and the FEQ using the factors cached in
+ * the channel context. The n columns of x go through each stage together, so every stage
+ * is a single matrix-matrix product instead of n matrix-vector products.
+ *
+ * @param ctx The channel context of the current realization.
+ * @param x The stream vectors to be transmitted (Nstream x n). It may be a view of a larger matrix.
+ * @param EsN0_dB The Es/N0 in dB passed to `channel_transmission`.
+ *
+ * @return The equalized vectors xf (Nstream x n). The caller releases them with `cmatrix_free`.
+ */
+cmatrix channel_context_transmit(channel_context *ctx, const cmatrix *x, double EsN0_dB){
+    cmatrix xf = cmatrix_alloc(ctx->Nstream, x->colunas);
+    channel_context_transmit_into(ctx, x, &xf, NULL, EsN0_dB);
     return xf;
 }
 
+/**
+ * @brief Transmits one block of stream vectors into a caller-provided matrix, without allocating.
+ *
+ * Same stages as `channel_context_transmit`. The intermediate signals live in the workspace
+ * of the context (grown with `channel_context_reserve` if needed), the noise is added in
+ * place onto the transmitted signal and the FEQ writes straight into `xf`, which may be a
+ * view of a larger receiving matrix.
+ *
+ * When `sinais` is given, the FEQ also writes the sign bits of each equalized sample into it
+ * (`cvec_scale_sign`), in the same pass, for the hard decision of `rx_qam_slicer_into`.
+ *
+ * @param ctx The channel context of the current realization.
+ * @param x The stream vectors to be transmitted (Nstream x n). It may be a view of a larger matrix.
+ * @param xf The destination of the equalized vectors (Nstream x n). It may be a view of a larger matrix.
+ * @param sinais The destination of the sign bits, element (l, c) at `sinais[l*xf->ld + c]`, or NULL.
+ * @param EsN0_dB The Es/N0 in dB passed to `channel_transmission_into`.
+ *
+ * @return The noise density N0 added to the block, from which `channel_context_noise_variance`
+ *         gives the noise variance of each equalized stream.
+ */
+double channel_context_transmit_into(channel_context *ctx, const cmatrix *x, cmatrix *xf, uint8_t *sinais, double EsN0_dB){
+    int n = x->colunas;
+    complexo um = {1, 0}, zero = {0, 0};
+    channel_context_reserve(ctx, n);
+    cmatrix xp = cmatrix_submatrix(&ctx->xp, 0, 0, ctx->Nt, n);
+    cmatrix xt = cmatrix_submatrix(&ctx->xt, 0, 0, ctx->Nr, n);
+    cmatrix xc = cmatrix_submatrix(&ctx->xc, 0, 0, ctx->Nstream, n);
+
+    cmatrix_gemm(GEMM_N, &ctx->V, GEMM_N, x, um, zero, &xp);
+    double N0 = channel_transmission_into(xt.rows, ctx->H.rows, xp.rows, ctx->Nr, ctx->Nt, ctx->Nt, n, EsN0_dB);
+    cmatrix_gemm(GEMM_N, &ctx->Ut, GEMM_N, &xt, um, zero, &xc);
+    // FEQ over the rows of the destination, which has no row pointers when it is a tile of rx_mtx
+    for (int l = 0; l < ctx->Nstream; l++){
+        double k = 1.0/CMATRIX_AT(ctx->S, l, l).real;
+        if (sinais != NULL){
+            cvec_scale_sign(&CMATRIX_AT(*xf, l, 0), &sinais[(size_t)l * xf->ld], &CMATRIX_AT(xc, l, 0), k, n);
+        }else{
+            cvec_scale(&CMATRIX_AT(*xf, l, 0), &CMATRIX_AT(xc, l, 0), k, n);
+        }
+    }
+    return N0;
+}
+
+/**
+ * @brief Noise variance of each equalized stream of a channel realization.
+ *
+ * The combiner U^H is unitary, so the noise of each combined stream keeps the density N0 of the
+ * receiving antennas, and the FEQ divides stream l by its singular value s_l. The complex noise
+ * of equalized stream l has then the variance N0 / s_l^2, half of it on each of its parts.
+ *
+ * @param ctx The channel context of the realization.
+ * @param N0 The noise density of the block, as returned by `channel_context_transmit_into`.
+ * @param variancia The variance of each stream (Nstream values), filled by this function.
+ */
+void channel_context_noise_variance(const channel_context *ctx, double N0, double *variancia){
+    for (int l = 0; l < ctx->Nstream; l++){
+        double s = CMATRIX_AT(ctx->S, l, l).real;
+        variancia[l] = N0 / (s * s);
+    }
+}
+
+/**
+ * @brief Transmits the whole stream matrix through a channel realization, one tile at a time.
+ *
+ * The stream matrix produced by `tx_layer_mapper` is split in tiles of `largura` columns and
+ * each tile is sent with `channel_context_transmit_into`, so precoding, channel, combining and
+ * equalization run as matrix-matrix products over the whole tile. The equalized tiles are
+ * written directly into the corresponding columns of `rx_mtx`.
+ *
+ * The intermediate signals of every tile reuse the workspace of the context, reserved once
+ * before the loop, so the memory used does not grow with the number of tiles. The noise of
+ * tile i of the message comes from the substream i of the active random stream (`rng_subfluxo`),
+ * so the result is the same whatever order the tiles are transmitted in, and a message sent in
+ * several calls (one per chunk, with `coluna0` a multiple of `largura`) gets the same noise as
+ * in a single call.
+ *
+ * When `acc` is given, the error and signal powers of each equalized tile are added to it as soon
+ * as the tile is received (`stats_add_signal`), so the statistics need no second pass over the
+ * whole stream matrix.
+ *
+ * @param ctx The channel context of the current realization.
+ * @param mtx The stream matrix to be transmitted (Nstream x Ncolunas).
+ * @param rx_mtx The receiving matrix (Nstream x Ncolunas), filled by this function.
+ * @param sinais The sign bits of `rx_mtx`, with its layout (see `channel_context_transmit_into`), or NULL.
+ * @param ruido The noise density N0 of each tile, in the order of the tiles, or NULL.
+ * @param largura The tile width in columns. 0 (or a value larger than the matrix) sends the whole matrix as a single block.
+ * @param coluna0 The column of the message where `mtx` starts (0 when it is the whole message).
+ * @param EsN0_dB The Es/N0 in dB passed to `channel_transmission`.
+ * @param acc The accumulator of the test statistics, or NULL.
+ */
+void channel_context_transmit_blocks(channel_context *ctx, const cmatrix *mtx, cmatrix *rx_mtx, uint8_t *sinais, double *ruido, int largura, long int coluna0, double EsN0_dB, stats_acc *acc){
+    int Ncolunas = mtx->colunas;
+    if (largura <= 0){
+        largura = Ncolunas;
+    }
+    // The workspace is sized once, so the loop below allocates nothing
+    channel_context_reserve(ctx, largura < Ncolunas ? largura : Ncolunas);
+    rng_fluxo pai = *rng_ativo();
+    for (int c0 = 0; c0 < Ncolunas; c0 += largura){
+        int n = (Ncolunas - c0 < largura) ? Ncolunas - c0 : largura;
+        cmatrix x = cmatrix_submatrix(mtx, 0, c0, ctx->Nstream, n);
+        cmatrix xf = cmatrix_submatrix(rx_mtx, 0, c0, ctx->Nstream, n);
+        // Each tile draws its noise from its own substream, so it does not depend on the order of the tiles
+        rng_fluxo fluxo = rng_subfluxo(&pai, (coluna0 + c0) / largura);
+        rng_fluxo *anterior = rng_usar(&fluxo);
+        double N0 = channel_context_transmit_into(ctx, &x, &xf, sinais != NULL ? sinais + c0 : NULL, EsN0_dB);
+        if (ruido != NULL){
+            ruido[c0 / largura] = N0;
+        }
+        rng_usar(anterior);
+        if (acc != NULL){
+            stats_add_signal(acc, &x, &xf);
+        }
+    }
+}
+
 /**
  * @brief Generates and outputs statistics about the transmitted and received QAM symbols.
  *
- * This function calculates and outputs statistics about the transmitted and received QAM symbols,
- * comparing the transmitted symbols vector `s` with the received symbols vector `finals`. 
- * It counts the number of correct and incorrect transmissions and calculates the percentage of symbols 
- * received with errors in relation to the total symbols. It also calculates the Bit Error Rate (BER), 
- * Signal-to-Noise Ratio (SNR), Error Vector Magnitude (EVM), and the capacity of the communication channel.
- * The results are displayed on the standard output and also saved to a CSV file named "output.csv".
+ * This function outputs statistics about the transmitted and received QAM symbols from the running
+ * accumulator of the test, which is updated block by block while the message is transmitted and
+ * received, so no full copy of the sent and received signals is needed here.
+ * It reports the percentage of symbols received with errors in relation to the total symbols, the
+ * Bit Error Rate (BER), Signal-to-Noise Ratio (SNR), Error Vector Magnitude (EVM), the capacity of
+ * the communication channel and the symbol error rate and EVM of each stream.
+ * The results are displayed on the standard output and stored in `res`, to be written to the CSV
+ * file with `write_statistics`.
  *
  * The CSV file contains the following columns:
  * 1. `test`: An integer parameter used for testing.
  * 2. `Nr`: The number of receive antennas.
  * 3. `Nt`: The number of transmit antennas.
- * 4. `r`: Noise interval.
+ * 4. `esn0_dB`: The requested Es/N0 of the noise stage, in decibels.
  * 5. `error_percentage`: The percentage of symbols received with errors in relation to the total symbols.
  * 6. `ber`: The Bit Error Rate (BER).
  * 7. `snr_dB`: The Signal-to-Noise Ratio (SNR) in decibels.
  * 8. `evm_dB`: The Error Vector Magnitude (EVM) in decibels.
  * 9. `cap`: The capacity of the communication channel in bits per symbol.
  *
- * @param s The vector of transmitted QAM symbols.
- * @param finals The vector of received QAM symbols.
- * @param numBytes The number of transmitted bytes (considering 4 QAM symbols per byte).
+ * @param acc The statistics accumulated during the test.
  * @param teste An integer parameter used for testing.
  * @param Nr The number of receive antennas.
  * @param Nt The number of transmit antennas.
- * @param r The radius of the QAM constellation.
- * @param original_signal A 2D array of complex numbers representing the original transmitted signal.
- * @param received_signal A 2D array of complex numbers representing the signal received after transmission.
- * @param Nstream The number of streams in the signal.
- * @param Nsymbol The total number of symbols in the signal.
+ * @param EsN0_dB The Es/N0, in dB, requested for the noise stage.
+ * @param res The statistics of the test, filled by this function.
  *
- * @note This function displays the statistics on the standard output and also writes them to a CSV file.
+ * @note This function displays the statistics on the standard output; `write_statistics` writes them to the CSV file.
  * Visualizations of these statistics can be viewed in the following Jupyter notebook: 
  * https://colab.research.google.com/github/lasseufpa/C_MIMO/blob/1-implement-command-line-parsing-for-antenna-or-similar-configuration-in-mimo-system-simulation/analyzer.ipynb
  */
 
-void generate_statistics(int *s, int *finals, long int numBytes, int teste, int Nr, int Nt, double r, complexo **original_signal, complexo **received_signal, int Nstream, long int Nsymbol){
-    int correct_count=0;
-    int error_count=0;
-    printf("\nNumber of QAM symbols transmitted: %ld\n",numBytes*4);
-    printf("numBytes=%ld\n",numBytes);
-    for(int i =0; i<numBytes*4; i++){
-        if(s[i]==finals[i]){
-            correct_count = correct_count + 1;
-        }
-        else{
-            error_count = error_count + 1;
-        }
-    }
-    double error_percentage = (error_count*100)/(4*numBytes);
-    printf("Number of bits received with error: %d\n",error_count);
-    printf("Percentage of bits received with error: %0.4f%%\n\n",error_percentage);
-
-    // Each incorrect QAM symbol represents 2 incorrect bits
-    long int total_bits = 2 * numBytes * 4;
-    int error_bits = 2 * error_count;
+void generate_statistics(const stats_acc *acc, int teste, int Nr, int Nt, double EsN0_dB, test_result *res){
+    stats_stream total = stats_total(acc);
+    printf("\nNumber of QAM symbols transmitted: %lld\n", total.symbols);
+    printf("Number of symbols received with error: %lld\n", total.symbol_errors);
+    double error_percentage = 100 * stats_ser(acc);
+    printf("Percentage of symbols received with error: %0.4f%%\n\n",error_percentage);
 
-    double ber = (double)error_bits / total_bits;
+    double ber = stats_ber(acc);
     printf("BER: %f\n", ber);
 
     // Calculate SNR
-    double snr_dB = calculate_SNR(original_signal, received_signal, Nstream, Nsymbol);
+    double snr_dB = calculate_SNR(total.error_power, total.signal_power);
     printf("SNR: %f dB\n", snr_dB);
 
     // Calculate EVM
-    double evm_dB = calculate_EVM(original_signal, received_signal, Nstream, Nsymbol);
+    double evm_dB = calculate_EVM(total.error_power, total.signal_power);
     printf("EVM: %f dB\n", evm_dB);
 
+    for (int l = 0; l < acc->Nstream; l++){
+        const stats_stream *st = &acc->stream[l];
+        printf("Stream %d: SER %f, EVM %f dB, error power variance %e\n", l,
+               st->symbols > 0 ? (double) st->symbol_errors / st->symbols : 0,
+               calculate_EVM(st->error_power, st->signal_power), welford_variance(&st->erro));
+    }
+
     double cap = calculate_capacity(snr_dB);
     printf("Capacity: %f bit/symbol\n", cap);
 
+    res->teste = teste;
+    res->Nr = Nr;
+    res->Nt = Nt;
+    res->EsN0_dB = EsN0_dB;
+    res->error_percentage = error_percentage;
+    res->ber = ber;
+    res->snr_dB = snr_dB;
+    res->evm_dB = evm_dB;
+    res->cap = cap;
+}
+
+/**
+ * @brief Appends the statistics of a test to a CSV file, in the columns described in `generate_statistics`.
+ *
+ * @param csv The path of the CSV file. It is created if it does not exist.
+ * @param res The statistics of the test.
+ *
+ * @return 0 on success, or -1 if the file could not be opened.
+ */
+int write_statistics(const char *csv, const test_result *res){
     FILE *file;
 
     // Open the file in append mode, so as not to overwrite existing data
-    file = fopen("output.csv", "a");
+    file = fopen(csv, "a");
 
     if (file == NULL) {
         printf("Could not open the file\n");
-        return;
+        return -1;
     }
 
     // Write the data to the file, including the SNR and EVM
-    fprintf(file, "%d,%d,%d,%f,%f,%f,%f,%f,%f\n", teste, Nr, Nt, r, error_percentage, ber, snr_dB, evm_dB, cap);
+    fprintf(file, "%d,%d,%d,%f,%f,%f,%f,%f,%f\n", res->teste, res->Nr, res->Nt, res->EsN0_dB, res->error_percentage, res->ber, res->snr_dB, res->evm_dB, res->cap);
     fclose(file);
+    return 0;
 }
 
 complexo** expandMatrix(complexo** matriz, int linhas, int colunas, int linhasExtras, int padding){
     // Calcula o novo número total de linhas
     int Nlinhas = linhas + linhasExtras;
     // Aloca uma nova matriz com as dimensões atualizadas
-    complexo** novaMatriz = (complexo**) malloc(Nlinhas * sizeof(complexo*));
-    if (novaMatriz == NULL){
-        printf("Erro de alocacao\n");
-    }
-    for (int i = 0; i < Nlinhas; i++) {
-        novaMatriz[i] = (complexo*) malloc(colunas * sizeof(complexo));
-    }
+    complexo** novaMatriz = allocateComplexMatrix(Nlinhas, colunas);
     // Copia os elementos da matriz original para a nova matriz
     for (int i = 0; i < linhas; i++) {
         for (int j = 0; j < colunas; j++) {
@@ -984,9 +1258,448 @@ bool is_wsl_there(){
     return wsl_distro != NULL;
 }
 
-int main() {
-    srand(time(NULL));
-    system("clear");
+/** A chunk of the stream matrix on its way through the link (see `run_test`). */
+typedef struct link_chunk {
+    long int c0; ///< First column of the chunk in the stream matrix
+    int n; ///< Number of columns of the chunk
+    long int Ndados; ///< Number of data symbols of the chunk; the rest are padding
+    const uint8_t *s; ///< Sent payload of the chunk
+    cmatrix tx; ///< Stream matrix of the chunk (Nstream x chunk)
+    cmatrix rx; ///< Equalized stream matrix of the chunk (Nstream x chunk)
+    uint8_t *sinais; ///< Sign bits of the equalized stream matrix, with the layout of `rx` (4-QAM only)
+    uint8_t *rx_dados; ///< Received payload of the chunk
+    double *ruido; ///< Noise density N0 of each tile of the chunk
+    float *llr; ///< LLRs of the bits of the chunk, in message order
+} link_chunk;
+
+/** State of a test shared by the stages of the link. Each field is written by one stage only. */
+typedef struct link_test {
+    const uint8_t *dados; ///< The packed payload of the message
+    long int numBytes; ///< Size of the message in bytes
+    const modulacao *mod; ///< The constellation
+    long int Nsimbolos; ///< Number of data symbols of the message
+    uint8_t *cauda; ///< The end of the message padded with zeros to whole symbols (source stage)
+    int Nstream; ///< Number of streams
+    long int Ncolunas; ///< Columns of the stream matrix
+    long int passo; ///< Columns per chunk
+    long int largura; ///< Columns per transmission tile
+    long int proxima; ///< First column of the next chunk (source stage)
+    channel_context *ctx; ///< The channel realization (channel stage)
+    double EsN0_dB; ///< Es/N0 of the noise stage, in dB
+    rng_fluxo fluxo; ///< Random stream of the noise (channel stage)
+    arena *arena_canal; ///< Scratch memory of the channel stage
+    stats_acc sinal; ///< Error and signal powers (channel stage)
+    stats_acc simbolos; ///< Symbol and bit errors (receiver stage)
+    rx_output out; ///< The received file (receiver stage)
+    int escrever; ///< Whether the received file is written
+    double *variancia; ///< Noise variance of each equalized stream (LLR stage)
+    rx_output out_llr; ///< The file of LLRs (LLR stage)
+} link_test;
+
+/** Source stage: QAM and layer mapping, in one pass, of the next chunk of the message, followed by the null padding symbols in the last chunk. */
+static bool link_tx(void *slot, void *ctx){
+    link_test *t = ctx;
+    link_chunk *c = slot;
+    if (t->proxima >= t->Ncolunas){
+        return false;
+    }
+    // Columns c0 to c0 + n - 1 of the stream matrix hold the consecutive symbols p to p + m - 1 of the message
+    c->c0 = t->proxima;
+    c->n = (t->Ncolunas - c->c0 < t->passo) ? (int)(t->Ncolunas - c->c0) : (int)t->passo;
+    long int p = c->c0 * t->Nstream, m = (long int)c->n * t->Nstream;
+    c->Ndados = t->Nsimbolos - p < m ? t->Nsimbolos - p : m;
+    // Every chunk starts on a byte of the payload (see run_test)
+    long int primeiro = p * t->mod->bits / 8;
+    c->s = t->dados + primeiro;
+    if (primeiro + PAYLOAD_BYTES(c->Ndados, t->mod->bits) > t->numBytes) {
+        // The last symbol runs past the end of the message, whose missing bits are sent as zeros
+        memset(t->cauda, 0, PAYLOAD_BYTES(c->Ndados, t->mod->bits));
+        memcpy(t->cauda, c->s, t->numBytes - primeiro);
+        c->s = t->cauda;
+    }
+    tx_qam_layer_mapper_into(t->mod, c->tx.rows, c->s, c->Ndados, m, t->Nstream);
+    t->proxima += t->passo;
+    return true;
+}
+
+/** Channel stage: precoding, channel, combining and FEQ of a chunk, in tiles of `largura` columns. */
+static bool link_channel(void *slot, void *ctx){
+    link_test *t = ctx;
+    link_chunk *c = slot;
+    rng_fluxo *anterior = rng_usar(&t->fluxo);
+    arena *arena_anterior = arena_usar(t->arena_canal);
+    cmatrix x = cmatrix_submatrix(&c->tx, 0, 0, t->Nstream, c->n);
+    cmatrix xf = cmatrix_submatrix(&c->rx, 0, 0, t->Nstream, c->n);
+    // The FEQ leaves the sign bits that decide the 4-QAM symbols
+    channel_context_transmit_blocks(t->ctx, &x, &xf, t->mod->bits == 2 ? c->sinais : NULL, c->ruido, (int)t->largura, c->c0, t->EsN0_dB, &t->sinal);
+    arena_usar(arena_anterior);
+    rng_usar(anterior);
+    return true;
+}
+
+/** Receiver stage: hard decision of a chunk (from the sign bits of the FEQ with 4-QAM), without the padding symbols, error counting and writing of the received bytes. */
+static bool link_rx(void *slot, void *ctx){
+    link_test *t = ctx;
+    link_chunk *c = slot;
+    long int p = c->c0 * t->Nstream;
+    // Desmapeamento dos bits do arquivo, sem os símbolos nulos do padding
+    if (t->mod->bits == 2) {
+        rx_qam_slicer_into(c->rx_dados, c->sinais, c->rx.ld, t->Nstream, c->Ndados);
+    } else {
+        rx_qam_layer_demapper_into(t->mod, c->rx_dados, &c->rx, c->Ndados);
+    }
+    stats_add_symbols(&t->simbolos, c->s, c->rx_dados, c->Ndados, p);
+    if (t->escrever) {
+        // The zeros that complete the last symbol are not part of the file
+        long int primeiro = p * t->mod->bits / 8, Nbytes = PAYLOAD_BYTES(c->Ndados, t->mod->bits);
+        rx_output_write(&t->out, c->rx_dados, primeiro + Nbytes > t->numBytes ? t->numBytes - primeiro : Nbytes);
+    }
+    return true;
+}
+
+/** LLR stage: soft demapping of a chunk, tile by tile with the noise of each tile, and writing of the LLRs of its data bits. */
+static bool link_llr(void *slot, void *ctx){
+    link_test *t = ctx;
+    link_chunk *c = slot;
+    for (long int c0 = 0; c0 < c->n && c0 * t->Nstream < c->Ndados; c0 += t->largura) {
+        int n = (c->n - c0 < t->largura) ? (int)(c->n - c0) : (int)t->largura;
+        long int Ndados = c->Ndados - c0 * t->Nstream;
+        cmatrix xf = cmatrix_submatrix(&c->rx, 0, c0, t->Nstream, n);
+        channel_context_noise_variance(t->ctx, c->ruido[c0 / t->largura], t->variancia);
+        rx_llr_demapper_into(t->mod, c->llr + t->mod->bits*c0*t->Nstream, &xf, t->variancia, Ndados < (long int)n * t->Nstream ? Ndados : (long int)n * t->Nstream);
+    }
+    // The bits that complete the last symbol are not part of the file
+    long int bit0 = c->c0 * t->Nstream * t->mod->bits, Nbits = t->mod->bits * c->Ndados;
+    if (bit0 + Nbits > 8 * t->numBytes) {
+        Nbits = 8 * t->numBytes - bit0;
+    }
+    rx_output_write(&t->out_llr, (const uint8_t *)c->llr, Nbits * (long int)sizeof(float));
+    return true;
+}
+
+/**
+ * @brief Runs one test: transmits a file through a new channel realization and records the statistics.
+ *
+ * The message is streamed through the link in chunks of `chunk_width` columns of the stream
+ * matrix: each chunk is mapped, layer mapped, transmitted, demapped, compared and written before
+ * the next one, so the memory of a test depends on the chunk and not on the size of the file. The
+ * chunk is rounded up to a multiple of the tile width, so the results do not depend on it.
+ *
+ * The link runs as three stages (`link_tx`, `link_channel` and `link_rx`) connected by
+ * `pipeline_run`, plus `link_llr` when the LLRs are written. With `pipeline`, each stage runs on a thread of its own, with
+ * TX_PIPELINE_SLOTS chunks in flight, so a single test uses several processors and the writing
+ * of the received file overlaps the computation. The results are the same either way.
+ *
+ * The channel and the noise are drawn from the random stream `teste` of `semente`, so a test is
+ * reproducible from its number and the seed alone. The memory of the test comes from the active
+ * arena, which the caller may reset afterwards. The file is opened once by the caller
+ * (`tx_input_open`) and only read here, so any number of tests may share it.
+ *
+ * @param in The file to be transmitted.
+ * @param destino The directory where the received file is saved, or NULL to keep only the statistics.
+ * @param destino_llr The directory where the LLRs of the received bits are saved (`rx_llr_demapper`,
+ *        as native float32 values in the file `Test_*_llr`), or NULL.
+ * @param teste The test number.
+ * @param mod The constellation.
+ * @param canal The channel model.
+ * @param streams The number of eigenmodes used (`channel_streams`), or 0 for all of them.
+ * @param Nr The number of receiving antennas.
+ * @param Nt The number of transmitting antennas.
+ * @param EsN0_dB The Es/N0 of the noise stage, in dB.
+ * @param block_width The number of columns sent through the channel at once (0 for all).
+ * @param chunk_width The number of columns of the stream matrix in memory at once (0 for all).
+ * @param pipeline Whether the stages of the link run on threads of their own.
+ * @param semente The seed of the random streams.
+ * @param res The statistics of the test, filled by this function.
+ *
+ * @return 0 on success, or 1 if the pipeline cannot be started.
+ */
+static int run_test(const tx_input *in, const char *destino, const char *destino_llr, int teste, const modulacao *mod, channel_model canal, int streams, int Nr, int Nt, double EsN0_dB, int block_width, long int chunk_width, bool pipeline, uint64_t semente, test_result *res){
+    char fileName[PATH_MAX];
+    rng_fluxo fluxo_teste = rng_criar(semente, teste);
+    rng_fluxo *anterior = rng_usar(&fluxo_teste);
+
+    printf("\n===================== Test %d ===================\n\n", teste);
+    // The file is already in memory: its bytes are the packed payload
+    const uint8_t *dados = in->dados;
+    long int numBytes = in->numBytes;
+
+    //Declarando o número de fluxos
+    int Nstream = channel_streams(Nr, Nt, streams);
+    printf("\nNumber of receiving antennas Nr: %d\nNumber of transmitting antennas Nt: %d\nNumber of streams Nstream: %d", Nr, Nt, Nstream);
+    // Calculating number of symbols necessary for (Ndados + Npadding) % Nstream == 0.
+    long int Ndados = modulation_symbols(mod, numBytes);
+    int Npadding;
+    if (Ndados % Nstream == 0){
+        Npadding = 0;
+    }else{ 
+        Npadding = (Nstream - Ndados%Nstream);
+    }
+    printf("\nModulation: %d-QAM\nAmount of padding symbols: %d", mod->M, Npadding);
+    // Calculating number of symbols
+    long int Nsymbol = (Ndados + Npadding);
+    long int Ncolunas = Nsymbol/Nstream;
+    // Chunk of columns of the stream matrix: a multiple of the tile width, so the noise does not
+    // depend on the chunk, and of the columns that fill whole bytes of the payload (4 for 4-QAM),
+    // so every chunk starts on a byte
+    long int colunas_byte = 8 / (mod->bits & -mod->bits);
+    long int largura = (block_width <= 0 || block_width > Ncolunas) ? Ncolunas : block_width;
+    long int passo = (chunk_width <= 0 || chunk_width > Ncolunas) ? Ncolunas : chunk_width;
+    if (largura > 0) {
+        passo = (passo + largura - 1) / largura * largura;
+        while (passo % colunas_byte != 0 && passo < Ncolunas) {
+            passo += largura;
+        }
+    }
+    if (passo > Ncolunas || passo <= 0) {
+        passo = Ncolunas > 0 ? Ncolunas : 1;
+    }
+    printf("\nStreaming the stream matrix Nstream x (Nsymbols/Nstream) in chunks of %ld columns...", passo);
+    link_test t = {.dados = dados, .numBytes = numBytes, .mod = mod, .Nsimbolos = Ndados, .Nstream = Nstream,
+                   .Ncolunas = Ncolunas, .passo = passo, .largura = largura, .EsN0_dB = EsN0_dB};
+    t.cauda = (uint8_t *)arena_malloc(PAYLOAD_BYTES(passo * Nstream, mod->bits) + 1);
+    printf("\nCreating data transfer channel...");
+    complexo ** H = channel_draw(canal, Nr, Nt);
+    // Decomposing the channel once for the whole realization
+    t.ctx = channel_context_create(H, Nr, Nt, Nstream);
+    // The workspace is sized here, so the channel stage allocates nothing but the scratch of its own arena
+    channel_context_reserve(t.ctx, largura < Ncolunas ? largura : Ncolunas);
+    t.fluxo = *rng_ativo();
+    t.arena_canal = arena_create(0);
+    stats_init(&t.sinal, Nstream, mod->bits);
+    stats_init(&t.simbolos, Nstream, mod->bits);
+    if (destino != NULL) {
+        printf("\nSaving file with the sent message in the file Test_%d_Nr%d_Nt%d_SNR%g\n", teste, Nr, Nt, EsN0_dB);
+        sprintf(fileName, "%s/Test_%d_Nr%d_Nt%d_SNR%g", destino, teste, Nr, Nt, EsN0_dB); // Formats the file name based on the value of i
+        t.escrever = rx_output_open(&t.out, fileName) == 0;
+    }
+    int Nestagios = 3;
+    if (destino_llr != NULL) {
+        snprintf(fileName, sizeof(fileName), "%s/Test_%d_Nr%d_Nt%d_SNR%g_llr", destino_llr, teste, Nr, Nt, EsN0_dB);
+        if (rx_output_open(&t.out_llr, fileName) == 0) {
+            t.variancia = (double *)arena_malloc(Nstream * sizeof(double));
+            Nestagios = 4;
+        }
+    }
+    // Buffers of the chunks in flight, reused by every chunk
+    int Nslots = pipeline ? TX_PIPELINE_SLOTS : 1;
+    link_chunk *chunks = (link_chunk *)arena_malloc(Nslots * sizeof(link_chunk));
+    void *slots[TX_PIPELINE_SLOTS];
+    for (int i = 0; i < Nslots; i++) {
+        chunks[i].tx = cmatrix_alloc(Nstream, passo);
+        chunks[i].rx = cmatrix_alloc(Nstream, passo);
+        chunks[i].sinais = mod->bits == 2 ? (uint8_t *)arena_malloc((size_t)Nstream * chunks[i].rx.ld) : NULL;
+        chunks[i].rx_dados = (uint8_t *)arena_malloc(PAYLOAD_BYTES(passo * Nstream, mod->bits));
+        chunks[i].ruido = (double *)arena_malloc((passo / (largura > 0 ? largura : 1) + 1) * sizeof(double));
+        chunks[i].llr = Nestagios == 4 ? (float *)arena_malloc(mod->bits * passo * Nstream * sizeof(float)) : NULL;
+        slots[i] = &chunks[i];
+    }
+    pipeline_stage estagios[4] = {{link_tx, &t}, {link_channel, &t}, {link_rx, &t}, {link_llr, &t}};
+    if (pipeline) {
+        // The kernels and the BLAS backend are chosen before the stage threads start
+        simd_get();
+        blas_get_backend();
+    }
+    // Reported once per test: the tiles of a long message would otherwise flood the output
+    printf("\nTransmission of the data matrix in stream, in blocks of %ld columns...", largura);
+    int erro = pipeline_run(estagios, Nestagios, slots, Nslots, pipeline) != 0;
+    if (t.escrever) {
+        rx_output_close(&t.out);
+    }
+    if (Nestagios == 4) {
+        rx_output_close(&t.out_llr);
+    }
+    channel_context_free(t.ctx);
+    arena_destroy(t.arena_canal);
+    // The statistics of the two stages are put together
+    stats_acc acc;
+    stats_init(&acc, Nstream, mod->bits);
+    stats_merge(&acc, &t.sinal);
+    stats_merge(&acc, &t.simbolos);
+    generate_statistics(&acc, teste, Nr, Nt, EsN0_dB, res);
+    stats_free(&acc);
+    stats_free(&t.sinal);
+    stats_free(&t.simbolos);
+    rng_usar(anterior);
+    printf("================== End of test %d================\n", teste);
+    return erro;
+}
+
+/** State shared by the work items of a batch run. */
+typedef struct batch_state {
+    const sim_config *cfg; ///< The sweep specification
+    const char *destino; ///< Directory of the received files, or NULL when they are not written
+    const char *destino_llr; ///< Directory of the LLR files, or NULL when they are not written
+    const tx_input *entrada; ///< The file transmitted by every test (file tests)
+    arena **arenas; ///< One arena per worker thread
+    test_result *results; ///< Statistics of each test, by item (file tests)
+    ber_point *points; ///< Result of each point, by item (Monte Carlo points)
+    bool *done; ///< Whether each item has finished
+    int next; ///< First item not yet written to the CSV file
+    int Nitems; ///< Number of items (tests)
+    int erro; ///< Set when a test fails
+    pthread_mutex_t lock; ///< Protects done, next and erro, and the writing of the CSV file
+} batch_state;
+
+/** Items per SNR point: one per realization for file tests, a single one for Monte Carlo points, whose frames are the realizations. */
+static int batch_realizations(const sim_config *cfg){
+    return cfg->target_errors > 0 ? 1 : cfg->realizations;
+}
+
+/** Item i of a sweep: antenna pair, SNR and realization, in the order of the loops of `run_batch`. */
+static void batch_item(const sim_config *cfg, int item, int *p, int *k){
+    int por_par = cfg->Nsnr * batch_realizations(cfg);
+    *p = item / por_par;
+    *k = (item % por_par) / batch_realizations(cfg);
+}
+
+/** Runs item `item` of a sweep on worker `worker` and writes every finished result that is next in order. */
+static void batch_task(int item, int worker, void *ctx){
+    batch_state *b = ctx;
+    const sim_config *cfg = b->cfg;
+    int p, k;
+    batch_item(cfg, item, &p, &k);
+    const modulacao *mod = modulation_get(cfg->modulation);
+    double EsN0_dB = cfg->snr_dB[k];
+    if (cfg->reference == SNR_EBN0){
+        EsN0_dB = snr_ebn0_to_esn0(EsN0_dB, mod->bits);
+    }
+
+    // Every allocation of a test comes from the arena of the worker and is released at once at the end of the test
+    arena *anterior = arena_usar(b->arenas[worker]);
+    int erro = 0;
+    if (cfg->target_errors > 0){
+        mc_config mc = {cfg->target_errors, cfg->max_bits, cfg->realizations, cfg->frame_length, cfg->confidence, cfg->modulation, cfg->channel, cfg->streams};
+        rng_fluxo fluxo = rng_criar(cfg->seed, item + 1);
+        mc_ber_point(cfg->Nr[p], cfg->Nt[p], EsN0_dB, &mc, &fluxo, &b->points[item]);
+        b->points[item].teste = item + 1;
+        printf("Point %d: Nr %d, Nt %d, Es/N0 %g dB: BER %e [%e, %e] (%lld errors in %lld bits, %lld frames)\n", item + 1,
+               cfg->Nr[p], cfg->Nt[p], EsN0_dB, b->points[item].ber, b->points[item].ber_low, b->points[item].ber_high,
+               b->points[item].bit_errors, b->points[item].bits, b->points[item].frames);
+    }else{
+        erro = run_test(b->entrada, b->destino, b->destino_llr, item + 1, mod, (channel_model) cfg->channel, cfg->streams, cfg->Nr[p], cfg->Nt[p], EsN0_dB, cfg->block_width, cfg->chunk_width, cfg->pipeline, cfg->seed, &b->results[item]);
+    }
+    arena_reset(b->arenas[worker]);
+    arena_usar(anterior);
+
+    // The CSV file gets the results in test order, whatever order the tests finish in
+    pthread_mutex_lock(&b->lock);
+    b->done[item] = true;
+    b->erro |= erro;
+    while (b->next < b->Nitems && b->done[b->next]){
+        if (cfg->target_errors > 0){
+            if (mc_write_point(cfg->output, &b->points[b->next]) != 0){
+                b->erro = 1;
+            }
+        }else if (b->results[b->next].teste > 0 && write_statistics(cfg->output, &b->results[b->next]) != 0){
+            b->erro = 1;
+        }
+        b->next++;
+    }
+    pthread_mutex_unlock(&b->lock);
+}
+
+/**
+ * @brief Runs a sweep without prompts, on a pool of threads.
+ *
+ * Every antenna pair of the specification is run at every SNR of the grid, `realizations` times.
+ * With a `target_errors`, each (antenna pair, SNR) point is instead a Monte Carlo BER estimate
+ * (`mc_ber_point`) over random frames, with at least `realizations` frames, and no input file.
+ * The tests are numbered in that order, starting from 1, and each one uses its own random
+ * stream of the seed, so the whole sweep gives the same results for any number of threads. The
+ * tests are spread over the threads by `sched_run`, with a cost estimated from the antenna counts
+ * and the size of the input, and the statistics are appended to the CSV file in test order.
+ * The SNR grid is converted to Es/N0 when it is given as Eb/N0. The input file is mapped once
+ * (`tx_input_open`) and shared by all the tests, and the received files are written only when
+ * `write_files` is set.
+ *
+ * @param cfg The sweep specification, already validated.
+ * @param destino The directory where the received files are saved.
+ *
+ * @return 0 on success, or 1 if a test fails.
+ */
+static int run_batch(const sim_config *cfg, const char *destino){
+    // Symbols per test: the whole file, or one frame for Monte Carlo points
+    double Nsymbol;
+    tx_input entrada = {NULL, 0, NULL, NULL};
+    if (cfg->target_errors > 0){
+        Nsymbol = cfg->frame_length > 0 ? cfg->frame_length : TX_BLOCK_WIDTH;
+    }else{
+        if (tx_input_open(&entrada, cfg->input) != 0){
+            return 1;
+        }
+        Nsymbol = modulation_symbols(modulation_get(cfg->modulation), entrada.numBytes);
+    }
+    int Nitems = cfg->Nantennas * cfg->Nsnr * batch_realizations(cfg);
+    int Nthreads = cfg->threads > 0 ? cfg->threads : sched_available_threads();
+    if (Nthreads > Nitems){
+        Nthreads = Nitems;
+    }
+    printf("Running %d tests on %d threads (seed %llu)\n", Nitems, Nthreads, (unsigned long long) cfg->seed);
+
+    batch_state b = {cfg, cfg->write_files ? destino : NULL, cfg->write_llr ? destino : NULL, &entrada, NULL, NULL, NULL, NULL, 0, Nitems, 0, PTHREAD_MUTEX_INITIALIZER};
+    b.arenas = malloc(Nthreads * sizeof(arena *));
+    b.results = calloc(Nitems, sizeof(test_result));
+    b.points = calloc(Nitems, sizeof(ber_point));
+    b.done = calloc(Nitems, sizeof(bool));
+    double *custo = malloc(Nitems * sizeof(double));
+    if (b.arenas == NULL || b.results == NULL || b.points == NULL || b.done == NULL || custo == NULL){
+        printf("Error in memory allocation\n");
+        return 1;
+    }
+    for (int i = 0; i < Nthreads; i++){
+        b.arenas[i] = arena_create(0);
+    }
+    // SVD of the channel plus the three products of every transmitted column
+    for (int i = 0; i < Nitems; i++){
+        int p, k;
+        batch_item(cfg, i, &p, &k);
+        double Nr = cfg->Nr[p], Nt = cfg->Nt[p];
+        double Nstream = channel_streams(cfg->Nr[p], cfg->Nt[p], cfg->streams);
+        if (cfg->target_errors > 0){
+            Nsymbol = Nstream * (cfg->frame_length > 0 ? cfg->frame_length : TX_BLOCK_WIDTH);
+        }
+        custo[i] = Nr * Nt * Nstream + Nsymbol / Nstream * (Nstream * (Nr + Nt) + Nr * Nt) + Nsymbol;
+    }
+    // The kernels and the BLAS backend are chosen once, before the threads start
+    simd_get();
+    blas_get_backend();
+
+    sched_run(Nitems, custo, Nthreads, batch_task, &b);
+
+    for (int i = 0; i < Nthreads; i++){
+        arena_destroy(b.arenas[i]);
+    }
+    free(b.arenas);
+    free(b.results);
+    free(b.points);
+    free(b.done);
+    free(custo);
+    tx_input_close(&entrada);
+    pthread_mutex_destroy(&b.lock);
+    return b.erro ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    // With options, the sweep comes from the command line or a configuration file and runs without prompts
+    sim_config cfg;
+    bool headless = argc > 1;
+    if (headless) {
+        config_defaults(&cfg);
+        int ret = config_read_args(&cfg, argc, argv);
+        if (ret != 0) {
+            return ret < 0 ? 1 : 0;
+        }
+        if (config_validate(&cfg) != 0) {
+            return 1;
+        }
+    }
+    // One seed per run; every test draws from its own stream of it
+    uint64_t semente = headless ? cfg.seed : (uint64_t) time(NULL);
+    rng_definir_semente(semente);
+    if (!headless) {
+        system("clear");
+    }
     char exec_path[1024];
     #ifdef __unix__
     // Código específico para sistemas Unix
@@ -1005,7 +1718,6 @@ int main() {
         snprintf(destino, sizeof(destino), "%s/testes", exec_absolute_dirname_path);
         char filename[PATH_MAX];
         snprintf(filename, sizeof(filename), "%s/Tx_msg", destino);
-        char fileName[PATH_MAX];
         if (access(destino, F_OK) == 0) {
             printf("The test folder exists! Ready to start!\n");
         }else{
@@ -1034,8 +1746,7 @@ int main() {
                 snprintf(destino, sizeof(destino), "%s/testes", exec_absolute_dirname_path);
                 char filename[PATH_MAX];
                 snprintf(filename, sizeof(filename), "%s/Tx_msg", destino);
-                char fileName[PATH_MAX];
-                if (access(destino, F_OK) == 0) {
+                        if (access(destino, F_OK) == 0) {
                     printf("A pasta testes existe! Pronto para iniciar!\n");
                 }else{
                     // Cria a pasta testes
@@ -1057,7 +1768,6 @@ int main() {
             char *exec_absolute_dirname_path = dirname(exec_absolute_path);
             char filename[MAX_PATH];
             snprintf(filename, sizeof(filename), "%s/Tx_msg", destino);
-            char fileName[MAX_PATH];
             if (access(destino, F_OK) == 0) {
                 printf("Legal! A pasta testes existe! Pronto para iniciar!\n");
             }else{
@@ -1071,24 +1781,44 @@ int main() {
     #else 
         #error Plataforma de sistema operacional não suportada
     #endif
+    if (headless) {
+        if (cfg.tests_dir[0] == '\0') {
+            return run_batch(&cfg, destino);
+        }
+        if (access(cfg.tests_dir, F_OK) != 0 && mkdir(cfg.tests_dir, 0777) != 0) {
+            printf("Unable to create the folder %s\n", cfg.tests_dir);
+            return 1;
+        }
+        return run_batch(&cfg, cfg.tests_dir);
+    }
     FILE *fp;
     fp = fopen(filename, "w+");
     // Ask the user to write the message
     printf("Enter the message you want to send:\n");
-    char mensagem[50000];
-    fgets(mensagem, sizeof(mensagem), stdin);
+    // The message may be of any length: getline grows the buffer as needed
+    char *mensagem = NULL;
+    size_t tamanho = 0;
+    if (getline(&mensagem, &tamanho, stdin) < 0) {
+        printf("No message given\n");
+        fclose(fp);
+        return 1;
+    }
     // Write the message to the file
     fprintf(fp, "%s", mensagem);
+    free(mensagem);
     // Close the file
     fclose(fp);
-    int Nr, Nt, r;
+    int Nr, Nt;
+    double EsN0_dB;
+    // Es/N0 grid of the pre-setting mode, in dB
+    static const double snr_grid_dB[] = {30, 20, 10, 0};
     int mode;
     int num_teste = 30; // number of predefined tests
     printf("Enter 1 for default mode or 2 for custom mode: ");
     scanf("%d", &mode);
     
     if (mode == 2) {
-        getUserInput(&Nr, &Nt, &r);
+        getUserInput(&Nr, &Nt, &EsN0_dB);
         num_teste = 25; // only one test will be run in custom mode
     }
     if(num_teste > 61){
@@ -1098,20 +1828,15 @@ int main() {
     }
     printf("How many tests do you want to perform? (1-61): ");
     scanf("%d", &num_teste);
+    // Every allocation of a test comes from this arena and is released at once at the end of the test
+    arena *arena_teste = arena_create(0);
+    arena_usar(arena_teste);
+    // The message is read once and shared by all the tests
+    tx_input entrada;
+    if (tx_input_open(&entrada, filename) != 0){
+        return 1;
+    }
     for(int teste = 1; teste <= num_teste; teste++){
-            
-        printf("\n===================== Test %d ===================\n\n", teste);
-        fp = fopen(filename, "rb");
-        if (fp == NULL) {
-            printf("Unable to open the file\n");
-            return 1; // Ends the program if the file opening fails
-        }
-        // Calculating the number of bytes in the file.
-        printf("File created successfully!\n");
-        fseek(fp, 0, SEEK_END);
-        long int numBytes = ftell(fp);
-        fseek(fp, 0, SEEK_SET);
-
         // Número de antenas recpetoras
         // Número de antenas transmissoras
         if(mode == 1) {
@@ -1152,105 +1877,17 @@ int main() {
                 Nt = 1024;
             }
 
-            // Choosing noise interval: 0 for [-0.01,0.01], 1 for [-0.1,0.1], 2 for [-0.5,0.5], 3 for [-1,1]
-            r = (teste - 1) % 4;
-            // r = 3;
-        }
-        //Declarando o número de fluxos
-        int Nstream;
-        if (Nr <= Nt){
-            Nstream = Nr;
-        }else{
-            Nstream = Nt;
-        }
-        printf("\nNumber of receiving antennas Nr: %d\nNumber of transmitting antennas Nt: %d\nNumber of streams Nstream: %d", Nr, Nt, Nstream);
-        // Reading the file
-        printf("\nReading the file...");
-        int * s= tx_data_read(fp, numBytes);
-        // Calculating number of symbols necessary for (numBytes*4 + Npadding) % Nstream == 0.
-        int Npadding;
-        if ((numBytes*4) % Nstream == 0){
-            Npadding = 0;
-        }else{ 
-            Npadding = (Nstream - (numBytes*4)%Nstream);
-        }
-        printf("\nAmount of padding symbols: %d", Npadding);
-        // Padding through data_padding
-        int *pad = tx_data_padding(s, numBytes, Npadding);
-        // Calculating number of symbols
-        long int Nsymbol = (numBytes*4 + Npadding);
-        // Mapping the file bits
-        complexo *map = tx_qam_mapper(pad, Nsymbol);
-        // Transforming the complex vector from the mapping to a complex matrix with Nstream rows
-        printf("\nMapping the stream matrix Nstream x (Nsymbols/Nstream)...");
-        complexo **mtx= tx_layer_mapper(map, Nstream, Nsymbol);
-        complexo **rx_mtx= allocateComplexMatrix(Nstream, Nsymbol/Nstream); // receiving matrix
-        // Creating the H Channel with range between -1 and 1
-        printf("\nCreating data transfer channel...");
-        complexo ** H = channel_gen(Nr, Nt, 1);
-        // Starting transmission through the channel of Nsymbol/Nstream transmission times
-        printf("\nStarting transmission segmentation...");
-        for (int Nx = 0; Nx < Nsymbol/Nstream; Nx++){
-            complexo ** x = allocateComplexMatrix(Nstream, 1);
-            for(int l = 0; l < Nstream; l++){
-                x[l][0].real = mtx[l][Nx].real;
-                x[l][0].img = mtx[l][Nx].img;
-            }
-            if (Nr < Nt){
-                printf("\nTransmission of vector v%d from the data matrix in stream...", Nx);
-                complexo ** T = transposta(H, Nr, Nt);
-                complexo ** U = allocateComplexMatrix(Nr, Nr);
-                complexo ** S = allocateComplexMatrix(Nr, Nr);
-                complexo ** V = allocateComplexMatrix(Nt, Nr);
-                transposed_channel_svd(T, V, S, U, Nt, Nr);
-                complexo ** xp = tx_precoder (V, x, Nt, Nr, Nstream, 1);
-                complexo ** xt = channel_transmission(H, xp, Nr, Nt, Nt, 1, r);
-                complexo ** xc = rx_combiner(U, xt, Nr, Nr, Nstream, 1);
-                complexo ** xf = rx_feq(S, xc, Nr, Nr, Nstream, 1);
-                for(int l = 0; l < Nstream; l++){
-                    rx_mtx[l][Nx].real = xf[l][0].real;
-                    rx_mtx[l][Nx].img = xf[l][0].img;
-                }
-            }else if (Nr >= Nt){
-                complexo ** x = allocateComplexMatrix(Nstream, 1);
-                for(int l = 0; l < Nstream; l++){
-                    x[l][0].real = mtx[l][Nx].real;
-                    x[l][0].img = mtx[l][Nx].img;
-                }
-                printf("\nTransmission of vector v%d from the data matrix in stream...", Nx);
-                complexo ** U = allocateComplexMatrix(Nr, Nt);
-                complexo ** S = allocateComplexMatrix(Nt, Nt);
-                complexo ** V = allocateComplexMatrix(Nt, Nt);
-                square_channel_svd(H, U, S, V, Nr, Nt);
-                complexo ** xp = tx_precoder (V, x, Nt, Nt, Nstream, 1);
-                complexo ** xt = channel_transmission(H, xp, Nr, Nt, Nt, 1, r);
-                complexo ** xc = rx_combiner(U, xt, Nr, Nt, Nr, 1);
-                complexo ** xf = rx_feq(S, xc, Nt, Nt, Nstream, 1);
-                for(int l = 0; l < Nstream; l++){
-                    rx_mtx[l][Nx].real = xf[l][0].real;
-                    rx_mtx[l][Nx].img = xf[l][0].img;
-                }
-            }
+            // Choosing the Es/N0 of the test from the grid
+            EsN0_dB = snr_grid_dB[(teste - 1) % 4];
         }
-        printf("\nComposing the complex vector rx_map..");
-        complexo *rx_map = rx_layer_demapper(rx_mtx, Nstream, Nsymbol);
-        for(int i = 0; i < Nsymbol; i++){
-            rx_map[i].real = round(rx_map[i].real);
-            rx_map[i].img = round(rx_map[i].img);
+        test_result res;
+        if (run_test(&entrada, destino, NULL, teste, modulation_get(TX_MODULATION), CHANNEL_REAL, 0, Nr, Nt, EsN0_dB, TX_BLOCK_WIDTH, TX_CHUNK_WIDTH, false, semente, &res) != 0){
+            return 1; // Ends the program if the file opening fails
         }
-        // Desmapeamento dos bits do arquivo
-        printf("\nPerforming file bit demapping in rx_qam_mapper...");
-        int *a = rx_qam_demapper(rx_map, Nsymbol);
-        printf("\nRemoving null symbols in rx_depadding...");
-        int *s_rest = rx_data_depadding(a, numBytes, Nstream);
-        // Final Data Reading
-        printf("\nSaving file with the sent message in the file Test_%d_Nr%d_Nt%d_Rd%d\n", teste, Nr, Nt, r);
-
-        sprintf(fileName, "%s/Test_%d_Nr%d_Nt%d_Rd%d", destino, teste, Nr, Nt, r); // Formats the file name based on the value of i
-        rx_data_write(s_rest, numBytes, fileName);
-        generate_statistics(s, s_rest, numBytes, teste, Nr, Nt, r, mtx, rx_mtx, Nstream, Nsymbol);        
-        printf("================== End of test %d================\n", teste);
+        write_statistics("output.csv", &res);
+        arena_reset(arena_teste);
         }
-    fclose(fp);
+    tx_input_close(&entrada);
+    arena_destroy(arena_teste);
     return 0;
     }
@@ -1,24 +1,117 @@
 #ifndef PDS_TELECOM
 #define PDS_TELECOM
 
-int * tx_data_read(FILE *fp, long int numBytes);
-int * tx_data_padding(int* s, long int numBytes, int Npadding);
-complexo* tx_qam_mapper(int *s, long int numQAM);
+#include <stdio.h>
+#include <stdint.h>
+#include "../matrix/matrix.h"
+#include "stats.h"
+#include "modulation.h"
+
+/** Number of stream vectors (columns of the stream matrix) sent through the channel as one block. 0 sends the whole matrix at once. */
+#ifndef TX_BLOCK_WIDTH
+#define TX_BLOCK_WIDTH 256
+#endif
+
+/** Number of columns of the stream matrix kept in memory at once while a message is streamed through the link. 0 keeps the whole matrix. */
+#ifndef TX_CHUNK_WIDTH
+#define TX_CHUNK_WIDTH 4096
+#endif
+
+/** Number of chunks in flight when the stages of a test run on threads of their own. */
+#ifndef TX_PIPELINE_SLOTS
+#define TX_PIPELINE_SLOTS 4
+#endif
+
+/** Order of the QAM constellation of the interactive mode. */
+#ifndef TX_MODULATION
+#define TX_MODULATION 4
+#endif
+
+/**
+ * @brief The statistics of one test, as written to the CSV file by `write_statistics`.
+ */
+typedef struct test_result {
+    int teste; ///< Test number
+    int Nr; ///< Number of receiving antennas
+    int Nt; ///< Number of transmitting antennas
+    double EsN0_dB; ///< Requested Es/N0, in dB
+    double error_percentage; ///< Percentage of symbols received with errors
+    double ber; ///< Bit error rate
+    double snr_dB; ///< Measured SNR, in dB
+    double evm_dB; ///< Error vector magnitude, in dB
+    double cap; ///< Channel capacity, in bits per symbol
+} test_result;
+
+/** Statistical model of the channel matrix H. */
+typedef enum channel_model {
+    CHANNEL_REAL,    ///< Real Gaussian elements (`channel_gen`)
+    CHANNEL_RAYLEIGH ///< Circular complex Gaussian elements, i.e. Rayleigh fading (`channel_rd_gen`)
+} channel_model;
+
+/**
+ * @brief A channel realization together with the SVD-derived matrices used by the transceiver.
+ *
+ * U is Nr x Nstream, S is Nstream x Nstream and V is Nt x Nstream, with Nstream <= min(Nr, Nt)
+ * the number of eigenmodes carried by the link (`channel_streams`).
+ */
+typedef struct channel_context {
+    int Nr; ///< Number of receiving antennas
+    int Nt; ///< Number of transmitting antennas
+    int Nstream; ///< Number of streams
+    cmatrix H; ///< Channel matrix (Nr x Nt)
+    cmatrix U; ///< Left singular vectors of H
+    cmatrix S; ///< Singular values of H on the diagonal, used by the FEQ
+    cmatrix V; ///< Right singular vectors of H, used as the precoder
+    cmatrix Ut; ///< Combiner, the conjugate transpose of U (Nstream x Nr)
+    int largura; ///< Number of columns the transmission workspace holds (0 before `channel_context_reserve`)
+    cmatrix xp; ///< Workspace: precoded signal (Nt x largura)
+    cmatrix xt; ///< Workspace: transmitted signal plus noise (Nr x largura)
+    cmatrix xc; ///< Workspace: combined signal (Nstream x largura)
+} channel_context;
+
+uint8_t * tx_data_read(FILE *fp, long int numBytes);
+complexo* tx_qam_mapper(const modulacao *mod, const uint8_t *dados, long int Ndados, long int numQAM);
+void tx_qam_mapper_into(const modulacao *mod, complexo *c1, const uint8_t *dados, long int Ndados, long int numQAM);
+void tx_qam_layer_mapper_into(const modulacao *mod, complexo **mtx_stream, const uint8_t *dados, long int Ndados, long int Nsymbol, int Nstream);
 complexo ** tx_layer_mapper(complexo *v, int Nstream, long int Nsymbol);
+void tx_layer_mapper_into(complexo **mtx_stream, complexo *v, int Nstream, long int Nsymbol);
 complexo* rx_layer_demapper(complexo** mtx_stream, int Nstream, long int numBytes);
-int* rx_qam_demapper(complexo * vmap, long int numQAM);
-int *rx_data_depadding(int *s, long int numBytes, int Nstream);
-void rx_data_write(int* s, long int numBytes, char* fileName);
-complexo** produto_matricial_geral(complexo** mtx_a, complexo** mtx_b, int linhas_a, int colunas_a, int linhas_b, int colunas_b);
-complexo ** channel_gen(int Nr, int Nt, float minValue, float maxValue);
-complexo ** channel_rd_gen(int Nr, int Nt, float minValue, float maxValue);
+void rx_layer_demapper_into(complexo *v, complexo** mtx_stream, int Nstream, long int numBytes);
+uint8_t* rx_qam_demapper(const modulacao *mod, const complexo *vmap, long int numQAM);
+void rx_qam_demapper_into(const modulacao *mod, uint8_t *dados, const complexo *vmap, long int numQAM);
+void rx_qam_layer_demapper_into(const modulacao *mod, uint8_t *dados, const cmatrix *xf, long int Ndados);
+void rx_qam_slicer_into(uint8_t *dados, const uint8_t *sinais, long int ld, int Nstream, long int Ndados);
+float* rx_llr_demapper(const modulacao *mod, const cmatrix *xf, const double *variancia, long int Ndados);
+void rx_llr_demapper_into(const modulacao *mod, float *llr, const cmatrix *xf, const double *variancia, long int Ndados);
+void rx_data_write(const uint8_t *dados, long int numBytes, const char* fileName);
+complexo** general_matrix_product(complexo** mtx_a, complexo** mtx_b, int linhas_a, int colunas_a, int linhas_b, int colunas_b);
+void general_matrix_product_into(complexo** dst, complexo** mtx_a, complexo** mtx_b, int linhas_a, int colunas_a, int linhas_b, int colunas_b);
+complexo ** channel_gen(int Nr, int Nt, double sigma);
+complexo ** channel_rd_gen(int Nr, int Nt, double sigma);
+void channel_rd_add(complexo **xh, int Nr, int Nt, double sigma);
+complexo ** channel_draw(channel_model modelo, int Nr, int Nt);
+int channel_streams(int Nr, int Nt, int streams);
+double snr_ebn0_to_esn0(double EbN0_dB, int bits_per_symbol);
+double channel_awgn_add(complexo **xt, int linhas, int colunas, double EsN0_dB);
 void transposed_channel_svd(complexo **H, complexo **Uh, complexo **Sh, complexo **Vh, int Tlinhas, int Tcolunas);
 void square_channel_svd(complexo **H, complexo**Uh, complexo**Sh, complexo**Vh, int linhas, int colunas);
 complexo ** tx_precoder(complexo ** V, complexo **x, int Vlinhas, int Vcolunas, int xlinhas, int xcolunas);
-complexo ** channel_transmission(complexo ** H, complexo ** xp, int Hlinhas, int Hcolunas, int xpLinhas, int xpColunas, int r);
+void tx_precoder_into(complexo **xp, complexo ** V, complexo **x, int Vlinhas, int Vcolunas, int xlinhas, int xcolunas);
+complexo ** channel_transmission(complexo ** H, complexo ** xp, int Hlinhas, int Hcolunas, int xpLinhas, int xpColunas, double EsN0_dB);
+double channel_transmission_into(complexo **xt, complexo ** H, complexo ** xp, int Hlinhas, int Hcolunas, int xpLinhas, int xpColunas, double EsN0_dB);
 complexo ** rx_combiner(complexo ** U, complexo ** xt, int Ulinhas, int Ucolunas, int xtLinhas, int xtColunas);
+void rx_combiner_into(complexo **xc, complexo ** U, complexo ** xt, int Ulinhas, int Ucolunas, int xtLinhas, int xtColunas);
 complexo ** rx_feq(complexo ** S, complexo ** xc, int Slinhas, int Scolunas, int xcLinhas, int xcColunas);
-void gera_estatistica(int *s, int *finals, long int numBytes);
+void rx_feq_into(complexo ** xf, complexo ** S, complexo ** xc, int Slinhas, int Scolunas, int xcLinhas, int xcColunas);
+channel_context * channel_context_create(complexo **H, int Nr, int Nt, int Nstream);
+void channel_context_free(channel_context *ctx);
+void channel_context_reserve(channel_context *ctx, int largura);
+cmatrix channel_context_transmit(channel_context *ctx, const cmatrix *x, double EsN0_dB);
+double channel_context_transmit_into(channel_context *ctx, const cmatrix *x, cmatrix *xf, uint8_t *sinais, double EsN0_dB);
+void channel_context_noise_variance(const channel_context *ctx, double N0, double *variancia);
+void channel_context_transmit_blocks(channel_context *ctx, const cmatrix *mtx, cmatrix *rx_mtx, uint8_t *sinais, double *ruido, int largura, long int coluna0, double EsN0_dB, stats_acc *acc);
+void generate_statistics(const stats_acc *acc, int teste, int Nr, int Nt, double EsN0_dB, test_result *res);
+int write_statistics(const char *csv, const test_result *res);
 complexo** expandMatrix(complexo** matriz, int linhas, int colunas, int linhasExtras, int padding);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,215 @@
+/// @file pipeline.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+#include "pipeline.h"
+
+/** Busy-wait rounds before a waiting end of a ring yields the processor. */
+#define PIPELINE_SPIN 64
+
+/**
+ * @brief Creates an empty ring with room for at least `capacidade` items.
+ *
+ * @return 0 on success, or -1 if the memory cannot be allocated.
+ */
+int spsc_init(spsc_ring *r, size_t capacidade){
+    size_t n = 1;
+    while (n < capacidade){
+        n <<= 1;
+    }
+    r->itens = malloc(n * sizeof(void *));
+    if (r->itens == NULL){
+        printf("Error in memory allocation\n");
+        return -1;
+    }
+    r->capacidade = n;
+    atomic_init(&r->cabeca, 0);
+    atomic_init(&r->cauda, 0);
+    return 0;
+}
+
+/** Releases the memory of a ring. */
+void spsc_destroy(spsc_ring *r){
+    free(r->itens);
+    r->itens = NULL;
+}
+
+/**
+ * @brief Pushes an item if the ring is not full. Only the producer thread may call it.
+ *
+ * @return true if the item was pushed.
+ */
+bool spsc_try_push(spsc_ring *r, void *item){
+    size_t cauda = atomic_load_explicit(&r->cauda, memory_order_relaxed);
+    if (cauda - atomic_load_explicit(&r->cabeca, memory_order_acquire) == r->capacidade){
+        return false;
+    }
+    r->itens[cauda & (r->capacidade - 1)] = item;
+    // The item is visible to the consumer before the new tail
+    atomic_store_explicit(&r->cauda, cauda + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Pops an item if the ring is not empty. Only the consumer thread may call it.
+ *
+ * @return true if an item was popped into `item`.
+ */
+bool spsc_try_pop(spsc_ring *r, void **item){
+    size_t cabeca = atomic_load_explicit(&r->cabeca, memory_order_relaxed);
+    if (cabeca == atomic_load_explicit(&r->cauda, memory_order_acquire)){
+        return false;
+    }
+    *item = r->itens[cabeca & (r->capacidade - 1)];
+    // The position is read before the producer may reuse it
+    atomic_store_explicit(&r->cabeca, cabeca + 1, memory_order_release);
+    return true;
+}
+
+/** Pushes an item, waiting while the ring is full. */
+void spsc_push(spsc_ring *r, void *item){
+    for (int i = 0; !spsc_try_push(r, item); i++){
+        if (i >= PIPELINE_SPIN){
+            sched_yield();
+        }
+    }
+}
+
+/** Pops an item, waiting while the ring is empty. */
+void *spsc_pop(spsc_ring *r){
+    void *item;
+    for (int i = 0; !spsc_try_pop(r, &item); i++){
+        if (i >= PIPELINE_SPIN){
+            sched_yield();
+        }
+    }
+    return item;
+}
+
+/** A stage and the rings around it. */
+typedef struct pipeline_worker {
+    const pipeline_stage *estagio; ///< The stage
+    spsc_ring *entrada; ///< Slots to be processed, ended by NULL
+    spsc_ring *saida; ///< Processed slots
+    bool ultimo; ///< Whether this is the last stage, whose slots go back to the source
+} pipeline_worker;
+
+/** Loop of a stage after the source: processes every slot until the end of the stream, which is passed on. */
+static void *worker_main(void *arg){
+    pipeline_worker *w = arg;
+    void *slot;
+    while ((slot = spsc_pop(w->entrada)) != NULL){
+        w->estagio->processa(slot, w->estagio->ctx);
+        spsc_push(w->saida, slot);
+    }
+    if (!w->ultimo){
+        spsc_push(w->saida, NULL);
+    }
+    return NULL;
+}
+
+/** Runs every stage on each slot in turn, in the calling thread. */
+static void run_sequential(const pipeline_stage *estagios, int Nestagios, void *slot){
+    while (estagios[0].processa(slot, estagios[0].ctx)){
+        for (int k = 1; k < Nestagios; k++){
+            estagios[k].processa(slot, estagios[k].ctx);
+        }
+    }
+}
+
+/**
+ * @brief Runs a pipeline of stages over a stream of slots.
+ *
+ * With `threads`, every stage after the first runs on a thread of its own and the source runs on
+ * the calling thread. Consecutive stages are connected by `spsc_ring`s, and the last stage hands
+ * the slots back to the source through another ring. The `Nslots` slots are all that circulate:
+ * when they are all in flight the source waits for the last stage, so the memory in use is bounded
+ * by the slots whatever the length of the stream, and a slow stage holds back the ones before it.
+ * Each slot goes through the stages in order and the slots go through each stage in the order the
+ * source filled them, so the result of a stage does not depend on the threads.
+ *
+ * Without `threads`, or if a thread cannot be created, the stages run one after another on each
+ * slot in the calling thread, using only the first slot.
+ *
+ * @param estagios The stages, starting with the source.
+ * @param Nestagios The number of stages.
+ * @param slots The slots (non-NULL).
+ * @param Nslots The number of slots.
+ * @param threads Whether each stage runs on its own thread.
+ *
+ * @return 0 on success, or -1 if the rings cannot be allocated.
+ */
+int pipeline_run(const pipeline_stage *estagios, int Nestagios, void **slots, int Nslots, bool threads){
+    if (!threads || Nestagios < 2 || Nslots < 2){
+        run_sequential(estagios, Nestagios, slots[0]);
+        return 0;
+    }
+    // Ring k feeds stage k; ring 0 takes the slots back from the last stage to the source
+    spsc_ring *aneis = calloc(Nestagios, sizeof(spsc_ring));
+    pipeline_worker *workers = calloc(Nestagios, sizeof(pipeline_worker));
+    pthread_t *ids = calloc(Nestagios, sizeof(pthread_t));
+    if (aneis == NULL || workers == NULL || ids == NULL){
+        printf("Error in memory allocation\n");
+        free(aneis);
+        free(workers);
+        free(ids);
+        return -1;
+    }
+    int prontos = 0;
+    while (prontos < Nestagios && spsc_init(&aneis[prontos], Nslots + 1) == 0){
+        prontos++;
+    }
+    if (prontos < Nestagios){
+        for (int k = 0; k < prontos; k++){
+            spsc_destroy(&aneis[k]);
+        }
+        free(aneis);
+        free(workers);
+        free(ids);
+        return -1;
+    }
+    for (int i = 0; i < Nslots; i++){
+        spsc_push(&aneis[0], slots[i]);
+    }
+
+    int iniciados = 1;
+    for (int k = 1; k < Nestagios; k++){
+        workers[k].estagio = &estagios[k];
+        workers[k].entrada = &aneis[k];
+        workers[k].ultimo = (k == Nestagios - 1);
+        workers[k].saida = workers[k].ultimo ? &aneis[0] : &aneis[k + 1];
+        if (pthread_create(&ids[k], NULL, worker_main, &workers[k]) != 0){
+            break;
+        }
+        iniciados++;
+    }
+
+    if (iniciados == Nestagios){
+        // Source: fills the free slots until the input is exhausted
+        for (;;){
+            void *slot = spsc_pop(&aneis[0]);
+            if (!estagios[0].processa(slot, estagios[0].ctx)){
+                break;
+            }
+            spsc_push(&aneis[1], slot);
+        }
+        spsc_push(&aneis[1], NULL);
+    }else{
+        // The stages that did start only see the end of the stream, and the pipeline runs here instead
+        spsc_push(&aneis[1], NULL);
+        run_sequential(estagios, Nestagios, slots[0]);
+    }
+    for (int k = 1; k < iniciados; k++){
+        pthread_join(ids[k], NULL);
+    }
+
+    for (int k = 0; k < Nestagios; k++){
+        spsc_destroy(&aneis[k]);
+    }
+    free(aneis);
+    free(workers);
+    free(ids);
+    return 0;
+}
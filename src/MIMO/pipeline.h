@@ -0,0 +1,45 @@
+#ifndef PDS_PIPELINE
+#define PDS_PIPELINE
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+/** Size of a cache line, used to keep the two ends of a ring apart. */
+#define PIPELINE_CACHE_LINE 64
+
+/**
+ * @brief A bounded single-producer/single-consumer queue of pointers, without locks.
+ *
+ * One thread pushes and one thread pops. Each end owns its own index, published to the other end
+ * with release/acquire atomics, so neither end ever waits on a lock. A full ring makes the
+ * producer wait (backpressure) and an empty ring makes the consumer wait.
+ */
+typedef struct spsc_ring {
+    _Alignas(PIPELINE_CACHE_LINE) atomic_size_t cabeca; ///< Next position to be popped, written by the consumer
+    _Alignas(PIPELINE_CACHE_LINE) atomic_size_t cauda; ///< Next position to be pushed, written by the producer
+    _Alignas(PIPELINE_CACHE_LINE) size_t capacidade; ///< Number of positions, a power of two
+    void **itens; ///< The positions
+} spsc_ring;
+
+/**
+ * @brief One stage of a pipeline, applied in place to every slot that goes through it.
+ *
+ * The first stage is the source: it fills the slot it is given and returns false, leaving the
+ * slot unused, when there is nothing left to send. The return value of the other stages is ignored.
+ */
+typedef struct pipeline_stage {
+    bool (*processa)(void *slot, void *ctx); ///< Processes one slot
+    void *ctx; ///< Context of the stage
+} pipeline_stage;
+
+int spsc_init(spsc_ring *r, size_t capacidade);
+void spsc_destroy(spsc_ring *r);
+bool spsc_try_push(spsc_ring *r, void *item);
+bool spsc_try_pop(spsc_ring *r, void **item);
+void spsc_push(spsc_ring *r, void *item);
+void *spsc_pop(spsc_ring *r);
+
+int pipeline_run(const pipeline_stage *estagios, int Nestagios, void **slots, int Nslots, bool threads);
+
+#endif
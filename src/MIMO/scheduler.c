@@ -0,0 +1,233 @@
+/// @file scheduler.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "scheduler.h"
+
+/** The queue of one thread: the items in [head, tail) of `items`, in decreasing cost. */
+typedef struct sched_queue {
+    pthread_mutex_t lock; ///< Protects head, tail and remaining
+    int *items; ///< Item indices given to this thread
+    int head; ///< Next item of the owner (the most expensive one left)
+    int tail; ///< One past the item a thief takes (the cheapest one left)
+    double remaining; ///< Total cost of the items left
+} sched_queue;
+
+/** State shared by the threads of one `sched_run`. */
+typedef struct sched_pool {
+    sched_queue *queues;
+    int Nthreads;
+    const double *cost;
+    sched_task task;
+    void *ctx;
+} sched_pool;
+
+typedef struct sched_worker {
+    sched_pool *pool;
+    int id;
+} sched_worker;
+
+typedef struct sched_entry {
+    double cost;
+    int item;
+} sched_entry;
+
+static double item_cost(const sched_pool *pool, int item){
+    return pool->cost != NULL ? pool->cost[item] : 1.0;
+}
+
+static int compare_entries(const void *a, const void *b){
+    const sched_entry *x = a, *y = b;
+    if (x->cost != y->cost){
+        return x->cost < y->cost ? 1 : -1;
+    }
+    return x->item - y->item;
+}
+
+/** Takes the most expensive item left in the thread's own queue, or returns -1. */
+static int pop_own(sched_pool *pool, sched_queue *q){
+    int item = -1;
+    pthread_mutex_lock(&q->lock);
+    if (q->head < q->tail){
+        item = q->items[q->head++];
+        q->remaining -= item_cost(pool, item);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return item;
+}
+
+/** Takes the cheapest item of the queue with the most work left, or returns -1 when every queue is empty. */
+static int steal(sched_pool *pool, int self){
+    for (;;){
+        int victim = -1;
+        double most = 0;
+        for (int i = 0; i < pool->Nthreads; i++){
+            if (i == self){
+                continue;
+            }
+            sched_queue *q = &pool->queues[i];
+            pthread_mutex_lock(&q->lock);
+            if (q->head < q->tail && (victim < 0 || q->remaining > most)){
+                victim = i;
+                most = q->remaining;
+            }
+            pthread_mutex_unlock(&q->lock);
+        }
+        if (victim < 0){
+            return -1;
+        }
+        sched_queue *q = &pool->queues[victim];
+        int item = -1;
+        pthread_mutex_lock(&q->lock);
+        if (q->head < q->tail){
+            item = q->items[--q->tail];
+            q->remaining -= item_cost(pool, item);
+        }
+        pthread_mutex_unlock(&q->lock);
+        // The victim may have been emptied in the meantime; look again
+        if (item >= 0){
+            return item;
+        }
+    }
+}
+
+static void *worker_main(void *arg){
+    sched_worker *w = arg;
+    sched_pool *pool = w->pool;
+    for (;;){
+        int item = pop_own(pool, &pool->queues[w->id]);
+        if (item < 0){
+            item = steal(pool, w->id);
+        }
+        if (item < 0){
+            return NULL;
+        }
+        pool->task(item, w->id, pool->ctx);
+    }
+}
+
+/** Deals the items out to the queues, longest processing time first, keeping each queue in decreasing cost. */
+static void deal_items(sched_pool *pool, int Nitems, sched_entry *entries, int *items, int *count, int *owner){
+    for (int i = 0; i < Nitems; i++){
+        entries[i].cost = item_cost(pool, i);
+        entries[i].item = i;
+    }
+    qsort(entries, Nitems, sizeof(sched_entry), compare_entries);
+    for (int i = 0; i < Nitems; i++){
+        int lightest = 0;
+        for (int t = 1; t < pool->Nthreads; t++){
+            if (pool->queues[t].remaining < pool->queues[lightest].remaining){
+                lightest = t;
+            }
+        }
+        owner[i] = lightest;
+        pool->queues[lightest].remaining += entries[i].cost;
+        count[lightest]++;
+    }
+    // The queues share one array, each in its own slice, keeping the decreasing order
+    int offset = 0;
+    for (int t = 0; t < pool->Nthreads; t++){
+        pthread_mutex_init(&pool->queues[t].lock, NULL);
+        pool->queues[t].items = items + offset;
+        pool->queues[t].head = 0;
+        pool->queues[t].tail = 0;
+        offset += count[t];
+    }
+    for (int i = 0; i < Nitems; i++){
+        sched_queue *q = &pool->queues[owner[i]];
+        q->items[q->tail++] = entries[i].item;
+    }
+}
+
+/** Starts the threads, runs worker 0 in the calling thread and waits for the others. */
+static void run_workers(sched_pool *pool, pthread_t *threads, sched_worker *workers, int *started){
+    for (int t = 0; t < pool->Nthreads; t++){
+        workers[t].pool = pool;
+        workers[t].id = t;
+    }
+    // A thread that cannot be created leaves its items to be stolen by the others
+    for (int t = 1; t < pool->Nthreads; t++){
+        started[t] = pthread_create(&threads[t], NULL, worker_main, &workers[t]) == 0;
+    }
+    worker_main(&workers[0]);
+    for (int t = 1; t < pool->Nthreads; t++){
+        if (started[t]){
+            pthread_join(threads[t], NULL);
+        }
+    }
+    for (int t = 0; t < pool->Nthreads; t++){
+        pthread_mutex_destroy(&pool->queues[t].lock);
+    }
+}
+
+/**
+ * @brief Returns the number of processors available to the program.
+ *
+ * @return The number of online processors, at least 1.
+ */
+int sched_available_threads(void){
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int) n : 1;
+}
+
+/**
+ * @brief Runs independent work items on a pool of threads with work stealing.
+ *
+ * The items are first dealt out by estimated cost, the most expensive first, each one to the
+ * thread with the least work so far, so large and small items are spread evenly from the start.
+ * Each thread runs its own items from the most expensive down; a thread that runs out steals the
+ * cheapest item left in the queue with the most remaining work, which absorbs the error of the
+ * cost estimates. The calling thread is worker 0.
+ *
+ * The order in which items run depends on the timing of the threads. Tasks that must give the
+ * same results for any number of threads have to depend only on their item index (e.g. draw their
+ * random numbers from a stream of that index) and leave ordered output to the caller.
+ *
+ * @param Nitems The number of items.
+ * @param cost The estimated cost of each item, in any unit, or NULL if they all cost the same.
+ * @param Nthreads The number of threads (0 for `sched_available_threads`). Never more than Nitems are used.
+ * @param task The function run for each item.
+ * @param ctx The context passed to `task`.
+ *
+ * @return The number of threads used, or -1 if the memory for the queues could not be allocated.
+ */
+int sched_run(int Nitems, const double *cost, int Nthreads, sched_task task, void *ctx){
+    if (Nitems <= 0){
+        return 0;
+    }
+    if (Nthreads <= 0){
+        Nthreads = sched_available_threads();
+    }
+    if (Nthreads > Nitems){
+        Nthreads = Nitems;
+    }
+
+    sched_pool pool = {NULL, Nthreads, cost, task, ctx};
+    pool.queues = calloc(Nthreads, sizeof(sched_queue));
+    sched_entry *entries = malloc(Nitems * sizeof(sched_entry));
+    int *items = malloc(Nitems * sizeof(int));
+    int *count = calloc(Nthreads, sizeof(int));
+    int *owner = malloc(Nitems * sizeof(int));
+    pthread_t *threads = malloc(Nthreads * sizeof(pthread_t));
+    sched_worker *workers = malloc(Nthreads * sizeof(sched_worker));
+    int *started = calloc(Nthreads, sizeof(int));
+    int ok = pool.queues != NULL && entries != NULL && items != NULL && count != NULL && owner != NULL && threads != NULL && workers != NULL && started != NULL;
+    if (ok){
+        deal_items(&pool, Nitems, entries, items, count, owner);
+        run_workers(&pool, threads, workers, started);
+    }else{
+        printf("Error in memory allocation\n");
+        Nthreads = -1;
+    }
+    free(threads);
+    free(workers);
+    free(started);
+    free(pool.queues);
+    free(entries);
+    free(items);
+    free(count);
+    free(owner);
+    return Nthreads;
+}
@@ -0,0 +1,16 @@
+#ifndef PDS_SCHEDULER
+#define PDS_SCHEDULER
+
+/**
+ * @brief A work item of the scheduler.
+ *
+ * @param item The index of the item, between 0 and Nitems - 1.
+ * @param worker The index of the thread running it, between 0 and Nthreads - 1, for per-thread state.
+ * @param ctx The context given to `sched_run`.
+ */
+typedef void (*sched_task)(int item, int worker, void *ctx);
+
+int sched_available_threads(void);
+int sched_run(int Nitems, const double *cost, int Nthreads, sched_task task, void *ctx);
+
+#endif
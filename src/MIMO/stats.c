@@ -0,0 +1,216 @@
+/// @file stats.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../matrix/matrix.h"
+#include "../matrix/simd.h"
+#include "../matrix/arena.h"
+#include "stats.h"
+
+/**
+ * @brief Adds one sample to a running mean and variance.
+ *
+ * @param w The accumulator.
+ * @param x The sample.
+ */
+void welford_add(welford *w, double x){
+    w->n++;
+    double delta = x - w->media;
+    w->media += delta / w->n;
+    w->m2 += delta * (x - w->media);
+}
+
+/**
+ * @brief Merges the samples of `src` into `dst`, as if they had been added to `dst` one by one.
+ *
+ * @param dst The accumulator that receives the samples.
+ * @param src The accumulator merged into dst.
+ */
+void welford_merge(welford *dst, const welford *src){
+    if (src->n == 0){
+        return;
+    }
+    if (dst->n == 0){
+        *dst = *src;
+        return;
+    }
+    long long n = dst->n + src->n;
+    double delta = src->media - dst->media;
+    dst->m2 += src->m2 + delta * delta * ((double) dst->n * src->n / n);
+    dst->media += delta * src->n / n;
+    dst->n = n;
+}
+
+/**
+ * @brief Returns the sample variance of a running accumulator (0 with fewer than 2 samples).
+ */
+double welford_variance(const welford *w){
+    return w->n > 1 ? w->m2 / (w->n - 1) : 0;
+}
+
+/**
+ * @brief Creates an empty accumulator for `Nstream` streams.
+ *
+ * @param acc The accumulator.
+ * @param Nstream The number of streams.
+ * @param bits_per_symbol The number of bits carried by each data symbol.
+ *
+ * @note The per-stream breakdown is allocated with `arena_malloc`; release it with `stats_free`.
+ */
+void stats_init(stats_acc *acc, int Nstream, int bits_per_symbol){
+    acc->Nstream = Nstream;
+    acc->bits_per_symbol = bits_per_symbol;
+    acc->stream = (stats_stream *) arena_malloc(Nstream * sizeof(stats_stream));
+    stats_reset(acc);
+}
+
+/** Releases the per-stream breakdown of an accumulator. */
+void stats_free(stats_acc *acc){
+    arena_free(acc->stream);
+    acc->stream = NULL;
+}
+
+/** Clears an accumulator, keeping its number of streams. */
+void stats_reset(stats_acc *acc){
+    memset(acc->stream, 0, acc->Nstream * sizeof(stats_stream));
+}
+
+/**
+ * @brief Merges the statistics of `src` into `dst`. Both must have the same number of streams.
+ */
+void stats_merge(stats_acc *dst, const stats_acc *src){
+    if (dst->Nstream != src->Nstream){
+        printf("Error: accumulators with %d and %d streams cannot be merged\n", dst->Nstream, src->Nstream);
+        exit(1);
+    }
+    for (int l = 0; l < dst->Nstream; l++){
+        stats_stream *d = &dst->stream[l];
+        const stats_stream *s = &src->stream[l];
+        d->symbols += s->symbols;
+        d->symbol_errors += s->symbol_errors;
+        d->bit_errors += s->bit_errors;
+        d->error_power += s->error_power;
+        d->signal_power += s->signal_power;
+        welford_merge(&d->erro, &s->erro);
+    }
+}
+
+/**
+ * @brief Accumulates the error and signal powers of one block of the stream matrix.
+ *
+ * Row l of `x` and `y` is stream l. The powers run on the SIMD kernels, one row at a time, and
+ * each symbol's squared error also feeds the running variance of its stream.
+ *
+ * @param acc The accumulator.
+ * @param x The sent block (Nstream x n). It may be a view of a larger matrix.
+ * @param y The equalized block (Nstream x n). It may be a view of a larger matrix.
+ */
+void stats_add_signal(stats_acc *acc, const cmatrix *x, const cmatrix *y){
+    for (int l = 0; l < acc->Nstream; l++){
+        stats_stream *st = &acc->stream[l];
+        const complexo *xl = &CMATRIX_AT(*x, l, 0);
+        const complexo *yl = &CMATRIX_AT(*y, l, 0);
+        st->error_power += cvec_error_power(xl, yl, x->colunas);
+        st->signal_power += cvec_power(yl, x->colunas);
+        for (int j = 0; j < x->colunas; j++){
+            double er = xl[j].real - yl[j].real, ei = xl[j].img - yl[j].img;
+            welford_add(&st->erro, er * er + ei * ei);
+        }
+    }
+}
+
+/** Reads up to 8 bytes of a packed payload, from `byte` on, as a little-endian word (missing bytes are 0). */
+static uint64_t palavra(const uint8_t *v, long long byte, long long Nbytes){
+    uint64_t w = 0;
+    if (byte + 8 <= Nbytes){
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy(&w, v + byte, 8);
+        return w;
+#endif
+    }
+    for (int k = 0; k < 8 && byte + k < Nbytes; k++){
+        w |= (uint64_t) v[byte + k] << (8 * k);
+    }
+    return w;
+}
+
+/**
+ * @brief Accumulates the symbol and bit errors of a run of data symbols in packed payloads.
+ *
+ * Symbol i of the run takes the bits [i * bits_per_symbol, (i + 1) * bits_per_symbol) of the
+ * payload, least significant bit of each byte first, and is symbol `primeiro + i` of the message,
+ * which the layer mapper places on stream (primeiro + i) % Nstream.
+ *
+ * The payloads are compared 64 bits at a time: the set bits of `s ^ finals` are the
+ * bit errors, counted with popcount, and only the symbols that have some of them are visited to
+ * attribute their errors to a stream. Error-free words cost one XOR each.
+ *
+ * @param acc The accumulator.
+ * @param s The sent payload.
+ * @param finals The received payload.
+ * @param n The number of symbols.
+ * @param primeiro The position of the first symbol in the message.
+ */
+void stats_add_symbols(stats_acc *acc, const uint8_t *s, const uint8_t *finals, long int n, long int primeiro){
+    int b = acc->bits_per_symbol;
+    long long Nbits = (long long) n * b;
+    long long Nbytes = (Nbits + 7) / 8;
+
+    // Symbols of the run on each stream
+    int l0 = (int) (primeiro % acc->Nstream);
+    for (int k = 0; k < acc->Nstream; k++){
+        acc->stream[(l0 + k) % acc->Nstream].symbols += n / acc->Nstream + (k < n % acc->Nstream);
+    }
+
+    long int ultimo = -1; // last symbol counted as an error, which may span two words
+    for (long long p = 0; p < Nbits; p += 64){
+        uint64_t x = palavra(s, p / 8, Nbytes) ^ palavra(finals, p / 8, Nbytes);
+        if (Nbits - p < 64){
+            x &= (1ULL << (Nbits - p)) - 1;
+        }
+        while (x){
+            long int simbolo = (long int) ((p + __builtin_ctzll(x)) / b);
+            // Bits of the word that belong to this symbol or to the ones before it
+            long long fim = (long long) (simbolo + 1) * b - p;
+            uint64_t mascara = fim >= 64 ? ~0ULL : (1ULL << fim) - 1;
+            stats_stream *st = &acc->stream[(primeiro + simbolo) % acc->Nstream];
+            st->bit_errors += __builtin_popcountll(x & mascara);
+            if (simbolo != ultimo){
+                st->symbol_errors++;
+                ultimo = simbolo;
+            }
+            x &= ~mascara;
+        }
+    }
+}
+
+/**
+ * @brief Returns the statistics of all streams together.
+ */
+stats_stream stats_total(const stats_acc *acc){
+    stats_stream t;
+    memset(&t, 0, sizeof(t));
+    for (int l = 0; l < acc->Nstream; l++){
+        const stats_stream *s = &acc->stream[l];
+        t.symbols += s->symbols;
+        t.symbol_errors += s->symbol_errors;
+        t.bit_errors += s->bit_errors;
+        t.error_power += s->error_power;
+        t.signal_power += s->signal_power;
+        welford_merge(&t.erro, &s->erro);
+    }
+    return t;
+}
+
+/** Symbol error rate of the accumulated symbols (0 if there are none). */
+double stats_ser(const stats_acc *acc){
+    stats_stream t = stats_total(acc);
+    return t.symbols > 0 ? (double) t.symbol_errors / t.symbols : 0;
+}
+
+/** Bit error rate of the accumulated symbols (0 if there are none). */
+double stats_ber(const stats_acc *acc){
+    stats_stream t = stats_total(acc);
+    return t.symbols > 0 ? (double) t.bit_errors / ((double) t.symbols * acc->bits_per_symbol) : 0;
+}
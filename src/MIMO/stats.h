@@ -0,0 +1,55 @@
+#ifndef PDS_STATS
+#define PDS_STATS
+
+#include <stdint.h>
+#include "../matrix/matrix.h"
+
+/**
+ * @brief Running mean and variance (Welford's algorithm), mergeable with Chan's formula.
+ */
+typedef struct welford {
+    long long n; ///< Number of samples
+    double media; ///< Mean of the samples
+    double m2; ///< Sum of the squared deviations from the mean
+} welford;
+
+/**
+ * @brief Running statistics of one stream.
+ */
+typedef struct stats_stream {
+    long long symbols; ///< Data symbols compared
+    long long symbol_errors; ///< Data symbols received with errors
+    long long bit_errors; ///< Bits received with errors
+    double error_power; ///< Sum of |x - y|^2 between sent and equalized signals
+    double signal_power; ///< Sum of |y|^2 of the equalized signal
+    welford erro; ///< Distribution of |x - y|^2 per symbol
+} stats_stream;
+
+/**
+ * @brief Running statistics of a transmission, updated block by block.
+ *
+ * Nothing here grows with the length of the message, and two accumulators of the same number of
+ * streams can be merged, e.g. the partial results of different threads or blocks, with the same
+ * result as accumulating everything in one of them.
+ */
+typedef struct stats_acc {
+    int Nstream; ///< Number of streams
+    int bits_per_symbol; ///< Bits carried by each data symbol
+    stats_stream *stream; ///< Per-stream breakdown (Nstream entries)
+} stats_acc;
+
+void welford_add(welford *w, double x);
+void welford_merge(welford *dst, const welford *src);
+double welford_variance(const welford *w);
+
+void stats_init(stats_acc *acc, int Nstream, int bits_per_symbol);
+void stats_free(stats_acc *acc);
+void stats_reset(stats_acc *acc);
+void stats_merge(stats_acc *dst, const stats_acc *src);
+void stats_add_signal(stats_acc *acc, const cmatrix *x, const cmatrix *y);
+void stats_add_symbols(stats_acc *acc, const uint8_t *s, const uint8_t *finals, long int n, long int primeiro);
+stats_stream stats_total(const stats_acc *acc);
+double stats_ser(const stats_acc *acc);
+double stats_ber(const stats_acc *acc);
+
+#endif
@@ -0,0 +1,255 @@
+/// @file arena.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "matrix.h"
+#include "arena.h"
+
+/** Um bloco da arena: o cabeçalho é seguido pelos dados, que começam alinhados a `CMATRIX_ALIGN`. */
+struct arena_bloco {
+    arena_bloco *prox; ///< Próximo bloco da lista
+    size_t capacidade; ///< Tamanho da área de dados, em bytes
+    size_t usado; ///< Bytes já alocados na área de dados
+    char *dados; ///< Início da área de dados
+};
+
+/** Cabeçalho de `CMATRIX_ALIGN` bytes que `arena_malloc` põe antes de cada alocação, para `arena_free` saber a origem dela em O(1). */
+typedef union arena_cabecalho {
+    uint32_t origem; ///< `ARENA_ORIGEM_HEAP` se a memória veio do heap; qualquer outro valor é memória de arena
+    char alinhamento[CMATRIX_ALIGN]; ///< Mantém os dados alinhados a `CMATRIX_ALIGN`
+} arena_cabecalho;
+
+/** Marca das alocações de `arena_malloc` feitas no heap (os bytes "heap" em ASCII). */
+#define ARENA_ORIGEM_HEAP 0x68656170u
+/** Marca das alocações de `arena_malloc` feitas em uma arena. */
+#define ARENA_ORIGEM_ARENA 0x6172656eu
+
+static _Thread_local arena *arena_da_thread = NULL;
+
+static size_t arredonda(size_t bytes)
+{
+    return (bytes + CMATRIX_ALIGN - 1) / CMATRIX_ALIGN * CMATRIX_ALIGN;
+}
+
+static arena_bloco *bloco_novo(size_t capacidade)
+{
+    size_t cabecalho = arredonda(sizeof(arena_bloco));
+    arena_bloco *bloco = (arena_bloco *) aligned_alloc(CMATRIX_ALIGN, cabecalho + capacidade);
+    if (bloco == NULL)
+    {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    bloco->prox = NULL;
+    bloco->capacidade = capacidade;
+    bloco->usado = 0;
+    bloco->dados = (char *) bloco + cabecalho;
+    return bloco;
+}
+
+/**###Arena Creation Function:
+ * The `arena_create` function creates an arena with a first block of `capacidade` bytes (rounded up to `CMATRIX_ALIGN`).
+- A capacity of 0 uses `ARENA_CAPACIDADE_PADRAO`. The arena grows by adding blocks when needed, so the initial capacity only sets how soon that happens.
+- If the allocation fails, the function prints an error message and ends the program with `exit(1)`.
+ * @param[in] capacidade
+ * @param[out] a
+ * */
+arena *arena_create(size_t capacidade)
+{
+    arena *a = (arena *) malloc(sizeof(arena));
+    if (a == NULL)
+    {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    a->primeiro = bloco_novo(arredonda(capacidade == 0 ? ARENA_CAPACIDADE_PADRAO : capacidade));
+    a->atual = a->primeiro;
+    return a;
+}
+
+/**Função: Liberação de uma arena e de todos os seus blocos. Se ela for a arena ativa da thread, a thread fica sem arena ativa. */
+void arena_destroy(arena *a)
+{
+    if (a == NULL)
+    {
+        return;
+    }
+    if (arena_da_thread == a)
+    {
+        arena_da_thread = NULL;
+    }
+    arena_bloco *bloco = a->primeiro;
+    while (bloco != NULL)
+    {
+        arena_bloco *prox = bloco->prox;
+        free(bloco);
+        bloco = prox;
+    }
+    free(a);
+}
+
+/**###Arena Allocation Function:
+ * The `arena_alloc` function returns `bytes` bytes from the current block of the arena, aligned to `CMATRIX_ALIGN`.
+- When the current block is full, the next block of the list is reused if it is large enough (it was left behind by `arena_voltar` or `arena_reset`); otherwise a new block, at least twice as large as the current one, is inserted after it.
+- The memory is released only by `arena_voltar`, `arena_reset` or `arena_destroy`.
+ * @param[in] a, bytes
+ * @param[out] p
+ * */
+void *arena_alloc(arena *a, size_t bytes)
+{
+    size_t tamanho = arredonda(bytes == 0 ? 1 : bytes);
+    arena_bloco *bloco = a->atual;
+    while (bloco->capacidade - bloco->usado < tamanho)
+    {
+        if (bloco->prox != NULL && bloco->prox->capacidade >= tamanho)
+        {
+            bloco = bloco->prox;
+            bloco->usado = 0;
+        }
+        else
+        {
+            size_t capacidade = 2 * bloco->capacidade;
+            arena_bloco *novo = bloco_novo(capacidade > tamanho ? capacidade : tamanho);
+            novo->prox = bloco->prox;
+            bloco->prox = novo;
+            bloco = novo;
+        }
+    }
+    a->atual = bloco;
+    void *p = bloco->dados + bloco->usado;
+    bloco->usado += tamanho;
+    return p;
+}
+
+/**Função: Posição atual da arena, para ser restaurada com `arena_voltar`. */
+arena_marca arena_marcar(const arena *a)
+{
+    arena_marca m;
+    m.bloco = a->atual;
+    m.usado = a->atual->usado;
+    return m;
+}
+
+/**Função: Descarta, em O(1), tudo o que foi alocado depois da marca `m`. Os blocos continuam reservados para as próximas alocações. */
+void arena_voltar(arena *a, arena_marca m)
+{
+    a->atual = m.bloco;
+    a->atual->usado = m.usado;
+}
+
+/**###Arena Reset Function:
+ * The `arena_reset` function discards every allocation of the arena.
+- With a single block this is O(1): the block is simply marked as empty.
+- If the arena had to grow, its blocks are replaced by a single block with their total capacity, which costs one `free` per block and one `malloc`. The next use of the same size fits in that block, so the following resets are O(1) again.
+ * @param[in, out] a
+ * */
+void arena_reset(arena *a)
+{
+    if (a->primeiro->prox != NULL)
+    {
+        arena_bloco *novo = bloco_novo(arena_capacidade(a));
+        arena_bloco *bloco = a->primeiro;
+        while (bloco != NULL)
+        {
+            arena_bloco *prox = bloco->prox;
+            free(bloco);
+            bloco = prox;
+        }
+        a->primeiro = novo;
+    }
+    a->atual = a->primeiro;
+    a->atual->usado = 0;
+}
+
+/**Função: Total de bytes reservados pelos blocos da arena. */
+size_t arena_capacidade(const arena *a)
+{
+    size_t total = 0;
+    for (const arena_bloco *bloco = a->primeiro; bloco != NULL; bloco = bloco->prox)
+    {
+        total += bloco->capacidade;
+    }
+    return total;
+}
+
+/**Função: Verifica se o ponteiro `p` pertence a um bloco da arena. */
+int arena_contem(const arena *a, const void *p)
+{
+    const char *c = (const char *) p;
+    for (const arena_bloco *bloco = a->primeiro; bloco != NULL; bloco = bloco->prox)
+    {
+        if (c >= bloco->dados && c < bloco->dados + bloco->capacidade)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**###Active Arena Function:
+ * The `arena_usar` function sets the arena used by `arena_malloc` (and so by `cmatrix_alloc` and `allocateComplexMatrix`) in the calling thread, and returns the previous one so it can be restored.
+- The active arena is thread-local: each thread of a simulation can work on its own arena without locks.
+- NULL makes the allocations go back to the heap.
+ * @param[in] a
+ * @param[out] anterior
+ * */
+arena *arena_usar(arena *a)
+{
+    arena *anterior = arena_da_thread;
+    arena_da_thread = a;
+    return anterior;
+}
+
+/**Função: Arena ativa da thread atual, ou NULL. */
+arena *arena_ativa(void)
+{
+    return arena_da_thread;
+}
+
+/**###Arena-or-Heap Allocation Function:
+ * The `arena_malloc` function returns `bytes` bytes aligned to `CMATRIX_ALIGN`, from the active arena of the thread or, if there is none, from the heap.
+- Every allocation is preceded by an `arena_cabecalho` of `CMATRIX_ALIGN` bytes that records where it came from, so `arena_free` decides in O(1), without locks, whether to call `free`.
+- If the heap allocation fails, the function prints an error message and ends the program with `exit(1)`.
+ * @param[in] bytes
+ * @param[out] p
+ * */
+void *arena_malloc(size_t bytes)
+{
+    arena_cabecalho *cabecalho;
+    if (arena_da_thread != NULL)
+    {
+        cabecalho = (arena_cabecalho *) arena_alloc(arena_da_thread, sizeof(arena_cabecalho) + bytes);
+        cabecalho->origem = ARENA_ORIGEM_ARENA;
+    }
+    else
+    {
+        cabecalho = (arena_cabecalho *) aligned_alloc(CMATRIX_ALIGN, sizeof(arena_cabecalho) + arredonda(bytes == 0 ? 1 : bytes));
+        if (cabecalho == NULL)
+        {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        cabecalho->origem = ARENA_ORIGEM_HEAP;
+    }
+    return cabecalho + 1;
+}
+
+/**###Arena Free Function:
+ * The `arena_free` function releases memory obtained with `arena_malloc`.
+- The header in front of the allocation tells where it came from. Heap memory goes back with `free`; memory of an arena is recovered only by `arena_voltar`, `arena_reset` or `arena_destroy`, so nothing is done for it, whichever arena is active when it is freed.
+- Memory of an arena must not be freed after the arena was rewound past it; that stays harmless in practice, since only the heap mark, not whatever overwrote the header, leads to `free`.
+ * @param[in] p
+ * */
+void arena_free(void *p)
+{
+    if (p == NULL)
+    {
+        return;
+    }
+    arena_cabecalho *cabecalho = (arena_cabecalho *) p - 1;
+    if (cabecalho->origem == ARENA_ORIGEM_HEAP)
+    {
+        free(cabecalho);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef _H_ARENA
+#define _H_ARENA
+
+#include <stddef.h>
+
+/** Capacidade inicial, em bytes, de uma arena criada com capacidade 0. */
+#define ARENA_CAPACIDADE_PADRAO (1 << 20)
+
+typedef struct arena_bloco arena_bloco;
+
+/** A estrutura `arena` é um alocador por incremento de ponteiro (bump allocator) formado por uma lista de blocos de memória alinhados a `CMATRIX_ALIGN` bytes.
+ *Alocar custa apenas o incremento do ponteiro do bloco atual; nada é liberado individualmente. A memória é recuperada de uma vez com `arena_voltar` (até uma marca, em O(1)) ou `arena_reset` (tudo).
+ `arena_reset` é O(1) enquanto a arena tem um só bloco; se ela cresceu, os blocos são trocados por um único bloco com a capacidade total (um `free` por bloco e um `malloc`), e as chamadas seguintes voltam a ser O(1).
+ `arena_voltar` nunca devolve blocos ao sistema, portanto, depois da primeira iteração, um laço que volta sempre à mesma marca não chama mais `malloc`.
+ */
+typedef struct arena {
+    arena_bloco *primeiro; ///< Primeiro bloco da lista
+    arena_bloco *atual; ///< Bloco de onde sai a próxima alocação
+} arena;
+
+/** Posição de uma arena, guardada por `arena_marcar` e restaurada por `arena_voltar`. */
+typedef struct arena_marca {
+    arena_bloco *bloco; ///< Bloco atual no momento da marca
+    size_t usado; ///< Bytes usados nesse bloco no momento da marca
+} arena_marca;
+
+//Função: Criação de uma arena com um bloco inicial de `capacidade` bytes (0 usa `ARENA_CAPACIDADE_PADRAO`).
+arena *arena_create(size_t capacidade);
+//Função: Liberação de uma arena e de todos os seus blocos.
+void arena_destroy(arena *a);
+//Função: Alocação de `bytes` bytes, alinhados a `CMATRIX_ALIGN`, dentro da arena.
+void *arena_alloc(arena *a, size_t bytes);
+//Função: Posição atual da arena.
+arena_marca arena_marcar(const arena *a);
+//Função: Descarta tudo o que foi alocado depois da marca `m`.
+void arena_voltar(arena *a, arena_marca m);
+//Função: Descarta todas as alocações da arena.
+void arena_reset(arena *a);
+//Função: Total de bytes reservados pelos blocos da arena.
+size_t arena_capacidade(const arena *a);
+//Função: Verifica se o ponteiro `p` pertence a um bloco da arena.
+int arena_contem(const arena *a, const void *p);
+//Função: Define a arena ativa da thread atual (NULL desativa) e retorna a anterior.
+arena *arena_usar(arena *a);
+//Função: Arena ativa da thread atual, ou NULL.
+arena *arena_ativa(void);
+//Função: Alocação na arena ativa ou, se não houver, no heap (alinhada a `CMATRIX_ALIGN`).
+void *arena_malloc(size_t bytes);
+//Função: Liberação de memória obtida com `arena_malloc`: só a do heap é liberada, pelo cabeçalho que a precede.
+void arena_free(void *p);
+#endif
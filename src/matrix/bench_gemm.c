@@ -0,0 +1,147 @@
+/// @file bench_gemm.c
+/// @brief Compares the cache-blocked `matrix_gemm` engine with the previous triple-loop product and with the linked CBLAS library.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "matrix.h"
+#include "gemm.h"
+#include "blas.h"
+
+/** Number of stream vectors multiplied per product, as in a transmission block. */
+#define BENCH_COLUNAS 256
+
+/**
+ * @brief The matrix product as it was implemented before the GEMM engine (i-j-k order over row pointers).
+ */
+static complexo **produto_referencia(complexo **mtx_a, complexo **mtx_b, int linhas_a, int colunas_a, int colunas_b)
+{
+    complexo **matriz = allocateComplexMatrix(linhas_a, colunas_b);
+    for (int l = 0; l < linhas_a; l++)
+    {
+        for (int c = 0; c < colunas_b; c++)
+        {
+            complexo acumulador = {0, 0};
+            for (int i = 0; i < colunas_a; i++)
+            {
+                acumulador = soma_complexo(acumulador, multcomp(mtx_a[l][i], mtx_b[i][c]));
+            }
+            matriz[l][c] = acumulador;
+        }
+    }
+    return matriz;
+}
+
+static double agora(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** Average time of `repeticoes` products C = H*X (or H*H^H when `gram` is set) with the given backend. */
+static double mede(blas_backend backend, int gram, const cmatrix *H, const cmatrix *X, cmatrix *C, int repeticoes)
+{
+    const complexo um = {1, 0}, zero = {0, 0};
+    blas_set_backend(backend);
+    double t0 = agora();
+    for (int r = 0; r < repeticoes; r++)
+    {
+        if (gram)
+        {
+            cmatrix_gemm(GEMM_N, H, GEMM_H, H, um, zero, C);
+        }
+        else
+        {
+            cmatrix_gemm(GEMM_N, H, GEMM_N, X, um, zero, C);
+        }
+    }
+    double t = (agora() - t0) / repeticoes;
+    blas_set_backend(BLAS_NATIVO);
+    return t;
+}
+
+static void preenche(cmatrix *m)
+{
+    for (int l = 0; l < m->linhas; l++)
+    {
+        for (int c = 0; c < m->colunas; c++)
+        {
+            CMATRIX_AT(*m, l, c).real = rand() / (double) RAND_MAX - 0.5;
+            CMATRIX_AT(*m, l, c).img = rand() / (double) RAND_MAX - 0.5;
+        }
+    }
+}
+
+int main(void)
+{
+    // Antenna pairs used by the pre-setting mode
+    const int pares[][2] = {{2, 4}, {4, 8}, {8, 16}, {32, 16}, {32, 64}, {64, 128}, {128, 256}, {256, 512}, {512, 1024}};
+    const int npares = sizeof(pares) / sizeof(pares[0]);
+
+    blas_set_backend(BLAS_CBLAS);
+    int com_cblas = (blas_get_backend() == BLAS_CBLAS);
+    printf("CBLAS backend: %s\n", com_cblas ? blas_nome() : "not available in this build");
+    blas_set_backend(BLAS_NATIVO);
+
+    printf("Channel product H (Nr x Nt) * X (Nt x %d)\n", BENCH_COLUNAS);
+    printf("%6s %6s %14s %14s %14s %10s %10s %10s %9s %10s\n", "Nr", "Nt", "ref [ms]", "gemm [ms]", "cblas [ms]", "ref GF/s", "gemm GF/s", "cblas GF/s", "speedup", "max err");
+    for (int t = 0; t < npares; t++)
+    {
+        int Nr = pares[t][0], Nt = pares[t][1];
+        cmatrix H = cmatrix_alloc(Nr, Nt);
+        cmatrix X = cmatrix_alloc(Nt, BENCH_COLUNAS);
+        cmatrix Y = cmatrix_alloc(Nr, BENCH_COLUNAS);
+        preenche(&H);
+        preenche(&X);
+        double flops = 8.0 * Nr * Nt * BENCH_COLUNAS;
+        int repeticoes = (int) (2e8 / flops) + 1;
+
+        double t0 = agora();
+        complexo **ref = NULL;
+        for (int r = 0; r < repeticoes; r++)
+        {
+            LiberarMatriz(ref, Nr);
+            ref = produto_referencia(H.rows, X.rows, Nr, Nt, BENCH_COLUNAS);
+        }
+        double t_ref = (agora() - t0) / repeticoes;
+        double t_blas = com_cblas ? mede(BLAS_CBLAS, 0, &H, &X, &Y, repeticoes) : 0;
+        double t_gemm = mede(BLAS_NATIVO, 0, &H, &X, &Y, repeticoes);
+
+        double erro = 0;
+        for (int l = 0; l < Nr; l++)
+        {
+            for (int c = 0; c < BENCH_COLUNAS; c++)
+            {
+                double d = hypot(ref[l][c].real - CMATRIX_AT(Y, l, c).real, ref[l][c].img - CMATRIX_AT(Y, l, c).img);
+                erro = (d > erro) ? d : erro;
+            }
+        }
+        printf("%6d %6d %14.4f %14.4f %14.4f %10.2f %10.2f %10.2f %8.2fx %10.2e\n", Nr, Nt, t_ref * 1e3, t_gemm * 1e3, t_blas * 1e3,
+               flops / t_ref * 1e-9, flops / t_gemm * 1e-9, com_cblas ? flops / t_blas * 1e-9 : 0, t_ref / t_gemm, erro);
+
+        LiberarMatriz(ref, Nr);
+        cmatrix_free(&H);
+        cmatrix_free(&X);
+        cmatrix_free(&Y);
+    }
+
+    printf("\nGram matrix H * H^H (conjugate-transpose flag on the second operand)\n");
+    printf("%6s %6s %14s %14s %10s %10s\n", "Nr", "Nt", "gemm [ms]", "cblas [ms]", "gemm GF/s", "cblas GF/s");
+    for (int t = 0; t < npares; t++)
+    {
+        int Nr = pares[t][0], Nt = pares[t][1];
+        cmatrix H = cmatrix_alloc(Nr, Nt);
+        cmatrix G = cmatrix_alloc(Nr, Nr);
+        preenche(&H);
+        double flops = 8.0 * Nr * Nr * Nt;
+        int repeticoes = (int) (2e8 / flops) + 1;
+        double t_gemm = mede(BLAS_NATIVO, 1, &H, NULL, &G, repeticoes);
+        double t_blas = com_cblas ? mede(BLAS_CBLAS, 1, &H, NULL, &G, repeticoes) : 0;
+        printf("%6d %6d %14.4f %14.4f %10.2f %10.2f\n", Nr, Nt, t_gemm * 1e3, t_blas * 1e3, flops / t_gemm * 1e-9, com_cblas ? flops / t_blas * 1e-9 : 0);
+        cmatrix_free(&H);
+        cmatrix_free(&G);
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+/// @file bench_layout.c
+/// @brief Compares the interleaved (`cmatrix`) and split (`cmatrix_split`) layouts on the element-wise kernels of the receiver.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "matrix.h"
+#include "simd.h"
+
+/** Number of stream vectors per block, as in a transmission block. */
+#define BENCH_COLUNAS 256
+/** Number of complex elements processed per repetition, used to size the repetition count. */
+#define BENCH_ALVO 2e8
+
+static double agora(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void preenche(cmatrix *m)
+{
+    for (int l = 0; l < m->linhas; l++)
+    {
+        for (int c = 0; c < m->colunas; c++)
+        {
+            CMATRIX_AT(*m, l, c).real = rand() / (double) RAND_MAX - 0.5;
+            CMATRIX_AT(*m, l, c).img = rand() / (double) RAND_MAX - 0.5;
+        }
+    }
+}
+
+/** Prints one line of the table: time per element of each layout, and the cost of converting to split and back. */
+static void linha(const char *nome, double t_int, double t_split, double t_conv, long elementos)
+{
+    printf("%-14s %14.3f %14.3f %9.2fx %14.3f\n", nome, t_int / elementos * 1e9, t_split / elementos * 1e9,
+           t_int / t_split, (t_split + t_conv) / elementos * 1e9);
+}
+
+int main(void)
+{
+    const int linhas_preset[] = {2, 8, 32, 128, 512};
+    const int n = sizeof(linhas_preset) / sizeof(linhas_preset[0]);
+    volatile double sorvedouro = 0;
+
+    printf("Kernel backend: %s\n", simd_get()->nome);
+    printf("Times in ns per complex element; the last column adds the interleaved <-> split conversion of the operands\n");
+    for (int t = 0; t < n; t++)
+    {
+        int Ns = linhas_preset[t];
+        long elementos = (long) Ns * BENCH_COLUNAS;
+        int repeticoes = (int) (BENCH_ALVO / (8.0 * elementos)) + 1;
+
+        cmatrix A = cmatrix_alloc(Ns, BENCH_COLUNAS), B = cmatrix_alloc(Ns, BENCH_COLUNAS), R = cmatrix_alloc(Ns, BENCH_COLUNAS);
+        preenche(&A);
+        preenche(&B);
+        cmatrix_split As = cmatrix_split_alloc(Ns, BENCH_COLUNAS), Bs = cmatrix_split_alloc(Ns, BENCH_COLUNAS), Rs = cmatrix_split_alloc(Ns, BENCH_COLUNAS);
+        cmatrix_split Av = cmatrix_split_view(&A), Bv = cmatrix_split_view(&B), Rv = cmatrix_split_view(&R);
+
+        // Conversion cost: split the two operands and interleave the result back
+        double t0 = agora();
+        for (int r = 0; r < repeticoes; r++)
+        {
+            cmatrix_split_copy_from(&As, &A);
+            cmatrix_split_copy_from(&Bs, &B);
+            cmatrix_split_copy_to(&R, &Rs);
+        }
+        double t_conv = (agora() - t0) / repeticoes;
+
+        printf("\nNstream = %d, %d columns\n", Ns, BENCH_COLUNAS);
+        printf("%-14s %14s %14s %10s %14s\n", "kernel", "interleaved", "split", "speedup", "split+conv");
+
+        // Element-wise complex product (the kernel that needs shuffles on interleaved data)
+        t0 = agora();
+        for (int r = 0; r < repeticoes; r++)
+        {
+            cmatrix_split_mul(&Rv, &Av, &Bv);
+        }
+        double t_int = (agora() - t0) / repeticoes;
+        t0 = agora();
+        for (int r = 0; r < repeticoes; r++)
+        {
+            cmatrix_split_mul(&Rs, &As, &Bs);
+        }
+        double t_split = (agora() - t0) / repeticoes;
+        linha("mul", t_int, t_split, t_conv, elementos);
+
+        // FEQ: every row divided by its (real) singular value
+        t0 = agora();
+        for (int r = 0; r < repeticoes; r++)
+        {
+            for (int l = 0; l < Ns; l++)
+            {
+                cvec_scale(R.rows[l], A.rows[l], 1.0 / (l + 1), BENCH_COLUNAS);
+            }
+        }
+        t_int = (agora() - t0) / repeticoes;
+        t0 = agora();
+        for (int r = 0; r < repeticoes; r++)
+        {
+            for (int l = 0; l < Ns; l++)
+            {
+                size_t o = (size_t) l * As.ld;
+                svec_scale(Rs.re + o, Rs.im + o, As.re + o, As.im + o, 1.0 / (l + 1), BENCH_COLUNAS);
+            }
+        }
+        t_split = (agora() - t0) / repeticoes;
+        linha("feq scale", t_int, t_split, t_conv, elementos);
+
+        // EVM: power of the error between the transmitted and the equalized symbols
+        t0 = agora();
+        for (int r = 0; r < repeticoes; r++)
+        {
+            sorvedouro += cmatrix_split_error_power(&Av, &Bv);
+        }
+        t_int = (agora() - t0) / repeticoes;
+        t0 = agora();
+        for (int r = 0; r < repeticoes; r++)
+        {
+            sorvedouro += cmatrix_split_error_power(&As, &Bs);
+        }
+        t_split = (agora() - t0) / repeticoes;
+        linha("evm error pow", t_int, t_split, t_conv, elementos);
+
+        // Both layouts must give the same product
+        cmatrix_split_mul(&Rv, &Av, &Bv);
+        cmatrix_split_mul(&Rs, &As, &Bs);
+        cmatrix C = cmatrix_alloc(Ns, BENCH_COLUNAS);
+        cmatrix_split_copy_to(&C, &Rs);
+        cmatrix_split Cv = cmatrix_split_view(&C);
+        printf("%-14s %14.2e\n", "mul mismatch", sqrt(cmatrix_split_error_power(&Cv, &Rv)));
+        cmatrix_free(&C);
+
+        cmatrix_free(&A);
+        cmatrix_free(&B);
+        cmatrix_free(&R);
+        cmatrix_split_free(&As);
+        cmatrix_split_free(&Bs);
+        cmatrix_split_free(&Rs);
+    }
+    return sorvedouro < 0;
+}
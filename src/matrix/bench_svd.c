@@ -0,0 +1,164 @@
+/// @file bench_svd.c
+/// @brief Times `cmatrix_svd` on random channel matrices, up to 512 x 1024, against `gsl_linalg_SV_decomp` on the real embedding of the same matrix.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <gsl/gsl_linalg.h>
+#include "matrix.h"
+#include "gemm.h"
+#include "simd.h"
+#include "svd.h"
+
+/** Approximate number of complex flops timed per size, used to size the repetition count. */
+#define BENCH_ALVO 2e9
+
+static double agora(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void preenche(cmatrix *m)
+{
+    for (int l = 0; l < m->linhas; l++)
+    {
+        for (int c = 0; c < m->colunas; c++)
+        {
+            CMATRIX_AT(*m, l, c).real = rand() / (double) RAND_MAX - 0.5;
+            CMATRIX_AT(*m, l, c).img = rand() / (double) RAND_MAX - 0.5;
+        }
+    }
+}
+
+/** Largest entry of |X^H X - I|, the loss of orthogonality of the columns of X. */
+static double ortogonalidade(const cmatrix *X)
+{
+    complexo um = {1, 0}, zero = {0, 0};
+    cmatrix G = cmatrix_alloc(X->colunas, X->colunas);
+    cmatrix_gemm(GEMM_H, X, GEMM_N, X, um, zero, &G);
+    double erro = 0;
+    for (int l = 0; l < G.linhas; l++)
+    {
+        for (int c = 0; c < G.colunas; c++)
+        {
+            double d = hypot(CMATRIX_AT(G, l, c).real - (l == c), CMATRIX_AT(G, l, c).img);
+            erro = (d > erro) ? d : erro;
+        }
+    }
+    cmatrix_free(&G);
+    return erro;
+}
+
+/** Relative residual ||A - U diag(S) V^H||_F / ||A||_F. */
+static double residuo(const cmatrix *A, const cmatrix *U, const double *S, const cmatrix *V)
+{
+    complexo um = {1, 0}, menos_um = {-1, 0};
+    cmatrix US = cmatrix_alloc(U->linhas, U->colunas);
+    cmatrix R = cmatrix_alloc(A->linhas, A->colunas);
+    for (int l = 0; l < U->linhas; l++)
+    {
+        for (int c = 0; c < U->colunas; c++)
+        {
+            CMATRIX_AT(US, l, c).real = S[c] * CMATRIX_AT(*U, l, c).real;
+            CMATRIX_AT(US, l, c).img = S[c] * CMATRIX_AT(*U, l, c).img;
+        }
+    }
+    for (int l = 0; l < A->linhas; l++)
+    {
+        for (int c = 0; c < A->colunas; c++)
+        {
+            CMATRIX_AT(R, l, c) = CMATRIX_AT(*A, l, c);
+        }
+    }
+    double norma = 0, erro = 0;
+    for (int l = 0; l < A->linhas; l++)
+    {
+        norma += cvec_power(A->data + (size_t) l * A->ld, A->colunas);
+    }
+    cmatrix_gemm(GEMM_N, &US, GEMM_H, V, menos_um, um, &R);
+    for (int l = 0; l < R.linhas; l++)
+    {
+        erro += cvec_power(R.data + (size_t) l * R.ld, R.colunas);
+    }
+    cmatrix_free(&R);
+    cmatrix_free(&US);
+    return sqrt(erro / norma);
+}
+
+/**
+ * @brief Time of `gsl_linalg_SV_decomp` on the 2p x 2k real matrix [Re -Im; Im Re] of A (or of A^H when A is wide, since GSL needs rows >= columns).
+ *
+ * Its singular values are those of A, each one twice: it is what the real-only GSL routine costs
+ * for the same complex decomposition.
+ */
+static double mede_gsl(const cmatrix *A)
+{
+    int larga = (A->linhas <= A->colunas);
+    int p = larga ? A->colunas : A->linhas, k = larga ? A->linhas : A->colunas;
+    gsl_matrix *R = gsl_matrix_alloc(2 * p, 2 * k);
+    gsl_matrix *V = gsl_matrix_alloc(2 * k, 2 * k);
+    gsl_vector *S = gsl_vector_alloc(2 * k);
+    gsl_vector *work = gsl_vector_alloc(2 * k);
+    for (int l = 0; l < p; l++)
+    {
+        for (int c = 0; c < k; c++)
+        {
+            complexo a = larga ? CMATRIX_AT(*A, c, l) : CMATRIX_AT(*A, l, c);
+            double im = larga ? -a.img : a.img;
+            gsl_matrix_set(R, l, c, a.real);
+            gsl_matrix_set(R, l, k + c, -im);
+            gsl_matrix_set(R, p + l, c, im);
+            gsl_matrix_set(R, p + l, k + c, a.real);
+        }
+    }
+    double t0 = agora();
+    gsl_linalg_SV_decomp(R, V, S, work);
+    double t = agora() - t0;
+    gsl_vector_free(work);
+    gsl_vector_free(S);
+    gsl_matrix_free(V);
+    gsl_matrix_free(R);
+    return t;
+}
+
+int main(void)
+{
+    // Antenna pairs of the pre-setting mode and the largest case, 512 x 1024, in both orientations
+    const int pares[][2] = {{4, 8}, {16, 64}, {64, 16}, {64, 128}, {128, 256}, {256, 512}, {512, 1024}, {1024, 512}};
+    const int npares = sizeof(pares) / sizeof(pares[0]);
+
+    printf("Reduced SVD A = U diag(S) V^H of a random complex Nr x Nt matrix (Jacobi from the Gram eigenvectors from %d singular values on)\n", SVD_PRECONDICIONA);
+    printf("%6s %6s %14s %14s %9s %10s %10s\n", "Nr", "Nt", "svd [ms]", "gsl [ms]", "speedup", "residual", "orth err");
+    srand(1);
+    for (int t = 0; t < npares; t++)
+    {
+        int Nr = pares[t][0], Nt = pares[t][1];
+        int k = (Nr < Nt) ? Nr : Nt, comprimento = (Nr < Nt) ? Nt : Nr;
+        cmatrix A = cmatrix_alloc(Nr, Nt), U = cmatrix_alloc(Nr, k), V = cmatrix_alloc(Nt, k);
+        double *S = (double *) malloc(k * sizeof(double));
+        preenche(&A);
+        int repeticoes = (int) (BENCH_ALVO / (8.0 * k * k * comprimento)) + 1;
+
+        double t0 = agora();
+        int status = 0;
+        for (int r = 0; r < repeticoes; r++)
+        {
+            status |= cmatrix_svd(&A, &U, S, &V);
+        }
+        double t_svd = (agora() - t0) / repeticoes;
+        double t_gsl = mede_gsl(&A);
+        double erro_u = ortogonalidade(&U), erro_v = ortogonalidade(&V);
+
+        printf("%6d %6d %14.4f %14.4f %8.2fx %10.2e %10.2e%s\n", Nr, Nt, t_svd * 1e3, t_gsl * 1e3, t_gsl / t_svd,
+               residuo(&A, &U, S, &V), (erro_u > erro_v) ? erro_u : erro_v, status ? "  (did not converge)" : "");
+
+        free(S);
+        cmatrix_free(&A);
+        cmatrix_free(&U);
+        cmatrix_free(&V);
+    }
+    return 0;
+}
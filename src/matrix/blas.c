@@ -0,0 +1,145 @@
+/// @file blas.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "blas.h"
+
+/*
+ * The CBLAS header depends on the library chosen in the makefile: GSL ships its own
+ * <gsl/gsl_cblas.h>, while OpenBLAS, BLIS and the reference CBLAS use <cblas.h>.
+ * Without any of them the library only has the native backend.
+ */
+#if defined(CMIMO_CBLAS_GSL)
+#include <gsl/gsl_cblas.h>
+#define BLAS_DISPONIVEL 1
+#elif defined(CMIMO_CBLAS)
+#include <cblas.h>
+#define BLAS_DISPONIVEL 1
+#endif
+
+#ifdef BLAS_DISPONIVEL
+#ifdef CMIMO_CBLAS_GSL
+static const char *nome_cblas = "cblas (gslcblas)";
+#else
+static const char *nome_cblas = "cblas";
+#endif
+#endif
+
+static int backend_escolhido = -1;
+
+/**###BLAS Backend Selection Function:
+ * The `blas_get_backend` function returns the implementation used by `matrix_gemm`.
+- On the first call the environment variable `CMIMO_BLAS` (`native` or `cblas`) is read; if it is not set, `CMIMO_BLAS_PADRAO` is used. The makefile makes CBLAS the default when an optimized library (OpenBLAS, BLIS) is linked and keeps the native engine when only the reference GSL CBLAS is available, since the native engine is faster than it.
+- A program built without CBLAS always uses the native backend.
+ * @param[out] backend
+ * */
+blas_backend blas_get_backend(void)
+{
+    if (backend_escolhido >= 0)
+    {
+        return (blas_backend) backend_escolhido;
+    }
+    blas_backend escolha = CMIMO_BLAS_PADRAO;
+    const char *env = getenv("CMIMO_BLAS");
+    if (env != NULL)
+    {
+        if (strcmp(env, "native") == 0)
+        {
+            escolha = BLAS_NATIVO;
+        }
+        else if (strcmp(env, "cblas") == 0)
+        {
+            escolha = BLAS_CBLAS;
+        }
+    }
+    blas_set_backend(escolha);
+    return (blas_backend) backend_escolhido;
+}
+
+/**Função: Troca o backend usado por `matrix_gemm`. Sem CBLAS na compilação, o backend nativo é mantido. */
+void blas_set_backend(blas_backend backend)
+{
+#ifdef BLAS_DISPONIVEL
+    backend_escolhido = backend;
+#else
+    (void) backend;
+    backend_escolhido = BLAS_NATIVO;
+#endif
+}
+
+/**Função: Nome do backend em uso. */
+const char *blas_nome(void)
+{
+#ifdef BLAS_DISPONIVEL
+    if (blas_get_backend() == BLAS_CBLAS)
+    {
+        return nome_cblas;
+    }
+#endif
+    return "native";
+}
+
+#ifdef BLAS_DISPONIVEL
+/* CBLAS transpose flag of an operation, or -1 for the plain conjugate, which CBLAS does not have. */
+static int blas_trans(gemm_op op)
+{
+    switch (op)
+    {
+    case GEMM_N:
+        return CblasNoTrans;
+    case GEMM_T:
+        return CblasTrans;
+    case GEMM_H:
+        return CblasConjTrans;
+    default:
+        return -1;
+    }
+}
+#endif
+
+/**###CBLAS General Matrix Product Function:
+ * The `blas_gemm` function computes C = alpha*op(A)*op(B) + beta*C with the linked CBLAS library, with the same arguments as `matrix_gemm`.
+- The matrices are stored row by row, so every call uses `CblasRowMajor` and the leading dimensions are passed unchanged. `complexo` has the layout of the `double[2]` complex numbers expected by CBLAS.
+- Matrix-vector products (a single column of C with op(B) not conjugated, or a single row of C with op(A) not conjugated) call `zgemv`; all other products call `zgemm`.
+- CBLAS has no flag for the conjugate without transpose (`GEMM_C`), and empty products are left to the native engine as well: in these cases nothing is computed and the function returns 0.
+ * @param[in] opa, opb, m, n, k, alpha, A, lda, B, ldb, beta, ldc
+ * @param[out] C
+ * @return 1 if the product was computed, 0 otherwise.
+ * */
+int blas_gemm(gemm_op opa, gemm_op opb, int m, int n, int k, complexo alpha, const complexo *A, int lda, const complexo *B, int ldb, complexo beta, complexo *C, int ldc)
+{
+#ifdef BLAS_DISPONIVEL
+    int ta = blas_trans(opa), tb = blas_trans(opb);
+    if (ta < 0 || tb < 0 || m == 0 || n == 0 || k == 0)
+    {
+        return 0;
+    }
+    if (n == 1 && opb != GEMM_H)
+    {
+        // C column = op(A) * op(B) column; the column of B is strided when B is not transposed
+        int incx = (opb == GEMM_N) ? ldb : 1;
+        int linhas = (opa == GEMM_N) ? m : k, colunas = (opa == GEMM_N) ? k : m;
+        cblas_zgemv(CblasRowMajor, ta, linhas, colunas, &alpha, A, lda, B, incx, &beta, C, ldc);
+        return 1;
+    }
+    if (m == 1 && opa != GEMM_H)
+    {
+        // C row = op(B)^T * op(A)^T; the row of op(A) is strided when A is transposed
+        int incx = (opa == GEMM_N) ? 1 : lda;
+        int tbt = (opb == GEMM_N) ? CblasTrans : (opb == GEMM_T) ? CblasNoTrans : -1;
+        if (tbt >= 0)
+        {
+            int linhas = (opb == GEMM_N) ? k : n, colunas = (opb == GEMM_N) ? n : k;
+            cblas_zgemv(CblasRowMajor, tbt, linhas, colunas, &alpha, B, ldb, A, incx, &beta, C, 1);
+            return 1;
+        }
+    }
+    cblas_zgemm(CblasRowMajor, ta, tb, m, n, k, &alpha, A, lda, B, ldb, &beta, C, ldc);
+    return 1;
+#else
+    (void) opa; (void) opb; (void) m; (void) n; (void) k; (void) alpha; (void) A; (void) lda;
+    (void) B; (void) ldb; (void) beta; (void) C; (void) ldc;
+    return 0;
+#endif
+}
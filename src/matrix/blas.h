@@ -0,0 +1,25 @@
+#ifndef _H_BLAS
+#define _H_BLAS
+
+#include "gemm.h"
+
+/** Implementação usada pelos produtos matriciais (`matrix_gemm`). */
+typedef enum blas_backend {
+    BLAS_NATIVO, ///< Motor GEMM próprio da biblioteca (`gemm.c`)
+    BLAS_CBLAS   ///< Biblioteca CBLAS ligada ao programa (GSL CBLAS, OpenBLAS, BLIS, ...)
+} blas_backend;
+
+/** Backend usado quando a variável de ambiente `CMIMO_BLAS` não está definida. O makefile o define conforme a biblioteca escolhida em `BLAS`. */
+#ifndef CMIMO_BLAS_PADRAO
+#define CMIMO_BLAS_PADRAO BLAS_NATIVO
+#endif
+
+//Função: Backend em uso (escolhido uma vez, pela variável de ambiente `CMIMO_BLAS` ou por `CMIMO_BLAS_PADRAO`).
+blas_backend blas_get_backend(void);
+//Função: Troca o backend em uso. Sem CBLAS na compilação, o backend nativo é mantido.
+void blas_set_backend(blas_backend backend);
+//Função: Nome do backend em uso.
+const char *blas_nome(void);
+//Função: Produto matricial geral via CBLAS (`zgemm`/`zgemv`). Retorna 0 quando a operação não é suportada e deve ser feita pelo motor nativo.
+int blas_gemm(gemm_op opa, gemm_op opb, int m, int n, int k, complexo alpha, const complexo *A, int lda, const complexo *B, int ldb, complexo beta, complexo *C, int ldc);
+#endif
@@ -0,0 +1,343 @@
+/// @file gemm.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gemm.h"
+#include "simd.h"
+#include "blas.h"
+#include "arena.h"
+
+/** Produtos com até este número de multiplicações complexas não compensam o empacotamento. */
+#define GEMM_SMALL (32 * 1024)
+
+/**
+ * @brief Reads element (i, p) of op(X), where X is stored row by row with leading dimension ldx.
+ */
+static inline complexo gemm_elem(gemm_op op, const complexo *X, int ldx, int i, int p)
+{
+    complexo v;
+    if (op == GEMM_N || op == GEMM_C)
+    {
+        v = X[(size_t) i * ldx + p];
+    }
+    else
+    {
+        v = X[(size_t) p * ldx + i];
+    }
+    if (op == GEMM_C || op == GEMM_H)
+    {
+        v.img = -v.img;
+    }
+    return v;
+}
+
+/**
+ * @brief Packs the `mc x kc` block of op(A) starting at (i0, p0) into micro-panels of GEMM_MR rows.
+ *
+ * Each micro-panel is stored as kc groups of GEMM_MR real parts followed by GEMM_MR imaginary parts,
+ * so the micro-kernel reads it sequentially. Rows beyond `mc` are filled with zeros.
+ */
+static void gemm_pack_a(gemm_op opa, const complexo *A, int lda, int i0, int p0, int mc, int kc, double *dst)
+{
+    for (int ir = 0; ir < mc; ir += GEMM_MR)
+    {
+        int mr = (mc - ir < GEMM_MR) ? mc - ir : GEMM_MR;
+        for (int p = 0; p < kc; p++)
+        {
+            double *re = dst + (size_t) p * 2 * GEMM_MR;
+            double *im = re + GEMM_MR;
+            for (int i = 0; i < GEMM_MR; i++)
+            {
+                if (i < mr)
+                {
+                    complexo v = gemm_elem(opa, A, lda, i0 + ir + i, p0 + p);
+                    re[i] = v.real;
+                    im[i] = v.img;
+                }
+                else
+                {
+                    re[i] = 0;
+                    im[i] = 0;
+                }
+            }
+        }
+        dst += (size_t) kc * 2 * GEMM_MR;
+    }
+}
+
+/**
+ * @brief Packs the `kc x nc` block of op(B) starting at (p0, j0) into micro-panels of GEMM_NR columns.
+ *
+ * Same layout as `gemm_pack_a`: kc groups of GEMM_NR real parts followed by GEMM_NR imaginary parts.
+ */
+static void gemm_pack_b(gemm_op opb, const complexo *B, int ldb, int p0, int j0, int kc, int nc, double *dst)
+{
+    for (int jr = 0; jr < nc; jr += GEMM_NR)
+    {
+        int nr = (nc - jr < GEMM_NR) ? nc - jr : GEMM_NR;
+        for (int p = 0; p < kc; p++)
+        {
+            double *re = dst + (size_t) p * 2 * GEMM_NR;
+            double *im = re + GEMM_NR;
+            for (int j = 0; j < GEMM_NR; j++)
+            {
+                if (j < nr)
+                {
+                    complexo v = gemm_elem(opb, B, ldb, p0 + p, j0 + jr + j);
+                    re[j] = v.real;
+                    im[j] = v.img;
+                }
+                else
+                {
+                    re[j] = 0;
+                    im[j] = 0;
+                }
+            }
+        }
+        dst += (size_t) kc * 2 * GEMM_NR;
+    }
+}
+
+/**
+ * @brief Register-tiled micro-kernel: C(mr x nr) += alpha * Ap * Bp over kc steps.
+ *
+ * The GEMM_MR x GEMM_NR accumulators are kept in split real/imaginary form so the inner loop
+ * over the columns maps to plain vector multiply-adds, without shuffles. The body is compiled
+ * once per instruction set (see `gemm_kernel_avx2` and `gemm_kernel_avx512`).
+ */
+static inline __attribute__((always_inline)) void gemm_kernel_corpo(int kc, const double *Ap, const double *Bp, complexo alpha, complexo *C, int ldc, int mr, int nr)
+{
+    double cr[GEMM_MR][GEMM_NR] = {{0}};
+    double ci[GEMM_MR][GEMM_NR] = {{0}};
+
+    for (int p = 0; p < kc; p++)
+    {
+        const double *ar = Ap + (size_t) p * 2 * GEMM_MR;
+        const double *ai = ar + GEMM_MR;
+        const double *br = Bp + (size_t) p * 2 * GEMM_NR;
+        const double *bi = br + GEMM_NR;
+        for (int i = 0; i < GEMM_MR; i++)
+        {
+            for (int j = 0; j < GEMM_NR; j++)
+            {
+                cr[i][j] += ar[i] * br[j] - ai[i] * bi[j];
+                ci[i][j] += ar[i] * bi[j] + ai[i] * br[j];
+            }
+        }
+    }
+
+    for (int i = 0; i < mr; i++)
+    {
+        complexo *c = C + (size_t) i * ldc;
+        for (int j = 0; j < nr; j++)
+        {
+            c[j].real += alpha.real * cr[i][j] - alpha.img * ci[i][j];
+            c[j].img += alpha.real * ci[i][j] + alpha.img * cr[i][j];
+        }
+    }
+}
+
+/** Micro-kernel compiled for the SSE2 baseline. */
+static void gemm_kernel_sse2(int kc, const double *Ap, const double *Bp, complexo alpha, complexo *C, int ldc, int mr, int nr)
+{
+    gemm_kernel_corpo(kc, Ap, Bp, alpha, C, ldc, mr, nr);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/** Micro-kernel compiled for AVX2 + FMA: one register per row of accumulators. */
+__attribute__((target("avx2,fma"))) static void gemm_kernel_avx2(int kc, const double *Ap, const double *Bp, complexo alpha, complexo *C, int ldc, int mr, int nr)
+{
+    gemm_kernel_corpo(kc, Ap, Bp, alpha, C, ldc, mr, nr);
+}
+
+/** Micro-kernel compiled for AVX-512F. */
+__attribute__((target("avx512f"))) static void gemm_kernel_avx512(int kc, const double *Ap, const double *Bp, complexo alpha, complexo *C, int ldc, int mr, int nr)
+{
+    gemm_kernel_corpo(kc, Ap, Bp, alpha, C, ldc, mr, nr);
+}
+#endif
+
+typedef void (*gemm_kernel_fn)(int, const double *, const double *, complexo, complexo *, int, int, int);
+
+/**
+ * @brief Chooses the micro-kernel for the instruction set selected by `simd_get`.
+ */
+static gemm_kernel_fn gemm_kernel_escolhido(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    switch (simd_get_nivel())
+    {
+        case SIMD_AVX512:
+            return gemm_kernel_avx512;
+        case SIMD_AVX2:
+            return gemm_kernel_avx2;
+        default:
+            break;
+    }
+#endif
+    return gemm_kernel_sse2;
+}
+
+/**
+ * @brief Direct product for small or vector-shaped operands, where packing would cost as much as the product.
+ */
+static void gemm_small(gemm_op opa, gemm_op opb, int m, int n, int k, complexo alpha, const complexo *A, int lda, const complexo *B, int ldb, complexo *C, int ldc)
+{
+    double sinal = (opb == GEMM_C || opb == GEMM_H) ? -1.0 : 1.0;
+    for (int i = 0; i < m; i++)
+    {
+        complexo *c = C + (size_t) i * ldc;
+        if (opb == GEMM_N || opb == GEMM_C)
+        {
+            // Rows of B are contiguous: accumulate a(i, p) * B(p, :) into the row of C
+            for (int p = 0; p < k; p++)
+            {
+                complexo a = multcomp(alpha, gemm_elem(opa, A, lda, i, p));
+                const complexo *b = B + (size_t) p * ldb;
+                for (int j = 0; j < n; j++)
+                {
+                    double bi = sinal * b[j].img;
+                    c[j].real += a.real * b[j].real - a.img * bi;
+                    c[j].img += a.real * bi + a.img * b[j].real;
+                }
+            }
+        }
+        else
+        {
+            // op(B)(:, j) is row j of B: each element of C is a contiguous dot product
+            for (int j = 0; j < n; j++)
+            {
+                const complexo *b = B + (size_t) j * ldb;
+                double re = 0, im = 0;
+                for (int p = 0; p < k; p++)
+                {
+                    complexo a = gemm_elem(opa, A, lda, i, p);
+                    double bi = sinal * b[p].img;
+                    re += a.real * b[p].real - a.img * bi;
+                    im += a.real * bi + a.img * b[p].real;
+                }
+                c[j].real += alpha.real * re - alpha.img * im;
+                c[j].img += alpha.real * im + alpha.img * re;
+            }
+        }
+    }
+}
+
+/**###General Matrix Product Function:
+ * The `matrix_gemm` function computes C = alpha*op(A)*op(B) + beta*C, where op(A) is `m x k`, op(B) is `k x n` and C is `m x n`.
+- `opa` and `opb` select the operation applied to each operand: `GEMM_N` (as is), `GEMM_T` (transpose), `GEMM_C` (conjugate) or `GEMM_H` (conjugate transpose). The operations are applied while the operands are packed, so they cost nothing in the inner loop.
+- The product is blocked for the cache hierarchy: `GEMM_NC` columns of op(B) and `GEMM_KC` steps of the inner dimension are packed into micro-panels that stay in cache, and for each of them `GEMM_MC` rows of op(A) are packed and multiplied by a `GEMM_MR x GEMM_NR` register-tiled micro-kernel.
+- The micro-kernel is compiled for SSE2, AVX2+FMA and AVX-512F and the one matching `simd_get` is used.
+- Small products and matrix-vector products skip the packing and use a direct loop.
+- Every matrix is stored row by row with leading dimension `lda`, `ldb` and `ldc` (in elements), as in `cmatrix`.
+- When the CBLAS backend is selected (`blas_get_backend`), the product is delegated to `blas_gemm`; the native engine only runs for the operations CBLAS does not support.
+ * @param[in] opa, opb, m, n, k, alpha, A, lda, B, ldb, beta, ldc
+ * @param[out] C
+ * */
+void matrix_gemm(gemm_op opa, gemm_op opb, int m, int n, int k, complexo alpha, const complexo *A, int lda, const complexo *B, int ldb, complexo beta, complexo *C, int ldc)
+{
+    if (blas_get_backend() == BLAS_CBLAS && blas_gemm(opa, opb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc))
+    {
+        return;
+    }
+    // C = beta*C
+    if (beta.real != 1 || beta.img != 0)
+    {
+        for (int i = 0; i < m; i++)
+        {
+            complexo *c = C + (size_t) i * ldc;
+            for (int j = 0; j < n; j++)
+            {
+                if (beta.real == 0 && beta.img == 0)
+                {
+                    c[j].real = 0;
+                    c[j].img = 0;
+                }
+                else
+                {
+                    c[j] = multcomp(beta, c[j]);
+                }
+            }
+        }
+    }
+    if (m == 0 || n == 0 || k == 0 || (alpha.real == 0 && alpha.img == 0))
+    {
+        return;
+    }
+    if ((size_t) m * n * k <= GEMM_SMALL || m == 1 || n == 1)
+    {
+        gemm_small(opa, opb, m, n, k, alpha, A, lda, B, ldb, C, ldc);
+        return;
+    }
+
+    gemm_kernel_fn gemm_kernel = gemm_kernel_escolhido();
+    int nc_max = (n < GEMM_NC) ? n : GEMM_NC;
+    int kc_max = (k < GEMM_KC) ? k : GEMM_KC;
+    int mc_max = (m < GEMM_MC) ? m : GEMM_MC;
+    size_t bytes_b = (size_t) kc_max * 2 * ((nc_max + GEMM_NR - 1) / GEMM_NR * GEMM_NR) * sizeof(double);
+    size_t bytes_a = (size_t) kc_max * 2 * ((mc_max + GEMM_MR - 1) / GEMM_MR * GEMM_MR) * sizeof(double);
+    // The packing buffers live in the active arena, if any, and are released with it
+    arena *a = arena_ativa();
+    arena_marca marca = {NULL, 0};
+    if (a != NULL)
+    {
+        marca = arena_marcar(a);
+    }
+    double *Bp = (double *) arena_malloc(bytes_b);
+    double *Ap = (double *) arena_malloc(bytes_a);
+
+    for (int jc = 0; jc < n; jc += GEMM_NC)
+    {
+        int nc = (n - jc < GEMM_NC) ? n - jc : GEMM_NC;
+        for (int pc = 0; pc < k; pc += GEMM_KC)
+        {
+            int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+            gemm_pack_b(opb, B, ldb, pc, jc, kc, nc, Bp);
+            for (int ic = 0; ic < m; ic += GEMM_MC)
+            {
+                int mc = (m - ic < GEMM_MC) ? m - ic : GEMM_MC;
+                gemm_pack_a(opa, A, lda, ic, pc, mc, kc, Ap);
+                for (int jr = 0; jr < nc; jr += GEMM_NR)
+                {
+                    int nr = (nc - jr < GEMM_NR) ? nc - jr : GEMM_NR;
+                    const double *bp = Bp + (size_t) (jr / GEMM_NR) * kc * 2 * GEMM_NR;
+                    for (int ir = 0; ir < mc; ir += GEMM_MR)
+                    {
+                        int mr = (mc - ir < GEMM_MR) ? mc - ir : GEMM_MR;
+                        const double *ap = Ap + (size_t) (ir / GEMM_MR) * kc * 2 * GEMM_MR;
+                        gemm_kernel(kc, ap, bp, alpha, C + (size_t) (ic + ir) * ldc + jc + jr, ldc, mr, nr);
+                    }
+                }
+            }
+        }
+    }
+    if (a != NULL)
+    {
+        arena_voltar(a, marca);
+    }
+    else
+    {
+        arena_free(Ap);
+        arena_free(Bp);
+    }
+}
+
+/**###Contiguous General Matrix Product Function:
+ * The `cmatrix_gemm` function computes C = alpha*op(A)*op(B) + beta*C over `cmatrix` operands, using their leading dimensions.
+- The dimensions of C must already match op(A)*op(B); otherwise the function prints an error message and ends the program with `exit(1)`.
+ * @param[in] opa, A, opb, B, alpha, beta
+ * @param[out] C
+ * */
+void cmatrix_gemm(gemm_op opa, const cmatrix *A, gemm_op opb, const cmatrix *B, complexo alpha, complexo beta, cmatrix *C)
+{
+    int m = (opa == GEMM_N || opa == GEMM_C) ? A->linhas : A->colunas;
+    int k = (opa == GEMM_N || opa == GEMM_C) ? A->colunas : A->linhas;
+    int kb = (opb == GEMM_N || opb == GEMM_C) ? B->linhas : B->colunas;
+    int n = (opb == GEMM_N || opb == GEMM_C) ? B->colunas : B->linhas;
+    if (k != kb || C->linhas != m || C->colunas != n)
+    {
+        printf("\nError: The product cannot be performed (incompatibility between matrices)\n");
+        exit(1);
+    }
+    matrix_gemm(opa, opb, m, n, k, alpha, A->data, A->ld, B->data, B->ld, beta, C->data, C->ld);
+}
@@ -0,0 +1,29 @@
+#ifndef _H_GEMM
+#define _H_GEMM
+
+#include "matrix.h"
+
+/** Operação aplicada a um operando do produto matricial. */
+typedef enum gemm_op {
+    GEMM_N, ///< Operando como está
+    GEMM_T, ///< Transposta
+    GEMM_C, ///< Conjugada (sem transpor)
+    GEMM_H  ///< Hermitiana (conjugada transposta)
+} gemm_op;
+
+/** Tamanho do micro-bloco de registradores: linhas de op(A). */
+#define GEMM_MR 4
+/** Tamanho do micro-bloco de registradores: colunas de op(B). */
+#define GEMM_NR 4
+/** Bloco de linhas de op(A) mantido na cache L2. */
+#define GEMM_MC 96
+/** Bloco da dimensão interna k mantido na cache L1 (painéis de B). */
+#define GEMM_KC 256
+/** Bloco de colunas de op(B) mantido na cache L3. */
+#define GEMM_NC 2048
+
+//Função: Produto matricial geral C = alpha*op(A)*op(B) + beta*C sobre buffers com leading dimension.
+void matrix_gemm(gemm_op opa, gemm_op opb, int m, int n, int k, complexo alpha, const complexo *A, int lda, const complexo *B, int ldb, complexo beta, complexo *C, int ldc);
+//Função: Produto matricial geral sobre matrizes `cmatrix`.
+void cmatrix_gemm(gemm_op opa, const cmatrix *A, gemm_op opb, const cmatrix *B, complexo alpha, complexo beta, cmatrix *C);
+#endif
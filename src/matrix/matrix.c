@@ -2,6 +2,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "matrix.h"
+#include "gemm.h"
+#include "simd.h"
+#include "arena.h"
 #include <gsl/gsl_linalg.h>
 
 /**
@@ -419,15 +422,20 @@ complexo **transposta(complexo** mtx,int linhas, int colunas)
         complexo** matriz;
 
         matriz = allocateComplexMatrix(colunas,linhas);
+        transposta_into(matriz, mtx, linhas, colunas);
+    return matriz;
+}
+/**Função: Transposição de `mtx` (linhas x colunas) escrita em `dst` (colunas x linhas), já alocada. `dst` não pode ser a própria `mtx`. */
+void transposta_into(complexo **dst, complexo **mtx, int linhas, int colunas)
+{
         for (int l = 0; l < linhas; l++)
 		{
 			for (int c = 0; c < colunas; c++)
 			{
-				matriz[c][l].real = mtx[l][c].real;
-                matriz[c][l].img = mtx[l][c].img;
+				dst[c][l].real = mtx[l][c].real;
+                dst[c][l].img = mtx[l][c].img;
 			}
 		}
-    return matriz;
 }
 
 /**###Conjugate Function:
@@ -443,7 +451,7 @@ over the rows and the inner loop iterates over the columns.
 - Inside the loop, the function assigns the real value of the input matrix element `mtx[l][c].real` to the 
 corresponding element of the `matrix[l][c].real`, preserving the same value.
 - The function inverts the sign of the imaginary part of the input matrix element, multiplying it by -1: 
-`matrix[l][c].img = -mtx[l][c].img`.
+`matrix[l][c].img = -mtx[l][c].img`. Each row is processed by the SIMD kernel `cvec_conj`.
 - After all elements of the `mtx` matrix are processed, the function returns the `matrix`, which contains 
 the resulting conjugate matrix. 
  * @param[in] mtx, linhas, colunas
@@ -455,28 +463,25 @@ complexo **conjugada(complexo **mtx, int linhas, int colunas)
     complexo ** matrix;
     //alocação da matriz 
     matrix = allocateComplexMatrix (linhas, colunas);
+    conjugada_into(matrix, mtx, linhas, colunas);
 
+    return matrix;
+}
+/**Função: Conjugada de `mtx` escrita em `dst`, de mesmas dimensões. `dst` pode ser a própria `mtx` (operação no lugar). */
+void conjugada_into(complexo **dst, complexo **mtx, int linhas, int colunas)
+{
     for (int l = 0; l < linhas; l++)
     {
-        for (int c = 0; c < colunas; c++)
-        {
-            matrix[l][c].real = mtx[l][c].real;
-            matrix[l][c].img = -mtx[l][c].img;
-        }
+        cvec_conj(dst[l], mtx[l], colunas);
     }
-
-    return matrix;
 }
 
 /**###Hermitian Function: 
  * The `hermitian` function implements the operation of hermitian matrix. This operation consists of obtaining the conjugate matrix of the input matrix and then calculating the transpose of this conjugate matrix. The resulting matrix is a hermitian matrix.
 - The `hermitian` function takes three parameters: `mtx` (a matrix of complex numbers), `linhas` (the number of rows in the matrix), and `colunas` (the number of columns in the matrix).
-It declares two variables of type `complexo**`: `matriz` and `matriz_h`.
-- Then, the function allocates memory for two matrices using the `allocateComplexMatrix` function. The first matrix (`matriz`) has the same size as the input matrix, while the second matrix (`matriz_h`), also has the same size.
-- The function calls the `conjugate` function passing the input matrix `mtx`, `linhas`, and `colunas`. This function returns the conjugate matrix of the input matrix.
-- The result of the `conjugate` function is assigned to the `matriz` matrix.
-- Then, the function calls the `transpose` function passing the `matriz` matrix, `linhas`, and `colunas`. This function returns the transpose of the matrix passed as an argument.
-The result of the `transpose` function is assigned to the `matriz_h` matrix.
+It declares a variable of type `complexo**`: `matriz_h`.
+- Then, the function allocates memory for `matriz_h` using the `allocateComplexMatrix` function. It has `colunas` rows and `linhas` columns.
+- The function calls `hermitiana_into`, which writes the conjugate of each element `mtx[l][c]` directly into its transposed position `matriz_h[c][l]`, so the conjugate matrix is never stored.
 - Finally, the function returns the `matriz_h` matrix, which is the resulting hermitian matrix.
  @param[in] mtx, linhas, colunas
  @param[out] matriz_h.
@@ -484,16 +489,25 @@ The result of the `transpose` function is assigned to the `matriz_h` matrix.
 
 complexo **hermitiana(complexo** mtx, int linhas, int colunas)
 {
-    complexo **matriz, **matriz_h;
-
-    matriz = allocateComplexMatrix(linhas, colunas);
-    matriz_h = allocateComplexMatrix(linhas, colunas);
+    complexo **matriz_h;
 
-    matriz = conjugada(mtx, linhas, colunas);
-    matriz_h = transposta(matriz, linhas, colunas);
+    matriz_h = allocateComplexMatrix(colunas, linhas);
+    hermitiana_into(matriz_h, mtx, linhas, colunas);
 
     return matriz_h;
 }
+/**Função: Hermitiana de `mtx` (linhas x colunas) escrita em `dst` (colunas x linhas), em uma única passada e sem a matriz conjugada intermediária. `dst` não pode ser a própria `mtx`. */
+void hermitiana_into(complexo **dst, complexo **mtx, int linhas, int colunas)
+{
+    for (int l = 0; l < linhas; l++)
+    {
+        for (int c = 0; c < colunas; c++)
+        {
+            dst[c][l].real = mtx[l][c].real;
+            dst[c][l].img = -mtx[l][c].img;
+        }
+    }
+}
 /**###Sum Function: 
  * The `sum` function implements the operation of matrix addition. This operation consists of adding two or more matrices, however in the following example only with two matrices.
 - The `sum` function takes four parameters: `mtx_a` (a "a" matrix of complex numbers),`mtx_b` (a "b" matrix of complex numbers), `linhas` (the number of rows in the matrix), and `colunas` (the number of columns in the matrix).
@@ -501,7 +515,7 @@ complexo **hermitiana(complexo** mtx, int linhas, int colunas)
 - Then, the function allocates memory for the `matriz` matrix using the `allocateComplexMatrix` function. The `matriz` matrix has the same size as the "a" and "b" matrices.
 - The function uses two nested loops to go through each element of the `mtx` matrix. The outer loop iterates over the rows and the inner loop iterates over the columns.
 - Inside the loop, the function assigns the real value of the sum of the input matrix elements `mtx_a[c][l].real` and `mtx_b[c][l].real`, to the corresponding element of the `matriz[l][c].real`.
-- The function also assigns in an analogous way the sum of the value of the imaginary part of the input matrix elements `mtx_a[c][l].img` and `mtx_b[c][l].real`, to the corresponding element of the `matriz[l][c].img`.
+- The function also assigns in an analogous way the sum of the value of the imaginary part of the input matrix elements `mtx_a[c][l].img` and `mtx_b[c][l].real`, to the corresponding element of the `matriz[l][c].img`. Each row is processed by the SIMD kernel `cvec_add`.
 - After all elements of the `mtx_a` and 'mtx_b' matrices are processed, the function returns the `matriz` matrix, which contains the matrix of the sum function.
  * @param[in] mtx_a, mtx_b, linhas, colunas
  * @param[out] matriz
@@ -511,15 +525,16 @@ complexo **soma(complexo** mtx_a, complexo** mtx_b, int linhas, int colunas)
 	complexo** matriz;
 	
 	matriz = allocateComplexMatrix(linhas,colunas);
+	soma_into(matriz, mtx_a, mtx_b, linhas, colunas);
+	return matriz;
+}
+/**Função: Soma `mtx_a + mtx_b` escrita em `dst`. `dst` pode ser `mtx_a` ou `mtx_b` (acumulação no lugar). */
+void soma_into(complexo **dst, complexo **mtx_a, complexo **mtx_b, int linhas, int colunas)
+{
 		for (int l = 0; l < linhas; l++)
 		{
-			for (int c = 0; c < colunas; c++)
-			{
-				matriz[l][c].real = mtx_a[l][c].real + mtx_b[l][c].real;
-                matriz[l][c].img = mtx_a[l][c].img + mtx_b[l][c].img;
-			}
+			cvec_add(dst[l], mtx_a[l], mtx_b[l], colunas);
 		}
-	return matriz;
 }
 /**###Subtraction Function: 
  * The `subtraction` function implements the operation of matrix subtraction. This operation consists of subtracting two or more matrices, however in the following example as in the above only with two matrices.
@@ -528,7 +543,7 @@ complexo **soma(complexo** mtx_a, complexo** mtx_b, int linhas, int colunas)
 - Then, the function allocates memory for the `matriz` matrix using the `allocateComplexMatrix` function. The `matriz` matrix has the same size as the "a" and "b" matrices.
 - The function uses two nested loops to go through each element of the `mtx` matrix. The outer loop iterates over the rows and the inner loop iterates over the columns.
 - Inside the loop, the function assigns the real value of the subtraction of the input matrix elements `mtx_a[c][l].real` and `mtx_b[c][l].real`, to the corresponding element of the `matriz[l][c].real`.
-- The function also assigns in an analogous way the subtraction of the value of the imaginary part of the input matrix elements `mtx_a[c][l].img` and `mtx_b[c][l].real`, to the corresponding element of the `matriz[l][c].img`.
+- The function also assigns in an analogous way the subtraction of the value of the imaginary part of the input matrix elements `mtx_a[c][l].img` and `mtx_b[c][l].real`, to the corresponding element of the `matriz[l][c].img`. Each row is processed by the SIMD kernel `cvec_sub`.
 - After all elements of the `mtx_a` and 'mtx_b' matrices are processed, the function returns the `matriz` matrix, which contains the matrix of the subtraction function.
  * @param[in] mtx_a, mtx_b, linhas, colunas
  * @param[out] matriz
@@ -538,15 +553,16 @@ complexo **subtracao(complexo** mtx_a, complexo** mtx_b, int linhas, int colunas
 	complexo** matriz;
 	
 	matriz = allocateComplexMatrix(linhas,colunas);
+	subtracao_into(matriz, mtx_a, mtx_b, linhas, colunas);
+	return matriz;
+}
+/**Função: Subtração `mtx_a - mtx_b` escrita em `dst`. `dst` pode ser `mtx_a` ou `mtx_b`. */
+void subtracao_into(complexo **dst, complexo **mtx_a, complexo **mtx_b, int linhas, int colunas)
+{
 		for (int l = 0; l < linhas; l++)
 		{
-			for (int c = 0; c < colunas; c++)
-			{
-				matriz[l][c].real = mtx_a[l][c].real - mtx_b[l][c].real;
-                matriz[l][c].img = mtx_a[l][c].img - mtx_b[l][c].img;
-			}
+			cvec_sub(dst[l], mtx_a[l], mtx_b[l], colunas);
 		}
-	return matriz;
 }
 /**###Inner Product Function: 
  * The `inner product` function implements the operation of the product of two complex vectors.
@@ -581,9 +597,7 @@ complexo produto_interno(complexo **v1, complexo **v2, int linhas, int colunas)
 - The `matrix product` function takes four parameters: `mtx_a` (a "a" matrix of complex numbers),`mtx_b` (a "b" matrix of complex numbers), `linhas` (the number of rows of the matrices), and `colunas` (the number of columns of the matrices).
 - It declares a variable of type `complexo` called `matriz`, which will be used to store the result of the matrix product.
 - Then, the function validates the operation by checking if the number of columns of the 'a' matrix is equal to the number of rows of the 'b' matrix. If not, it displays an error message that the product cannot be performed due to the incompatibility of matrices and ends the program with the 'exit(1)' function.
-- After the check, the function starts a loop to go through the cells of the resulting matrix, for each cell an accumulator is started with the value zero.
-- Inside the loop, another loop is performed to calculate the sum of the product of matrix a and matrix b, such operation is done from the 'multcomp' function.
-- Then the 'soma_complexo' function is called to add the result to the accumulator.
+- After the check, the product is computed by `cmatrix_produto` over the contiguous storage of both matrices, which uses the cache-blocked engine `matrix_gemm`. The matrices must therefore have been allocated with `allocateComplexMatrix`.
  * @param[in] mtx_a, mtx_b, linhas, colunas
  * @param[out] matriz
  * */
@@ -595,25 +609,22 @@ complexo **produto_matricial(complexo** mtx_a, complexo **mtx_b, int linhas, int
 		printf("\nErro: O produto não pode ser realizado (incompatibilidade entre matrizes)\n");
 		exit(1);
 	}
-	complexo** matriz;
-	matriz = allocateComplexMatrix(linhas, colunas);
-	int linhas_b = colunas; 
-	for (int l = 0; l < linhas; l++)
+	cmatrix a = cmatrix_view(mtx_a, linhas, colunas);
+	cmatrix b = cmatrix_view(mtx_b, linhas, colunas);
+	return cmatrix_produto(&a, &b).rows;
+}
+/**Função: Produto matricial escrito em `dst`, alocada por `allocateComplexMatrix` com as mesmas dimensões. `dst` não pode ser `mtx_a` nem `mtx_b`. */
+void produto_matricial_into(complexo **dst, complexo **mtx_a, complexo **mtx_b, int linhas, int colunas)
+{
+	if(linhas != colunas)
 	{
-		for (int c = 0; c < colunas; c++)
-		{
-			complexo acumulador;
-			acumulador.real = 0;
-			acumulador.img = 0;
-			for (int i = 0; i < linhas_b; i ++)
-			{
-				acumulador = soma_complexo(acumulador, multcomp(mtx_a[l][i],mtx_b[i][c]));
-			}
-			matriz[l][c].real = acumulador.real;
-			matriz[l][c].img = acumulador.img;
-		}
+		printf("\nErro: O produto não pode ser realizado (incompatibilidade entre matrizes)\n");
+		exit(1);
 	}
-	return matriz;
+	cmatrix a = cmatrix_view(mtx_a, linhas, colunas);
+	cmatrix b = cmatrix_view(mtx_b, linhas, colunas);
+	cmatrix r = cmatrix_view(dst, linhas, colunas);
+	cmatrix_produto_into(&r, &a, &b);
 }
 
 /*complexo** produto_matricial_plus(complexo** mtx_a, complexo** mtx_b, int linhas_a, int colunas_a, int linhas_b, int colunas_b)
@@ -655,7 +666,7 @@ complexo **produto_matricial(complexo** mtx_a, complexo **mtx_b, int linhas, int
 - Then, the function allocates memory for the matrix using the `allocateComplexMatrix` function. 
 - The function uses two nested loops to go through each element of the `mtx` matrix. The outer loop iterates over the rows and the inner loop iterates over the columns.
 - Inside the loop, the function assigns the real value of the input matrix element `mtx[c][l].real`, multiplied by the integer 'k', to the corresponding element of the `matriz[l][c].real`.
-- The function also assigns in an analogous way, the value of the multiplication of the scalar by the imaginary part of the input matrix element `mtx[c][l].img`, to the corresponding element of the `matriz[l][c].img`.
+- The function also assigns in an analogous way, the value of the multiplication of the scalar by the imaginary part of the input matrix element `mtx[c][l].img`, to the corresponding element of the `matriz[l][c].img`. Each row is processed by the SIMD kernel `cvec_scale`.
 - After all elements of the `mtx` matrix are processed, the function returns the `matriz` matrix.
 
  @param[in] mtx, linhas, colunas, k
@@ -666,16 +677,16 @@ complexo** produto_por_escalar(complexo **mtx, int linhas, int colunas, int k)
 	complexo **matriz;
 
 	matriz = allocateComplexMatrix(linhas, colunas);
-
+	produto_por_escalar_into(matriz, mtx, linhas, colunas, k);
+	return matriz;
+}
+/**Função: Multiplicação de `mtx` pelo escalar k escrita em `dst`. `dst` pode ser a própria `mtx` (operação no lugar). */
+void produto_por_escalar_into(complexo **dst, complexo **mtx, int linhas, int colunas, int k)
+{
 	for (int l = 0; l < linhas; l++)
 	{
-		for (int c = 0; c < colunas; c++)
-		{
-			matriz[l][c].real = k*mtx[l][c].real;
-			matriz[l][c].img = k*mtx[l][c].img;
-		}
+		cvec_scale(dst[l], mtx[l], k, colunas);
 	}
-	return matriz;
 }
 /**### Teste da função Transposta.
  * 
@@ -1457,32 +1468,449 @@ void printComplex(complexo c)
 {
     printf("%+.6lf %+.6lfj ", c.real, c.img);
 }
-/**Função: Alocação de memória para uma matriz complexa. */
+/**Função: Alocação de memória para uma matriz complexa.
+ * A matriz é alocada em um único bloco contíguo (ver `cmatrix_alloc`), portanto é liberada por `LiberarMatriz` com um único `arena_free` (não com `free`, por causa do cabeçalho de `arena_malloc`). */
 complexo **allocateComplexMatrix (int linhas, int colunas)
 {
-    
-    complexo** matrix;
-	
-    matrix = (complexo **) malloc(linhas*sizeof(complexo*));
-	
-    if (matrix == NULL)
+    cmatrix matrix = cmatrix_alloc(linhas, colunas);
+    return matrix.rows;
+}
+/**Função: Liberação da memória de uma matriz complexa alocada por `allocateComplexMatrix`. Matrizes de uma arena são recuperadas só com ela (`arena_voltar`/`arena_reset`). */
+void LiberarMatriz(complexo **mtx, int linhas)
+{
+    (void) linhas;
+    arena_free(mtx);
+}
+/**###Contiguous Matrix Allocation Function:
+ * The `cmatrix_alloc` function allocates a `linhas x colunas` complex matrix in a single block of memory.
+- The block starts with the row pointer array `rows`, padded to `CMATRIX_ALIGN` bytes, followed by the element buffer `data`, so the elements are always 64-byte aligned and the whole matrix costs one allocation.
+- The leading dimension `ld` is `colunas` rounded up to a full cache line when the matrix has four columns or more, which keeps every row aligned; narrow matrices (such as the `Nstream x 1` vectors) are stored without padding.
+- The block comes from `arena_malloc`: inside an active arena (`arena_usar`) it is a pointer bump in the arena, otherwise a heap allocation.
+- If the allocation fails, the function prints an error message and ends the program with `exit(1)`, as `allocateComplexMatrix` always did.
+ * @param[in] linhas, colunas
+ * @param[out] matrix
+ * */
+cmatrix cmatrix_alloc(int linhas, int colunas)
+{
+    const size_t por_linha_cache = CMATRIX_ALIGN / sizeof(complexo);
+    cmatrix matrix;
+    matrix.linhas = linhas;
+    matrix.colunas = colunas;
+    matrix.ld = colunas;
+    if (colunas >= (int) por_linha_cache)
     {
-        printf("Memory alocation failed.");
-        exit(1);
+        matrix.ld = (int) (((size_t) colunas + por_linha_cache - 1) / por_linha_cache * por_linha_cache);
     }
-    //Alocação de memória para cada linha da matriz
+
+    size_t bytes_rows = ((size_t) linhas * sizeof(complexo *) + CMATRIX_ALIGN - 1) / CMATRIX_ALIGN * CMATRIX_ALIGN;
+    size_t bytes_data = ((size_t) linhas * matrix.ld * sizeof(complexo) + CMATRIX_ALIGN - 1) / CMATRIX_ALIGN * CMATRIX_ALIGN;
+    size_t total = bytes_rows + bytes_data;
+    if (total == 0)
+    {
+        total = CMATRIX_ALIGN;
+    }
+    char *bloco = (char *) arena_malloc(total);
+    matrix.rows = (complexo **) bloco;
+    matrix.data = (complexo *) (bloco + bytes_rows);
     for (int i = 0; i < linhas; i++)
     {
-        matrix[i] = (complexo *) malloc(colunas*sizeof(complexo));
-        if (matrix[i] == NULL)
+        matrix.rows[i] = matrix.data + (size_t) i * matrix.ld;
+    }
+    return matrix;
+}
+/**Função: Liberação de uma `cmatrix` alocada por `cmatrix_alloc`. Vistas (`cmatrix_view`, `cmatrix_submatrix`) não devem ser liberadas; matrizes de uma arena são recuperadas só com ela. */
+void cmatrix_free(cmatrix *m)
+{
+    arena_free(m->rows);
+    m->rows = NULL;
+    m->data = NULL;
+}
+/**###Matrix View Function:
+ * The `cmatrix_view` function wraps a matrix created by `allocateComplexMatrix` as a `cmatrix` without copying it.
+- The leading dimension is recovered from the distance between the first two rows.
+- The returned view shares the memory of `mtx` and must not be released with `cmatrix_free`.
+ * @param[in] mtx, linhas, colunas
+ * @param[out] view
+ * */
+cmatrix cmatrix_view(complexo **mtx, int linhas, int colunas)
+{
+    cmatrix view;
+    view.rows = mtx;
+    view.data = mtx[0];
+    view.linhas = linhas;
+    view.colunas = colunas;
+    view.ld = (linhas > 1) ? (int) (mtx[1] - mtx[0]) : colunas;
+    return view;
+}
+/**###Submatrix View Function:
+ * The `cmatrix_submatrix` function returns a view of the `linhas x colunas` block of `m` that starts at row `l0` and column `c0`.
+- The view keeps the leading dimension of `m`, so no element is copied.
+- The row pointers are only available when the block starts at column 0; otherwise `rows` is NULL.
+ * @param[in] m, l0, c0, linhas, colunas
+ * @param[out] view
+ * */
+cmatrix cmatrix_submatrix(const cmatrix *m, int l0, int c0, int linhas, int colunas)
+{
+    cmatrix view;
+    view.data = m->data + (size_t) l0 * m->ld + c0;
+    view.rows = (c0 == 0 && m->rows != NULL) ? m->rows + l0 : NULL;
+    view.linhas = linhas;
+    view.colunas = colunas;
+    view.ld = m->ld;
+    return view;
+}
+/**###Contiguous Transpose Function:
+ * Same operation as `transposta`, over the contiguous storage of `mtx`. The result is a new `colunas x linhas` matrix.
+ * @param[in] mtx
+ * @param[out] matriz
+ * */
+cmatrix cmatrix_transposta(const cmatrix *mtx)
+{
+    cmatrix matriz = cmatrix_alloc(mtx->colunas, mtx->linhas);
+    cmatrix_transposta_into(&matriz, mtx);
+    return matriz;
+}
+/* Ends the program if `dst` is not a `linhas x colunas` matrix. */
+static void cmatrix_confere(const cmatrix *dst, int linhas, int colunas)
+{
+    if (dst->linhas != linhas || dst->colunas != colunas)
+    {
+        printf("\nError: The destination matrix has incompatible dimensions\n");
+        exit(1);
+    }
+}
+/**Função: Transposta de `mtx` escrita em `dst` (colunas x linhas). `dst` não pode compartilhar memória com `mtx`. */
+void cmatrix_transposta_into(cmatrix *dst, const cmatrix *mtx)
+{
+    cmatrix_confere(dst, mtx->colunas, mtx->linhas);
+    for (int l = 0; l < mtx->linhas; l++)
+    {
+        const complexo *linha = mtx->data + (size_t) l * mtx->ld;
+        for (int c = 0; c < mtx->colunas; c++)
         {
-            printf("Memory allocation failed\n");
-            exit(1);
+            CMATRIX_AT(*dst, c, l) = linha[c];
         }
     }
+}
+/**###Contiguous Hermitian Function:
+ * Same operation as `hermitiana`: the conjugate transpose of `mtx`, computed in a single pass and without the intermediate conjugate matrix.
+ * @param[in] mtx
+ * @param[out] matriz
+ * */
+cmatrix cmatrix_hermitiana(const cmatrix *mtx)
+{
+    cmatrix matriz = cmatrix_alloc(mtx->colunas, mtx->linhas);
+    cmatrix_hermitiana_into(&matriz, mtx);
+    return matriz;
+}
+/**Função: Hermitiana de `mtx` escrita em `dst` (colunas x linhas). `dst` não pode compartilhar memória com `mtx`. */
+void cmatrix_hermitiana_into(cmatrix *dst, const cmatrix *mtx)
+{
+    cmatrix_confere(dst, mtx->colunas, mtx->linhas);
+    for (int l = 0; l < mtx->linhas; l++)
+    {
+        const complexo *linha = mtx->data + (size_t) l * mtx->ld;
+        for (int c = 0; c < mtx->colunas; c++)
+        {
+            CMATRIX_AT(*dst, c, l).real = linha[c].real;
+            CMATRIX_AT(*dst, c, l).img = -linha[c].img;
+        }
+    }
+}
+/**Função: Conjugada de `mtx` escrita em `dst`, de mesmas dimensões. `dst` pode ser a própria `mtx`. */
+void cmatrix_conjugada_into(cmatrix *dst, const cmatrix *mtx)
+{
+    cmatrix_confere(dst, mtx->linhas, mtx->colunas);
+    for (int l = 0; l < mtx->linhas; l++)
+    {
+        cvec_conj(dst->data + (size_t) l * dst->ld, mtx->data + (size_t) l * mtx->ld, mtx->colunas);
+    }
+}
+/**###Contiguous Sum Function:
+ * Same operation as `soma`, over the contiguous storage of `mtx_a` and `mtx_b`, which must have the same dimensions.
+ * @param[in] mtx_a, mtx_b
+ * @param[out] matriz
+ * */
+cmatrix cmatrix_soma(const cmatrix *mtx_a, const cmatrix *mtx_b)
+{
+    cmatrix matriz = cmatrix_alloc(mtx_a->linhas, mtx_a->colunas);
+    cmatrix_soma_into(&matriz, mtx_a, mtx_b);
+    return matriz;
+}
+/**Função: Soma `mtx_a + mtx_b` escrita em `dst`. `dst` pode ser `mtx_a` ou `mtx_b` (acumulação no lugar). */
+void cmatrix_soma_into(cmatrix *dst, const cmatrix *mtx_a, const cmatrix *mtx_b)
+{
+    cmatrix_confere(dst, mtx_a->linhas, mtx_a->colunas);
+    for (int l = 0; l < mtx_a->linhas; l++)
+    {
+        const complexo *a = mtx_a->data + (size_t) l * mtx_a->ld;
+        const complexo *b = mtx_b->data + (size_t) l * mtx_b->ld;
+        complexo *r = dst->data + (size_t) l * dst->ld;
+        cvec_add(r, a, b, mtx_a->colunas);
+    }
+}
+/**###Contiguous Subtraction Function:
+ * Same operation as `subtracao`, over the contiguous storage of `mtx_a` and `mtx_b`, which must have the same dimensions.
+ * @param[in] mtx_a, mtx_b
+ * @param[out] matriz
+ * */
+cmatrix cmatrix_subtracao(const cmatrix *mtx_a, const cmatrix *mtx_b)
+{
+    cmatrix matriz = cmatrix_alloc(mtx_a->linhas, mtx_a->colunas);
+    cmatrix_subtracao_into(&matriz, mtx_a, mtx_b);
+    return matriz;
+}
+/**Função: Subtração `mtx_a - mtx_b` escrita em `dst`. `dst` pode ser `mtx_a` ou `mtx_b`. */
+void cmatrix_subtracao_into(cmatrix *dst, const cmatrix *mtx_a, const cmatrix *mtx_b)
+{
+    cmatrix_confere(dst, mtx_a->linhas, mtx_a->colunas);
+    for (int l = 0; l < mtx_a->linhas; l++)
+    {
+        const complexo *a = mtx_a->data + (size_t) l * mtx_a->ld;
+        const complexo *b = mtx_b->data + (size_t) l * mtx_b->ld;
+        complexo *r = dst->data + (size_t) l * dst->ld;
+        cvec_sub(r, a, b, mtx_a->colunas);
+    }
+}
+/**Função: Multiplicação de `mtx` pelo escalar real k escrita em `dst`. `dst` pode ser a própria `mtx`. */
+void cmatrix_escalar_into(cmatrix *dst, const cmatrix *mtx, double k)
+{
+    cmatrix_confere(dst, mtx->linhas, mtx->colunas);
+    for (int l = 0; l < mtx->linhas; l++)
+    {
+        cvec_scale(dst->data + (size_t) l * dst->ld, mtx->data + (size_t) l * mtx->ld, k, mtx->colunas);
+    }
+}
+/**###Contiguous Matrix Product Function:
+ * Same operation as `general_matrix_product`: the product of a `linhas_a x colunas_a` matrix by a `colunas_a x colunas_b` matrix.
+- The product is computed by the cache-blocked engine `cmatrix_gemm`.
+- If the dimensions are not compatible, the function prints an error message and ends the program with `exit(1)`.
+ * @param[in] mtx_a, mtx_b
+ * @param[out] matriz
+ * */
+cmatrix cmatrix_produto(const cmatrix *mtx_a, const cmatrix *mtx_b)
+{
+    if (mtx_a->colunas != mtx_b->linhas)
+    {
+        printf("\nError: The product cannot be performed (incompatibility between matrices)\n");
+        exit(1);
+    }
+    cmatrix matriz = cmatrix_alloc(mtx_a->linhas, mtx_b->colunas);
+    cmatrix_produto_into(&matriz, mtx_a, mtx_b);
+    return matriz;
+}
+/**Função: Produto `mtx_a * mtx_b` escrito em `dst` (linhas_a x colunas_b), sem alocar. `dst` não pode compartilhar memória com `mtx_a` nem com `mtx_b`; dimensões incompatíveis terminam o programa com `exit(1)`. */
+void cmatrix_produto_into(cmatrix *dst, const cmatrix *mtx_a, const cmatrix *mtx_b)
+{
+    complexo um = {1, 0}, zero = {0, 0};
+    cmatrix_gemm(GEMM_N, mtx_a, GEMM_N, mtx_b, um, zero, dst);
+}
+/**###Split Matrix Allocation Function:
+ * The `cmatrix_split_alloc` function allocates a `linhas x colunas` complex matrix with the real and imaginary parts in separate planes.
+- Both planes live in one `CMATRIX_ALIGN`-aligned block: the real plane first, then the imaginary plane.
+- The leading dimension is `colunas` rounded up to a full cache line of doubles when the matrix has eight columns or more, so every row of both planes starts aligned.
+- Like `cmatrix_alloc`, the block comes from the active arena when there is one.
+- If the allocation fails, the function prints an error message and ends the program with `exit(1)`.
+ * @param[in] linhas, colunas
+ * @param[out] matrix
+ * */
+cmatrix_split cmatrix_split_alloc(int linhas, int colunas)
+{
+    const size_t por_linha_cache = CMATRIX_ALIGN / sizeof(double);
+    cmatrix_split matrix;
+    matrix.linhas = linhas;
+    matrix.colunas = colunas;
+    matrix.inc = 1;
+    matrix.ld = colunas;
+    if (colunas >= (int) por_linha_cache)
+    {
+        matrix.ld = (int) (((size_t) colunas + por_linha_cache - 1) / por_linha_cache * por_linha_cache);
+    }
 
+    size_t bytes_plano = ((size_t) linhas * matrix.ld * sizeof(double) + CMATRIX_ALIGN - 1) / CMATRIX_ALIGN * CMATRIX_ALIGN;
+    size_t total = (bytes_plano == 0) ? CMATRIX_ALIGN : 2 * bytes_plano;
+    char *bloco = (char *) arena_malloc(total);
+    matrix.re = (double *) bloco;
+    matrix.im = (double *) (bloco + bytes_plano);
     return matrix;
 }
+/**Função: Liberação de uma `cmatrix_split` alocada por `cmatrix_split_alloc`. Vistas (`cmatrix_split_view`) não devem ser liberadas. */
+void cmatrix_split_free(cmatrix_split *m)
+{
+    arena_free(m->re);
+    m->re = NULL;
+    m->im = NULL;
+}
+/**###Split View Function:
+ * The `cmatrix_split_view` function exposes an interleaved `cmatrix` through the split interface without copying it.
+- The real plane starts at the first real part and the imaginary plane at the first imaginary part; both use a column step `inc = 2` and a leading dimension of `2*ld` doubles.
+- The view shares the memory of `m` and must not be released with `cmatrix_split_free`.
+ * @param[in] m
+ * @param[out] view
+ * */
+cmatrix_split cmatrix_split_view(const cmatrix *m)
+{
+    cmatrix_split view;
+    view.re = &m->data[0].real;
+    view.im = &m->data[0].img;
+    view.linhas = m->linhas;
+    view.colunas = m->colunas;
+    view.ld = 2 * m->ld;
+    view.inc = 2;
+    return view;
+}
+/**###Interleaved View Function:
+ * The `cmatrix_split_as_cmatrix` function is the inverse of `cmatrix_split_view`: it returns the interleaved `cmatrix` behind a split view, without copying it.
+- Only views over interleaved storage (`inc = 2` and `im = re + 1`) can be converted; planar matrices need `cmatrix_split_copy_to`, and the function ends the program with `exit(1)` if it receives one.
+- The row pointers are not available, so `rows` is NULL.
+ * @param[in] m
+ * @param[out] view
+ * */
+cmatrix cmatrix_split_as_cmatrix(const cmatrix_split *m)
+{
+    if (m->inc != 2 || m->im != m->re + 1)
+    {
+        printf("\nError: A planar split matrix has no interleaved view\n");
+        exit(1);
+    }
+    cmatrix view;
+    view.data = (complexo *) m->re;
+    view.rows = NULL;
+    view.linhas = m->linhas;
+    view.colunas = m->colunas;
+    view.ld = m->ld / 2;
+    return view;
+}
+/**Função: Cópia de uma `cmatrix` intercalada para uma `cmatrix_split` de mesmas dimensões (separação dos planos). */
+void cmatrix_split_copy_from(cmatrix_split *dst, const cmatrix *src)
+{
+    for (int l = 0; l < src->linhas; l++)
+    {
+        const complexo *linha = src->data + (size_t) l * src->ld;
+        double *re = dst->re + (size_t) l * dst->ld;
+        double *im = dst->im + (size_t) l * dst->ld;
+        for (int c = 0; c < src->colunas; c++)
+        {
+            re[(size_t) c * dst->inc] = linha[c].real;
+            im[(size_t) c * dst->inc] = linha[c].img;
+        }
+    }
+}
+/**Função: Cópia de uma `cmatrix_split` para uma `cmatrix` intercalada de mesmas dimensões (intercalação dos planos). */
+void cmatrix_split_copy_to(cmatrix *dst, const cmatrix_split *src)
+{
+    for (int l = 0; l < src->linhas; l++)
+    {
+        complexo *linha = dst->data + (size_t) l * dst->ld;
+        const double *re = src->re + (size_t) l * src->ld;
+        const double *im = src->im + (size_t) l * src->ld;
+        for (int c = 0; c < src->colunas; c++)
+        {
+            linha[c].real = re[(size_t) c * src->inc];
+            linha[c].img = im[(size_t) c * src->inc];
+        }
+    }
+}
+/* Layout shared by a group of split operands: 1 if all are planar, 2 if all are interleaved views, 0 otherwise. */
+static int split_layout(const cmatrix_split *a, const cmatrix_split *b, const cmatrix_split *c)
+{
+    int inc = a->inc;
+    if (b->inc != inc || (c != NULL && c->inc != inc))
+    {
+        return 0;
+    }
+    if (inc == 2 && (a->im != a->re + 1 || b->im != b->re + 1 || (c != NULL && c->im != c->re + 1)))
+    {
+        return 0;
+    }
+    return (inc == 1 || inc == 2) ? inc : 0;
+}
+/**###Split Element-wise Product Function:
+ * The `cmatrix_split_mul` function computes `r = a .* b` element by element, on whichever layout the operands already have.
+- Planar operands use the split kernels (`svec_mul`), which need no shuffles; interleaved views use the interleaved kernels (`cvec_mul`). No operand is converted.
+- Mixed layouts fall back to a scalar loop.
+ * @param[in] a, b
+ * @param[out] r
+ * */
+void cmatrix_split_mul(cmatrix_split *r, const cmatrix_split *a, const cmatrix_split *b)
+{
+    int layout = split_layout(r, a, b);
+    for (int l = 0; l < a->linhas; l++)
+    {
+        size_t ra = (size_t) l * a->ld, rb = (size_t) l * b->ld, rr = (size_t) l * r->ld;
+        if (layout == 1)
+        {
+            svec_mul(r->re + rr, r->im + rr, a->re + ra, a->im + ra, b->re + rb, b->im + rb, a->colunas);
+        }
+        else if (layout == 2)
+        {
+            cvec_mul((complexo *) (r->re + rr), (const complexo *) (a->re + ra), (const complexo *) (b->re + rb), a->colunas);
+        }
+        else
+        {
+            for (int c = 0; c < a->colunas; c++)
+            {
+                double ar = CMATRIX_SPLIT_RE(*a, l, c), ai = CMATRIX_SPLIT_IM(*a, l, c);
+                double br = CMATRIX_SPLIT_RE(*b, l, c), bi = CMATRIX_SPLIT_IM(*b, l, c);
+                CMATRIX_SPLIT_RE(*r, l, c) = ar * br - ai * bi;
+                CMATRIX_SPLIT_IM(*r, l, c) = ar * bi + ai * br;
+            }
+        }
+    }
+}
+/**Função: Multiplicação de uma `cmatrix_split` pelo escalar real k (`r = k*a`), no layout dos operandos. */
+void cmatrix_split_scale(cmatrix_split *r, const cmatrix_split *a, double k)
+{
+    int layout = split_layout(r, a, NULL);
+    for (int l = 0; l < a->linhas; l++)
+    {
+        size_t ra = (size_t) l * a->ld, rr = (size_t) l * r->ld;
+        if (layout == 1)
+        {
+            svec_scale(r->re + rr, r->im + rr, a->re + ra, a->im + ra, k, a->colunas);
+        }
+        else if (layout == 2)
+        {
+            cvec_scale((complexo *) (r->re + rr), (const complexo *) (a->re + ra), k, a->colunas);
+        }
+        else
+        {
+            for (int c = 0; c < a->colunas; c++)
+            {
+                CMATRIX_SPLIT_RE(*r, l, c) = k * CMATRIX_SPLIT_RE(*a, l, c);
+                CMATRIX_SPLIT_IM(*r, l, c) = k * CMATRIX_SPLIT_IM(*a, l, c);
+            }
+        }
+    }
+}
+/**Função: Potência do erro (soma de |a - b|^2 sobre todos os elementos) entre duas `cmatrix_split`, no layout dos operandos. */
+double cmatrix_split_error_power(const cmatrix_split *a, const cmatrix_split *b)
+{
+    int layout = split_layout(a, b, NULL);
+    double soma = 0;
+    for (int l = 0; l < a->linhas; l++)
+    {
+        size_t ra = (size_t) l * a->ld, rb = (size_t) l * b->ld;
+        if (layout == 1)
+        {
+            soma += svec_error_power(a->re + ra, a->im + ra, b->re + rb, b->im + rb, a->colunas);
+        }
+        else if (layout == 2)
+        {
+            soma += cvec_error_power((const complexo *) (a->re + ra), (const complexo *) (b->re + rb), a->colunas);
+        }
+        else
+        {
+            for (int c = 0; c < a->colunas; c++)
+            {
+                double dr = CMATRIX_SPLIT_RE(*a, l, c) - CMATRIX_SPLIT_RE(*b, l, c);
+                double di = CMATRIX_SPLIT_IM(*a, l, c) - CMATRIX_SPLIT_IM(*b, l, c);
+                soma += dr * dr + di * di;
+            }
+        }
+    }
+    return soma;
+}
 /**###Complex Sum Function: 
  The `complex_sum` function takes two complex numbers `c1` and `c2` as parameters and returns the result of the sum of these two complex numbers.
 - Inside the function, a variable named `sum` of type `complex` is declared to store the result of the sum.
@@ -11,6 +11,42 @@ typedef struct complexo {
     double real; ///< Parte real
     double img; ///< Parte imaginária
 } complexo;
+
+/** Alinhamento, em bytes, do buffer de dados de uma `cmatrix` (uma linha de cache). */
+#define CMATRIX_ALIGN 64
+
+/** A estrutura `cmatrix` representa uma matriz complexa armazenada em um único buffer contíguo, alinhado a `CMATRIX_ALIGN` bytes.
+ *O elemento (l, c) fica em `data[l*ld + c]`, onde `ld` (leading dimension) é a distância, em elementos, entre o início de duas linhas consecutivas. Para matrizes com quatro colunas ou mais, `ld` é arredondado para um múltiplo de uma linha de cache, de forma que todas as linhas comecem alinhadas.
+ O campo `rows` aponta para o início de cada linha e permite usar a matriz com as funções que recebem `complexo**`. Em sub-matrizes que não começam na coluna 0 ele vale NULL.
+ */
+typedef struct cmatrix {
+    complexo *data; ///< Buffer contíguo com os elementos da matriz
+    complexo **rows; ///< Ponteiros para o início de cada linha (compatibilidade com `complexo**`)
+    int linhas; ///< Número de linhas
+    int colunas; ///< Número de colunas
+    int ld; ///< Leading dimension (passo entre linhas, em elementos)
+} cmatrix;
+
+/** Acesso ao elemento (l, c) de uma `cmatrix`. */
+#define CMATRIX_AT(m, l, c) ((m).data[(size_t)(l) * (m).ld + (c)])
+
+/** A estrutura `cmatrix_split` representa uma matriz complexa com as partes real e imaginária em planos separados (layout SoA).
+ *A parte real do elemento (l, c) fica em `re[l*ld + c*inc]` e a imaginária em `im[l*ld + c*inc]`. Matrizes alocadas por `cmatrix_split_alloc` têm `inc = 1`: cada plano é contíguo e o produto complexo vetorizado não precisa de permutações.
+ Uma vista de uma `cmatrix` intercalada (`cmatrix_split_view`) tem `inc = 2` e `im = re + 1`, ou seja, enxerga o mesmo buffer sem cópia.
+ */
+typedef struct cmatrix_split {
+    double *re; ///< Plano das partes reais
+    double *im; ///< Plano das partes imaginárias
+    int linhas; ///< Número de linhas
+    int colunas; ///< Número de colunas
+    int ld; ///< Leading dimension (passo entre linhas, em doubles)
+    int inc; ///< Passo entre colunas, em doubles (1 em planos separados, 2 em vistas intercaladas)
+} cmatrix_split;
+
+/** Acesso à parte real do elemento (l, c) de uma `cmatrix_split`. */
+#define CMATRIX_SPLIT_RE(m, l, c) ((m).re[(size_t)(l) * (m).ld + (size_t)(c) * (m).inc])
+/** Acesso à parte imaginária do elemento (l, c) de uma `cmatrix_split`. */
+#define CMATRIX_SPLIT_IM(m, l, c) ((m).im[(size_t)(l) * (m).ld + (size_t)(c) * (m).inc])
 //Função: Teste de todas as funções de álgebra matricial do código.
 void teste_todos(void);
 //Função: Transposição de uma matriz.
@@ -29,6 +65,14 @@ complexo produto_interno(complexo **v1, complexo **v2, int linhas, int colunas);
 complexo** produto_matricial(complexo **mtx_a, complexo **mtx_b, int linhas, int colunas);
 //Função: Multiplicação por um escalar k.
 complexo** produto_por_escalar(complexo **mtx, int linhas, int colunas, int k);
+//Funções: Variantes que escrevem em uma matriz já alocada pelo chamador (`dst`), sem alocar. Ver em cada função quando `dst` pode ser um dos operandos.
+void transposta_into(complexo **dst, complexo **mtx, int linhas, int colunas);
+void conjugada_into(complexo **dst, complexo **mtx, int linhas, int colunas);
+void hermitiana_into(complexo **dst, complexo **mtx, int linhas, int colunas);
+void soma_into(complexo **dst, complexo **mtx_a, complexo **mtx_b, int linhas, int colunas);
+void subtracao_into(complexo **dst, complexo **mtx_a, complexo **mtx_b, int linhas, int colunas);
+void produto_matricial_into(complexo **dst, complexo **mtx_a, complexo **mtx_b, int linhas, int colunas);
+void produto_por_escalar_into(complexo **dst, complexo **mtx, int linhas, int colunas, int k);
 //Funções de teste.
 void teste_transposta(void);
 void teste_conjugada(void);
@@ -40,6 +84,33 @@ void teste_produto_matricial(void);
 //Manipulação de memória.
 complexo** allocateComplexMatrix(int linhas, int colunas);
 void LiberarMatriz(complexo **mtx, int linhas);
+//Matriz complexa contígua.
+cmatrix cmatrix_alloc(int linhas, int colunas);
+void cmatrix_free(cmatrix *m);
+cmatrix cmatrix_view(complexo **mtx, int linhas, int colunas);
+cmatrix cmatrix_submatrix(const cmatrix *m, int l0, int c0, int linhas, int colunas);
+cmatrix cmatrix_transposta(const cmatrix *mtx);
+cmatrix cmatrix_hermitiana(const cmatrix *mtx);
+cmatrix cmatrix_soma(const cmatrix *mtx_a, const cmatrix *mtx_b);
+cmatrix cmatrix_subtracao(const cmatrix *mtx_a, const cmatrix *mtx_b);
+cmatrix cmatrix_produto(const cmatrix *mtx_a, const cmatrix *mtx_b);
+void cmatrix_transposta_into(cmatrix *dst, const cmatrix *mtx);
+void cmatrix_hermitiana_into(cmatrix *dst, const cmatrix *mtx);
+void cmatrix_conjugada_into(cmatrix *dst, const cmatrix *mtx);
+void cmatrix_soma_into(cmatrix *dst, const cmatrix *mtx_a, const cmatrix *mtx_b);
+void cmatrix_subtracao_into(cmatrix *dst, const cmatrix *mtx_a, const cmatrix *mtx_b);
+void cmatrix_escalar_into(cmatrix *dst, const cmatrix *mtx, double k);
+void cmatrix_produto_into(cmatrix *dst, const cmatrix *mtx_a, const cmatrix *mtx_b);
+//Matriz complexa em planos separados.
+cmatrix_split cmatrix_split_alloc(int linhas, int colunas);
+void cmatrix_split_free(cmatrix_split *m);
+cmatrix_split cmatrix_split_view(const cmatrix *m);
+cmatrix cmatrix_split_as_cmatrix(const cmatrix_split *m);
+void cmatrix_split_copy_from(cmatrix_split *dst, const cmatrix *src);
+void cmatrix_split_copy_to(cmatrix *dst, const cmatrix_split *src);
+void cmatrix_split_mul(cmatrix_split *r, const cmatrix_split *a, const cmatrix_split *b);
+void cmatrix_split_scale(cmatrix_split *r, const cmatrix_split *a, double k);
+double cmatrix_split_error_power(const cmatrix_split *a, const cmatrix_split *b);
 //Manipulação de números complexos.
 void printComplex(complexo c);
 complexo soma_complexo(complexo c1, complexo c2);
@@ -0,0 +1,228 @@
+/// @file rng.c
+
+#include <math.h>
+#include <stdatomic.h>
+#include "rng.h"
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+/** Pares de amostras gerados por lote: os contadores de um lote são cifrados antes da transformação de Box–Muller, o que deixa os dois laços sem dependências entre iterações. */
+#define RNG_LOTE 64
+
+static uint64_t semente_padrao = RNG_SEMENTE_PADRAO;
+static atomic_uint_fast64_t proximo_id_padrao = 0;
+static _Thread_local rng_fluxo fluxo_padrao;
+static _Thread_local int fluxo_padrao_pronto = 0;
+static _Thread_local rng_fluxo *fluxo_da_thread = NULL;
+
+static inline uint32_t mulhilo(uint32_t a, uint32_t b, uint32_t *hi)
+{
+    uint64_t p = (uint64_t) a * b;
+    *hi = (uint32_t) (p >> 32);
+    return (uint32_t) p;
+}
+
+/** Philox4x32-10: 10 rodadas sobre o contador `c` com a chave `k`. */
+static inline void philox(uint32_t c[4], uint32_t k0, uint32_t k1)
+{
+    for (int rodada = 0; rodada < 10; rodada++)
+    {
+        uint32_t hi0, hi1;
+        uint32_t lo0 = mulhilo(PHILOX_M0, c[0], &hi0);
+        uint32_t lo1 = mulhilo(PHILOX_M1, c[2], &hi1);
+        uint32_t c1 = c[1], c3 = c[3];
+        c[0] = hi1 ^ c1 ^ k0;
+        c[1] = lo1;
+        c[2] = hi0 ^ c3 ^ k1;
+        c[3] = lo0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+/** Uniforme em (0, 1) com 53 bits a partir de duas palavras; nunca vale 0, então pode ir direto para o logaritmo. */
+static inline double para_uniforme(uint32_t hi, uint32_t lo)
+{
+    uint64_t x = ((uint64_t) hi << 32 | lo) >> 11;
+    return ((double) x + 0.5) * 0x1.0p-53;
+}
+
+/**###Stream Creation Function:
+ * The `rng_criar` function creates the stream `id` of the seed `semente`.
+- The seed is the Philox key and the identifier fills the upper half of the counter, so streams of the same seed never overlap: each one has 2^64 blocks of its own.
+- Use one identifier per independent unit of work (thread, test, block) to get reproducible results regardless of scheduling.
+ * @param[in] semente, id
+ * @param[out] f
+ * */
+rng_fluxo rng_criar(uint64_t semente, uint64_t id)
+{
+    rng_fluxo f;
+    f.chave[0] = (uint32_t) semente;
+    f.chave[1] = (uint32_t) (semente >> 32);
+    f.id[0] = (uint32_t) id;
+    f.id[1] = (uint32_t) (id >> 32);
+    f.contador = 0;
+    return f;
+}
+
+/**###Substream Function:
+ * The `rng_subfluxo` function derives from `pai` the stream identified by `indice`.
+- The new identifier is the Philox encryption of {indice, id of `pai`} with the key of `pai`, so substreams of different parents or indices do not collide in practice, and nesting (test, then block) keeps working.
+- The position of `pai` is neither used nor changed.
+ * @param[in] pai, indice
+ * @param[out] f
+ * */
+rng_fluxo rng_subfluxo(const rng_fluxo *pai, uint64_t indice)
+{
+    uint32_t c[4] = {(uint32_t) indice, (uint32_t) (indice >> 32), pai->id[0], pai->id[1]};
+    philox(c, pai->chave[0] ^ PHILOX_M0, pai->chave[1] ^ PHILOX_M1);
+    rng_fluxo f = *pai;
+    f.id[0] = c[0] ^ c[2];
+    f.id[1] = c[1] ^ c[3];
+    f.contador = 0;
+    return f;
+}
+
+/**Função: Próximas 4 palavras de 32 bits do fluxo (um incremento do contador). */
+void rng_bloco(rng_fluxo *f, uint32_t saida[4])
+{
+    saida[0] = (uint32_t) f->contador;
+    saida[1] = (uint32_t) (f->contador >> 32);
+    saida[2] = f->id[0];
+    saida[3] = f->id[1];
+    philox(saida, f->chave[0], f->chave[1]);
+    f->contador++;
+}
+
+/**Função: Preenchimento de `x` com `n` uniformes em (0, 1), duas por bloco do gerador. */
+void rng_uniforme(rng_fluxo *f, double *x, size_t n)
+{
+    uint32_t b[4];
+    size_t i = 0;
+    for (; i + 1 < n; i += 2)
+    {
+        rng_bloco(f, b);
+        x[i] = para_uniforme(b[0], b[1]);
+        x[i + 1] = para_uniforme(b[2], b[3]);
+    }
+    if (i < n)
+    {
+        rng_bloco(f, b);
+        x[i] = para_uniforme(b[0], b[1]);
+    }
+}
+
+/** Gera `n` gaussianas com desvio `sigma` e as escreve em `x` (ou as soma, se `soma`), por lotes de `RNG_LOTE` pares. */
+static void gaussiana_lotes(rng_fluxo *f, double *x, size_t n, double sigma, int soma)
+{
+    double u1[RNG_LOTE], u2[RNG_LOTE];
+    size_t i = 0;
+    while (i < n)
+    {
+        size_t pares = (n - i + 1) / 2;
+        if (pares > RNG_LOTE)
+        {
+            pares = RNG_LOTE;
+        }
+        for (size_t p = 0; p < pares; p++)
+        {
+            uint32_t c[4] = {(uint32_t) (f->contador + p), (uint32_t) ((f->contador + p) >> 32), f->id[0], f->id[1]};
+            philox(c, f->chave[0], f->chave[1]);
+            u1[p] = para_uniforme(c[0], c[1]);
+            u2[p] = para_uniforme(c[2], c[3]);
+        }
+        f->contador += pares;
+        // Box–Muller: cada par de uniformes dá duas gaussianas independentes
+        for (size_t p = 0; p < pares; p++)
+        {
+            double raio = sigma * sqrt(-2.0 * log(u1[p]));
+            double angulo = 2.0 * M_PI * u2[p];
+            double g0 = raio * cos(angulo);
+            double g1 = raio * sin(angulo);
+            if (soma)
+            {
+                x[i] += g0;
+                if (i + 1 < n)
+                {
+                    x[i + 1] += g1;
+                }
+            }
+            else
+            {
+                x[i] = g0;
+                if (i + 1 < n)
+                {
+                    x[i + 1] = g1;
+                }
+            }
+            i += 2;
+        }
+    }
+}
+
+/**###Gaussian Fill Function:
+ * The `rng_gaussiana` function fills `x` with `n` Gaussian samples of mean 0 and standard deviation `sigma`.
+- The samples come from the Box–Muller transform over batches of `RNG_LOTE` generator blocks: the counters of a batch are encrypted first and transformed afterwards, so neither loop carries a dependency.
+- Every block gives two samples; with an odd `n` the last block has one sample discarded.
+ * @param[in] f, n, sigma
+ * @param[out] x
+ * */
+void rng_gaussiana(rng_fluxo *f, double *x, size_t n, double sigma)
+{
+    gaussiana_lotes(f, x, n, sigma, 0);
+}
+
+/**Função: Soma de `n` gaussianas de média 0 e desvio `sigma` sobre `x`, na mesma sequência de `rng_gaussiana`. */
+void rng_gaussiana_add(rng_fluxo *f, double *x, size_t n, double sigma)
+{
+    gaussiana_lotes(f, x, n, sigma, 1);
+}
+
+/**Função: Soma de ruído gaussiano complexo circular sobre `x`: as partes real e imaginária recebem amostras independentes de desvio `sigma`. */
+void rng_cgaussiana_add(rng_fluxo *f, complexo *x, size_t n, double sigma)
+{
+    gaussiana_lotes(f, (double *) x, 2 * n, sigma, 1);
+}
+
+/**###Default Seed Function:
+ * The `rng_definir_semente` function sets the seed of the default streams, which are used by the threads that did not pick a stream with `rng_usar`.
+- Each thread gets its own default stream, with an identifier taken from a global counter the first time it draws a number. Streams created before the call are not changed.
+ * @param[in] semente
+ * */
+void rng_definir_semente(uint64_t semente)
+{
+    semente_padrao = semente;
+    fluxo_padrao_pronto = 0;
+}
+
+/**###Active Stream Function:
+ * The `rng_usar` function sets the stream used by the channel and noise generators in the calling thread, and returns the previous one so it can be restored.
+- The active stream is thread-local, like the active arena of `arena_usar`.
+- NULL goes back to the default stream of the thread.
+ * @param[in] f
+ * @param[out] anterior
+ * */
+rng_fluxo *rng_usar(rng_fluxo *f)
+{
+    rng_fluxo *anterior = fluxo_da_thread;
+    fluxo_da_thread = f;
+    return anterior;
+}
+
+/**Função: Fluxo ativo da thread atual, ou o fluxo padrão da thread se nenhum foi definido. */
+rng_fluxo *rng_ativo(void)
+{
+    if (fluxo_da_thread != NULL)
+    {
+        return fluxo_da_thread;
+    }
+    if (!fluxo_padrao_pronto)
+    {
+        fluxo_padrao = rng_criar(semente_padrao, atomic_fetch_add(&proximo_id_padrao, 1));
+        fluxo_padrao_pronto = 1;
+    }
+    return &fluxo_padrao;
+}
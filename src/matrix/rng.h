@@ -0,0 +1,41 @@
+#ifndef _H_RNG
+#define _H_RNG
+
+#include <stddef.h>
+#include <stdint.h>
+#include "matrix.h"
+
+/** Semente usada pelos fluxos padrão enquanto `rng_definir_semente` não é chamada. */
+#define RNG_SEMENTE_PADRAO 0x5EED5EEDULL
+
+/** Um fluxo do gerador contador Philox4x32-10.
+ *Cada chamada do gerador cifra o contador de 128 bits {contador, fluxo} com a chave e devolve 4 palavras de 32 bits; não há outro estado.
+ Fluxos com a mesma semente e identificadores diferentes são independentes, e o mesmo par (semente, identificador) reproduz sempre a mesma sequência, em qualquer thread e em qualquer ordem.
+ */
+typedef struct rng_fluxo {
+    uint32_t chave[2]; ///< Chave do Philox, derivada da semente
+    uint32_t id[2]; ///< Identificador do fluxo (metade alta do contador)
+    uint64_t contador; ///< Próximo bloco do fluxo (metade baixa do contador)
+} rng_fluxo;
+
+//Função: Criação do fluxo `id` da semente `semente`.
+rng_fluxo rng_criar(uint64_t semente, uint64_t id);
+//Função: Criação de um subfluxo independente de `pai`, identificado por `indice` (por exemplo, um bloco ou um teste).
+rng_fluxo rng_subfluxo(const rng_fluxo *pai, uint64_t indice);
+//Função: Próximas 4 palavras de 32 bits do fluxo.
+void rng_bloco(rng_fluxo *f, uint32_t saida[4]);
+//Função: Preenchimento de `x` com `n` amostras uniformes em (0, 1).
+void rng_uniforme(rng_fluxo *f, double *x, size_t n);
+//Função: Preenchimento de `x` com `n` amostras gaussianas de média 0 e desvio padrão `sigma`.
+void rng_gaussiana(rng_fluxo *f, double *x, size_t n, double sigma);
+//Função: Soma de `n` amostras gaussianas de média 0 e desvio padrão `sigma` sobre `x`.
+void rng_gaussiana_add(rng_fluxo *f, double *x, size_t n, double sigma);
+//Função: Soma de ruído gaussiano complexo (desvio `sigma` em cada componente) sobre os `n` elementos de `x`.
+void rng_cgaussiana_add(rng_fluxo *f, complexo *x, size_t n, double sigma);
+//Função: Define a semente dos fluxos padrão das threads (os já criados não mudam).
+void rng_definir_semente(uint64_t semente);
+//Função: Define o fluxo ativo da thread atual (NULL volta ao fluxo padrão) e retorna o anterior.
+rng_fluxo *rng_usar(rng_fluxo *f);
+//Função: Fluxo ativo da thread atual; sem um fluxo definido por `rng_usar`, o fluxo padrão da thread.
+rng_fluxo *rng_ativo(void);
+#endif
@@ -0,0 +1,1001 @@
+/// @file simd.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86 1
+#endif
+
+/*
+ * Scalar kernels: used on architectures without SSE2 and for the tails of the vector kernels.
+ */
+
+static void add_escalar(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        r[i].real = a[i].real + b[i].real;
+        r[i].img = a[i].img + b[i].img;
+    }
+}
+
+static void sub_escalar(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        r[i].real = a[i].real - b[i].real;
+        r[i].img = a[i].img - b[i].img;
+    }
+}
+
+static void conj_escalar(complexo *r, const complexo *a, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        r[i].real = a[i].real;
+        r[i].img = -a[i].img;
+    }
+}
+
+static void scale_escalar(complexo *r, const complexo *a, double k, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        r[i].real = k * a[i].real;
+        r[i].img = k * a[i].img;
+    }
+}
+
+static void scale_sign_escalar(complexo *r, unsigned char *s, const complexo *a, double k, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        r[i].real = k * a[i].real;
+        r[i].img = k * a[i].img;
+        s[i] = (unsigned char) (signbit(r[i].real) ? 1 : 0) | (signbit(r[i].img) ? 2 : 0);
+    }
+}
+
+static void llr_qpsk_escalar(float *llr, size_t passo, const complexo *a, double k, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        llr[i * passo] = (float) (k * a[i].img);
+        llr[i * passo + 1] = (float) (-k * a[i].real);
+    }
+}
+
+static void mul_escalar(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        r[i] = multcomp(a[i], b[i]);
+    }
+}
+
+static void axpy_escalar(complexo *r, complexo alpha, const complexo *x, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        r[i] = soma_complexo(r[i], multcomp(alpha, x[i]));
+    }
+}
+
+static double power_escalar(const complexo *a, size_t n)
+{
+    double soma = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        soma += a[i].real * a[i].real + a[i].img * a[i].img;
+    }
+    return soma;
+}
+
+static double error_power_escalar(const complexo *a, const complexo *b, size_t n)
+{
+    double soma = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        double dr = a[i].real - b[i].real;
+        double di = a[i].img - b[i].img;
+        soma += dr * dr + di * di;
+    }
+    return soma;
+}
+
+static complexo dotc_escalar(const complexo *a, const complexo *b, size_t n)
+{
+    complexo soma = {0, 0};
+    for (size_t i = 0; i < n; i++)
+    {
+        soma.real += a[i].real * b[i].real + a[i].img * b[i].img;
+        soma.img += a[i].real * b[i].img - a[i].img * b[i].real;
+    }
+    return soma;
+}
+
+static void rot_escalar(complexo *a, complexo *b, double c, complexo s, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        complexo x = a[i], y = b[i];
+        a[i].real = c * x.real - (s.real * y.real + s.img * y.img);
+        a[i].img = c * x.img - (s.real * y.img - s.img * y.real);
+        b[i].real = s.real * x.real - s.img * x.img + c * y.real;
+        b[i].img = s.real * x.img + s.img * x.real + c * y.img;
+    }
+}
+
+static void split_mul_escalar(double *rr, double *ri, const double *ar, const double *ai, const double *br, const double *bi, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        double re = ar[i] * br[i] - ai[i] * bi[i];
+        double im = ar[i] * bi[i] + ai[i] * br[i];
+        rr[i] = re;
+        ri[i] = im;
+    }
+}
+
+static void split_scale_escalar(double *rr, double *ri, const double *ar, const double *ai, double k, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        rr[i] = k * ar[i];
+        ri[i] = k * ai[i];
+    }
+}
+
+static double quadrados_escalar(const double *x, size_t n)
+{
+    double soma = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        soma += x[i] * x[i];
+    }
+    return soma;
+}
+
+static double quadrados_diff_escalar(const double *x, const double *y, size_t n)
+{
+    double soma = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        double d = x[i] - y[i];
+        soma += d * d;
+    }
+    return soma;
+}
+
+static double split_power_escalar(const double *ar, const double *ai, size_t n)
+{
+    return quadrados_escalar(ar, n) + quadrados_escalar(ai, n);
+}
+
+static double split_error_power_escalar(const double *ar, const double *ai, const double *br, const double *bi, size_t n)
+{
+    return quadrados_diff_escalar(ar, br, n) + quadrados_diff_escalar(ai, bi, n);
+}
+
+static const simd_kernels kernels_escalar = {
+    SIMD_ESCALAR, "scalar", add_escalar, sub_escalar, conj_escalar, scale_escalar, scale_sign_escalar, llr_qpsk_escalar,
+    mul_escalar, axpy_escalar, power_escalar, error_power_escalar, dotc_escalar, rot_escalar,
+    split_mul_escalar, split_scale_escalar, split_power_escalar, split_error_power_escalar
+};
+
+#ifdef SIMD_X86
+
+/*
+ * SSE2 kernels: one complex number per register. SSE2 has no addsub, so the sign of the
+ * real part of the cross term is flipped with a xor.
+ */
+
+static void add_sse2(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        _mm_storeu_pd(&r[i].real, _mm_add_pd(_mm_loadu_pd(&a[i].real), _mm_loadu_pd(&b[i].real)));
+    }
+}
+
+static void sub_sse2(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        _mm_storeu_pd(&r[i].real, _mm_sub_pd(_mm_loadu_pd(&a[i].real), _mm_loadu_pd(&b[i].real)));
+    }
+}
+
+static void conj_sse2(complexo *r, const complexo *a, size_t n)
+{
+    const __m128d sinal = _mm_set_pd(-0.0, 0.0);
+    for (size_t i = 0; i < n; i++)
+    {
+        _mm_storeu_pd(&r[i].real, _mm_xor_pd(_mm_loadu_pd(&a[i].real), sinal));
+    }
+}
+
+static void scale_sse2(complexo *r, const complexo *a, double k, size_t n)
+{
+    const __m128d vk = _mm_set1_pd(k);
+    for (size_t i = 0; i < n; i++)
+    {
+        _mm_storeu_pd(&r[i].real, _mm_mul_pd(_mm_loadu_pd(&a[i].real), vk));
+    }
+}
+
+static void scale_sign_sse2(complexo *r, unsigned char *s, const complexo *a, double k, size_t n)
+{
+    // The sign bits of the two lanes are the two bits of the decision
+    const __m128d vk = _mm_set1_pd(k);
+    for (size_t i = 0; i < n; i++)
+    {
+        __m128d v = _mm_mul_pd(_mm_loadu_pd(&a[i].real), vk);
+        _mm_storeu_pd(&r[i].real, v);
+        s[i] = (unsigned char) _mm_movemask_pd(v);
+    }
+}
+
+static void llr_qpsk_sse2(float *llr, size_t passo, const complexo *a, double k, size_t n)
+{
+    // (re, im) -> (k*im, -k*re): the lanes are swapped, scaled and narrowed to float
+    const __m128d vk = _mm_set_pd(-k, k);
+    for (size_t i = 0; i < n; i++)
+    {
+        __m128d v = _mm_loadu_pd(&a[i].real);
+        __m128 f = _mm_cvtpd_ps(_mm_mul_pd(_mm_shuffle_pd(v, v, 1), vk));
+        _mm_storel_pi((__m64 *) &llr[i * passo], f);
+    }
+}
+
+static inline __m128d cmul_sse2(__m128d a, __m128d b)
+{
+    const __m128d sinal = _mm_set_pd(0.0, -0.0);
+    __m128d b_re = _mm_shuffle_pd(b, b, 0);
+    __m128d b_im = _mm_shuffle_pd(b, b, 3);
+    __m128d a_sw = _mm_shuffle_pd(a, a, 1);
+    return _mm_add_pd(_mm_mul_pd(a, b_re), _mm_xor_pd(_mm_mul_pd(a_sw, b_im), sinal));
+}
+
+static void mul_sse2(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        _mm_storeu_pd(&r[i].real, cmul_sse2(_mm_loadu_pd(&a[i].real), _mm_loadu_pd(&b[i].real)));
+    }
+}
+
+static void axpy_sse2(complexo *r, complexo alpha, const complexo *x, size_t n)
+{
+    const __m128d va = _mm_set_pd(alpha.img, alpha.real);
+    for (size_t i = 0; i < n; i++)
+    {
+        __m128d vr = _mm_loadu_pd(&r[i].real);
+        _mm_storeu_pd(&r[i].real, _mm_add_pd(vr, cmul_sse2(_mm_loadu_pd(&x[i].real), va)));
+    }
+}
+
+static double power_sse2(const complexo *a, size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d v0 = _mm_loadu_pd(&a[i].real), v1 = _mm_loadu_pd(&a[i + 1].real);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(v0, v0));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(v1, v1));
+    }
+    double t[2];
+    _mm_storeu_pd(t, _mm_add_pd(acc0, acc1));
+    return t[0] + t[1] + power_escalar(a + i, n - i);
+}
+
+static double error_power_sse2(const complexo *a, const complexo *b, size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d d0 = _mm_sub_pd(_mm_loadu_pd(&a[i].real), _mm_loadu_pd(&b[i].real));
+        __m128d d1 = _mm_sub_pd(_mm_loadu_pd(&a[i + 1].real), _mm_loadu_pd(&b[i + 1].real));
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(d0, d0));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(d1, d1));
+    }
+    double t[2];
+    _mm_storeu_pd(t, _mm_add_pd(acc0, acc1));
+    return t[0] + t[1] + error_power_escalar(a + i, b + i, n - i);
+}
+
+/*
+ * The conjugated dot product keeps two sums: a*b gives the terms of the real part in both
+ * lanes and swap(a)*b the two terms of the imaginary part, subtracted only at the end.
+ */
+static complexo dotc_sse2(const complexo *a, const complexo *b, size_t n)
+{
+    __m128d re = _mm_setzero_pd(), im = _mm_setzero_pd();
+    for (size_t i = 0; i < n; i++)
+    {
+        __m128d va = _mm_loadu_pd(&a[i].real), vb = _mm_loadu_pd(&b[i].real);
+        re = _mm_add_pd(re, _mm_mul_pd(va, vb));
+        im = _mm_add_pd(im, _mm_mul_pd(_mm_shuffle_pd(va, va, 1), vb));
+    }
+    double tr[2], ti[2];
+    _mm_storeu_pd(tr, re);
+    _mm_storeu_pd(ti, im);
+    complexo soma = {tr[0] + tr[1], ti[1] - ti[0]};
+    return soma;
+}
+
+static void rot_sse2(complexo *a, complexo *b, double c, complexo s, size_t n)
+{
+    const __m128d vc = _mm_set1_pd(c), vs = _mm_set_pd(s.img, s.real), vsc = _mm_set_pd(-s.img, s.real);
+    for (size_t i = 0; i < n; i++)
+    {
+        __m128d x = _mm_loadu_pd(&a[i].real), y = _mm_loadu_pd(&b[i].real);
+        _mm_storeu_pd(&a[i].real, _mm_sub_pd(_mm_mul_pd(vc, x), cmul_sse2(y, vsc)));
+        _mm_storeu_pd(&b[i].real, _mm_add_pd(cmul_sse2(x, vs), _mm_mul_pd(vc, y)));
+    }
+}
+
+/*
+ * Split kernels: the real and imaginary parts are in separate planes, so the complex
+ * product needs no shuffles and every lane holds the same kind of component.
+ */
+
+static void split_mul_sse2(double *rr, double *ri, const double *ar, const double *ai, const double *br, const double *bi, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d xr = _mm_loadu_pd(ar + i), xi = _mm_loadu_pd(ai + i);
+        __m128d yr = _mm_loadu_pd(br + i), yi = _mm_loadu_pd(bi + i);
+        _mm_storeu_pd(rr + i, _mm_sub_pd(_mm_mul_pd(xr, yr), _mm_mul_pd(xi, yi)));
+        _mm_storeu_pd(ri + i, _mm_add_pd(_mm_mul_pd(xr, yi), _mm_mul_pd(xi, yr)));
+    }
+    split_mul_escalar(rr + i, ri + i, ar + i, ai + i, br + i, bi + i, n - i);
+}
+
+static void split_scale_sse2(double *rr, double *ri, const double *ar, const double *ai, double k, size_t n)
+{
+    const __m128d vk = _mm_set1_pd(k);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm_storeu_pd(rr + i, _mm_mul_pd(_mm_loadu_pd(ar + i), vk));
+        _mm_storeu_pd(ri + i, _mm_mul_pd(_mm_loadu_pd(ai + i), vk));
+    }
+    split_scale_escalar(rr + i, ri + i, ar + i, ai + i, k, n - i);
+}
+
+static double split_power_sse2(const double *ar, const double *ai, size_t n)
+{
+    // A plane of n doubles has the memory layout of n/2 interleaved complex numbers
+    return power_sse2((const complexo *) ar, n / 2) + power_sse2((const complexo *) ai, n / 2)
+           + quadrados_escalar(ar + n / 2 * 2, n % 2) + quadrados_escalar(ai + n / 2 * 2, n % 2);
+}
+
+static double split_error_power_sse2(const double *ar, const double *ai, const double *br, const double *bi, size_t n)
+{
+    return error_power_sse2((const complexo *) ar, (const complexo *) br, n / 2) + error_power_sse2((const complexo *) ai, (const complexo *) bi, n / 2)
+           + quadrados_diff_escalar(ar + n / 2 * 2, br + n / 2 * 2, n % 2) + quadrados_diff_escalar(ai + n / 2 * 2, bi + n / 2 * 2, n % 2);
+}
+
+static const simd_kernels kernels_sse2 = {
+    SIMD_SSE2, "sse2", add_sse2, sub_sse2, conj_sse2, scale_sse2, scale_sign_sse2, llr_qpsk_sse2,
+    mul_sse2, axpy_sse2, power_sse2, error_power_sse2, dotc_sse2, rot_sse2,
+    split_mul_sse2, split_scale_sse2, split_power_sse2, split_error_power_sse2
+};
+
+/*
+ * AVX2 + FMA kernels: two complex numbers per register. The complex product uses
+ * fmaddsub over the duplicated real and imaginary parts of the second operand.
+ */
+
+#define ALVO_AVX2 __attribute__((target("avx2,fma")))
+
+ALVO_AVX2 static void add_avx2(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm256_storeu_pd(&r[i].real, _mm256_add_pd(_mm256_loadu_pd(&a[i].real), _mm256_loadu_pd(&b[i].real)));
+    }
+    add_escalar(r + i, a + i, b + i, n - i);
+}
+
+ALVO_AVX2 static void sub_avx2(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm256_storeu_pd(&r[i].real, _mm256_sub_pd(_mm256_loadu_pd(&a[i].real), _mm256_loadu_pd(&b[i].real)));
+    }
+    sub_escalar(r + i, a + i, b + i, n - i);
+}
+
+ALVO_AVX2 static void conj_avx2(complexo *r, const complexo *a, size_t n)
+{
+    const __m256d sinal = _mm256_set_pd(-0.0, 0.0, -0.0, 0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm256_storeu_pd(&r[i].real, _mm256_xor_pd(_mm256_loadu_pd(&a[i].real), sinal));
+    }
+    conj_escalar(r + i, a + i, n - i);
+}
+
+ALVO_AVX2 static void scale_avx2(complexo *r, const complexo *a, double k, size_t n)
+{
+    const __m256d vk = _mm256_set1_pd(k);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm256_storeu_pd(&r[i].real, _mm256_mul_pd(_mm256_loadu_pd(&a[i].real), vk));
+    }
+    scale_escalar(r + i, a + i, k, n - i);
+}
+
+ALVO_AVX2 static void scale_sign_avx2(complexo *r, unsigned char *s, const complexo *a, double k, size_t n)
+{
+    const __m256d vk = _mm256_set1_pd(k);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m256d v = _mm256_mul_pd(_mm256_loadu_pd(&a[i].real), vk);
+        _mm256_storeu_pd(&r[i].real, v);
+        int m = _mm256_movemask_pd(v);
+        s[i] = (unsigned char) (m & 3);
+        s[i + 1] = (unsigned char) (m >> 2);
+    }
+    scale_sign_escalar(r + i, s + i, a + i, k, n - i);
+}
+
+ALVO_AVX2 static void llr_qpsk_avx2(float *llr, size_t passo, const complexo *a, double k, size_t n)
+{
+    const __m256d vk = _mm256_set_pd(-k, k, -k, k);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m256d v = _mm256_loadu_pd(&a[i].real);
+        __m128 f = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_permute_pd(v, 5), vk));
+        if (passo == 2)
+        {
+            _mm_storeu_ps(&llr[i * 2], f);
+        }
+        else
+        {
+            _mm_storel_pi((__m64 *) &llr[i * passo], f);
+            _mm_storeh_pi((__m64 *) &llr[(i + 1) * passo], f);
+        }
+    }
+    llr_qpsk_escalar(llr + i * passo, passo, a + i, k, n - i);
+}
+
+ALVO_AVX2 static inline __m256d cmul_avx2(__m256d a, __m256d b)
+{
+    __m256d b_re = _mm256_movedup_pd(b);
+    __m256d b_im = _mm256_permute_pd(b, 0xF);
+    __m256d a_sw = _mm256_permute_pd(a, 0x5);
+    return _mm256_fmaddsub_pd(a, b_re, _mm256_mul_pd(a_sw, b_im));
+}
+
+ALVO_AVX2 static void mul_avx2(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm256_storeu_pd(&r[i].real, cmul_avx2(_mm256_loadu_pd(&a[i].real), _mm256_loadu_pd(&b[i].real)));
+    }
+    mul_escalar(r + i, a + i, b + i, n - i);
+}
+
+ALVO_AVX2 static void axpy_avx2(complexo *r, complexo alpha, const complexo *x, size_t n)
+{
+    const __m256d va = _mm256_set_pd(alpha.img, alpha.real, alpha.img, alpha.real);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m256d vr = _mm256_loadu_pd(&r[i].real);
+        _mm256_storeu_pd(&r[i].real, _mm256_add_pd(vr, cmul_avx2(_mm256_loadu_pd(&x[i].real), va)));
+    }
+    axpy_escalar(r + i, alpha, x + i, n - i);
+}
+
+ALVO_AVX2 static double power_avx2(const complexo *a, size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d v0 = _mm256_loadu_pd(&a[i].real), v1 = _mm256_loadu_pd(&a[i + 2].real);
+        acc0 = _mm256_fmadd_pd(v0, v0, acc0);
+        acc1 = _mm256_fmadd_pd(v1, v1, acc1);
+    }
+    double t[4];
+    _mm256_storeu_pd(t, _mm256_add_pd(acc0, acc1));
+    return (t[0] + t[1]) + (t[2] + t[3]) + power_escalar(a + i, n - i);
+}
+
+ALVO_AVX2 static double error_power_avx2(const complexo *a, const complexo *b, size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(&a[i].real), _mm256_loadu_pd(&b[i].real));
+        __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(&a[i + 2].real), _mm256_loadu_pd(&b[i + 2].real));
+        acc0 = _mm256_fmadd_pd(d0, d0, acc0);
+        acc1 = _mm256_fmadd_pd(d1, d1, acc1);
+    }
+    double t[4];
+    _mm256_storeu_pd(t, _mm256_add_pd(acc0, acc1));
+    return (t[0] + t[1]) + (t[2] + t[3]) + error_power_escalar(a + i, b + i, n - i);
+}
+
+ALVO_AVX2 static void split_mul_avx2(double *rr, double *ri, const double *ar, const double *ai, const double *br, const double *bi, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d xr = _mm256_loadu_pd(ar + i), xi = _mm256_loadu_pd(ai + i);
+        __m256d yr = _mm256_loadu_pd(br + i), yi = _mm256_loadu_pd(bi + i);
+        _mm256_storeu_pd(rr + i, _mm256_fmsub_pd(xr, yr, _mm256_mul_pd(xi, yi)));
+        _mm256_storeu_pd(ri + i, _mm256_fmadd_pd(xr, yi, _mm256_mul_pd(xi, yr)));
+    }
+    split_mul_escalar(rr + i, ri + i, ar + i, ai + i, br + i, bi + i, n - i);
+}
+
+ALVO_AVX2 static void split_scale_avx2(double *rr, double *ri, const double *ar, const double *ai, double k, size_t n)
+{
+    const __m256d vk = _mm256_set1_pd(k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm256_storeu_pd(rr + i, _mm256_mul_pd(_mm256_loadu_pd(ar + i), vk));
+        _mm256_storeu_pd(ri + i, _mm256_mul_pd(_mm256_loadu_pd(ai + i), vk));
+    }
+    split_scale_escalar(rr + i, ri + i, ar + i, ai + i, k, n - i);
+}
+
+ALVO_AVX2 static complexo dotc_avx2(const complexo *a, const complexo *b, size_t n)
+{
+    __m256d re0 = _mm256_setzero_pd(), im0 = _mm256_setzero_pd(), re1 = _mm256_setzero_pd(), im1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d a0 = _mm256_loadu_pd(&a[i].real), a1 = _mm256_loadu_pd(&a[i + 2].real);
+        __m256d b0 = _mm256_loadu_pd(&b[i].real), b1 = _mm256_loadu_pd(&b[i + 2].real);
+        re0 = _mm256_fmadd_pd(a0, b0, re0);
+        re1 = _mm256_fmadd_pd(a1, b1, re1);
+        im0 = _mm256_fmadd_pd(_mm256_permute_pd(a0, 0x5), b0, im0);
+        im1 = _mm256_fmadd_pd(_mm256_permute_pd(a1, 0x5), b1, im1);
+    }
+    double tr[4], ti[4];
+    _mm256_storeu_pd(tr, _mm256_add_pd(re0, re1));
+    _mm256_storeu_pd(ti, _mm256_add_pd(im0, im1));
+    complexo resto = dotc_escalar(a + i, b + i, n - i);
+    complexo soma = {(tr[0] + tr[1]) + (tr[2] + tr[3]) + resto.real, (ti[1] - ti[0]) + (ti[3] - ti[2]) + resto.img};
+    return soma;
+}
+
+ALVO_AVX2 static void rot_avx2(complexo *a, complexo *b, double c, complexo s, size_t n)
+{
+    const __m256d vc = _mm256_set1_pd(c);
+    const __m256d vs = _mm256_set_pd(s.img, s.real, s.img, s.real), vsc = _mm256_set_pd(-s.img, s.real, -s.img, s.real);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m256d x = _mm256_loadu_pd(&a[i].real), y = _mm256_loadu_pd(&b[i].real);
+        _mm256_storeu_pd(&a[i].real, _mm256_fmsub_pd(vc, x, cmul_avx2(y, vsc)));
+        _mm256_storeu_pd(&b[i].real, _mm256_fmadd_pd(vc, y, cmul_avx2(x, vs)));
+    }
+    rot_escalar(a + i, b + i, c, s, n - i);
+}
+
+ALVO_AVX2 static double split_power_avx2(const double *ar, const double *ai, size_t n)
+{
+    return power_avx2((const complexo *) ar, n / 2) + power_avx2((const complexo *) ai, n / 2)
+           + quadrados_escalar(ar + n / 2 * 2, n % 2) + quadrados_escalar(ai + n / 2 * 2, n % 2);
+}
+
+ALVO_AVX2 static double split_error_power_avx2(const double *ar, const double *ai, const double *br, const double *bi, size_t n)
+{
+    return error_power_avx2((const complexo *) ar, (const complexo *) br, n / 2) + error_power_avx2((const complexo *) ai, (const complexo *) bi, n / 2)
+           + quadrados_diff_escalar(ar + n / 2 * 2, br + n / 2 * 2, n % 2) + quadrados_diff_escalar(ai + n / 2 * 2, bi + n / 2 * 2, n % 2);
+}
+
+static const simd_kernels kernels_avx2 = {
+    SIMD_AVX2, "avx2+fma", add_avx2, sub_avx2, conj_avx2, scale_avx2, scale_sign_avx2, llr_qpsk_avx2,
+    mul_avx2, axpy_avx2, power_avx2, error_power_avx2, dotc_avx2, rot_avx2,
+    split_mul_avx2, split_scale_avx2, split_power_avx2, split_error_power_avx2
+};
+
+/*
+ * AVX-512F kernels: four complex numbers per register.
+ */
+
+#define ALVO_AVX512 __attribute__((target("avx512f")))
+
+ALVO_AVX512 static void add_avx512(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm512_storeu_pd(&r[i].real, _mm512_add_pd(_mm512_loadu_pd(&a[i].real), _mm512_loadu_pd(&b[i].real)));
+    }
+    add_escalar(r + i, a + i, b + i, n - i);
+}
+
+ALVO_AVX512 static void sub_avx512(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm512_storeu_pd(&r[i].real, _mm512_sub_pd(_mm512_loadu_pd(&a[i].real), _mm512_loadu_pd(&b[i].real)));
+    }
+    sub_escalar(r + i, a + i, b + i, n - i);
+}
+
+ALVO_AVX512 static void conj_avx512(complexo *r, const complexo *a, size_t n)
+{
+    // Negates the odd lanes (imaginary parts) with a masked subtraction from zero
+    const __mmask8 impares = 0xAA;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m512d v = _mm512_loadu_pd(&a[i].real);
+        _mm512_storeu_pd(&r[i].real, _mm512_mask_sub_pd(v, impares, _mm512_setzero_pd(), v));
+    }
+    conj_escalar(r + i, a + i, n - i);
+}
+
+ALVO_AVX512 static void scale_avx512(complexo *r, const complexo *a, double k, size_t n)
+{
+    const __m512d vk = _mm512_set1_pd(k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm512_storeu_pd(&r[i].real, _mm512_mul_pd(_mm512_loadu_pd(&a[i].real), vk));
+    }
+    scale_escalar(r + i, a + i, k, n - i);
+}
+
+ALVO_AVX512 static void scale_sign_avx512(complexo *r, unsigned char *s, const complexo *a, double k, size_t n)
+{
+    // AVX-512F has no movemask for doubles: the sign bits are tested as integers
+    const __m512d vk = _mm512_set1_pd(k);
+    const __m512i sinal = _mm512_set1_epi64((long long) 0x8000000000000000ULL);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m512d v = _mm512_mul_pd(_mm512_loadu_pd(&a[i].real), vk);
+        _mm512_storeu_pd(&r[i].real, v);
+        unsigned m = _mm512_test_epi64_mask(_mm512_castpd_si512(v), sinal);
+        s[i] = (unsigned char) (m & 3);
+        s[i + 1] = (unsigned char) ((m >> 2) & 3);
+        s[i + 2] = (unsigned char) ((m >> 4) & 3);
+        s[i + 3] = (unsigned char) (m >> 6);
+    }
+    scale_sign_escalar(r + i, s + i, a + i, k, n - i);
+}
+
+ALVO_AVX512 static void llr_qpsk_avx512(float *llr, size_t passo, const complexo *a, double k, size_t n)
+{
+    const __m512d vk = _mm512_set_pd(-k, k, -k, k, -k, k, -k, k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m512d v = _mm512_loadu_pd(&a[i].real);
+        __m256 f = _mm512_cvtpd_ps(_mm512_mul_pd(_mm512_permute_pd(v, 0x55), vk));
+        if (passo == 2)
+        {
+            _mm256_storeu_ps(&llr[i * 2], f);
+        }
+        else
+        {
+            __m128 f0 = _mm256_castps256_ps128(f), f1 = _mm256_extractf128_ps(f, 1);
+            _mm_storel_pi((__m64 *) &llr[i * passo], f0);
+            _mm_storeh_pi((__m64 *) &llr[(i + 1) * passo], f0);
+            _mm_storel_pi((__m64 *) &llr[(i + 2) * passo], f1);
+            _mm_storeh_pi((__m64 *) &llr[(i + 3) * passo], f1);
+        }
+    }
+    llr_qpsk_escalar(llr + i * passo, passo, a + i, k, n - i);
+}
+
+ALVO_AVX512 static inline __m512d cmul_avx512(__m512d a, __m512d b)
+{
+    __m512d b_re = _mm512_movedup_pd(b);
+    __m512d b_im = _mm512_permute_pd(b, 0xFF);
+    __m512d a_sw = _mm512_permute_pd(a, 0x55);
+    return _mm512_fmaddsub_pd(a, b_re, _mm512_mul_pd(a_sw, b_im));
+}
+
+ALVO_AVX512 static void mul_avx512(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm512_storeu_pd(&r[i].real, cmul_avx512(_mm512_loadu_pd(&a[i].real), _mm512_loadu_pd(&b[i].real)));
+    }
+    mul_escalar(r + i, a + i, b + i, n - i);
+}
+
+ALVO_AVX512 static void axpy_avx512(complexo *r, complexo alpha, const complexo *x, size_t n)
+{
+    const __m512d va = _mm512_set_pd(alpha.img, alpha.real, alpha.img, alpha.real, alpha.img, alpha.real, alpha.img, alpha.real);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m512d vr = _mm512_loadu_pd(&r[i].real);
+        _mm512_storeu_pd(&r[i].real, _mm512_add_pd(vr, cmul_avx512(_mm512_loadu_pd(&x[i].real), va)));
+    }
+    axpy_escalar(r + i, alpha, x + i, n - i);
+}
+
+ALVO_AVX512 static double power_avx512(const complexo *a, size_t n)
+{
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d v0 = _mm512_loadu_pd(&a[i].real), v1 = _mm512_loadu_pd(&a[i + 4].real);
+        acc0 = _mm512_fmadd_pd(v0, v0, acc0);
+        acc1 = _mm512_fmadd_pd(v1, v1, acc1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1)) + power_escalar(a + i, n - i);
+}
+
+ALVO_AVX512 static double error_power_avx512(const complexo *a, const complexo *b, size_t n)
+{
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(&a[i].real), _mm512_loadu_pd(&b[i].real));
+        __m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(&a[i + 4].real), _mm512_loadu_pd(&b[i + 4].real));
+        acc0 = _mm512_fmadd_pd(d0, d0, acc0);
+        acc1 = _mm512_fmadd_pd(d1, d1, acc1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1)) + error_power_escalar(a + i, b + i, n - i);
+}
+
+ALVO_AVX512 static void split_mul_avx512(double *rr, double *ri, const double *ar, const double *ai, const double *br, const double *bi, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d xr = _mm512_loadu_pd(ar + i), xi = _mm512_loadu_pd(ai + i);
+        __m512d yr = _mm512_loadu_pd(br + i), yi = _mm512_loadu_pd(bi + i);
+        _mm512_storeu_pd(rr + i, _mm512_fmsub_pd(xr, yr, _mm512_mul_pd(xi, yi)));
+        _mm512_storeu_pd(ri + i, _mm512_fmadd_pd(xr, yi, _mm512_mul_pd(xi, yr)));
+    }
+    split_mul_escalar(rr + i, ri + i, ar + i, ai + i, br + i, bi + i, n - i);
+}
+
+ALVO_AVX512 static void split_scale_avx512(double *rr, double *ri, const double *ar, const double *ai, double k, size_t n)
+{
+    const __m512d vk = _mm512_set1_pd(k);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm512_storeu_pd(rr + i, _mm512_mul_pd(_mm512_loadu_pd(ar + i), vk));
+        _mm512_storeu_pd(ri + i, _mm512_mul_pd(_mm512_loadu_pd(ai + i), vk));
+    }
+    split_scale_escalar(rr + i, ri + i, ar + i, ai + i, k, n - i);
+}
+
+ALVO_AVX512 static complexo dotc_avx512(const complexo *a, const complexo *b, size_t n)
+{
+    __m512d re0 = _mm512_setzero_pd(), im0 = _mm512_setzero_pd(), re1 = _mm512_setzero_pd(), im1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d a0 = _mm512_loadu_pd(&a[i].real), a1 = _mm512_loadu_pd(&a[i + 4].real);
+        __m512d b0 = _mm512_loadu_pd(&b[i].real), b1 = _mm512_loadu_pd(&b[i + 4].real);
+        re0 = _mm512_fmadd_pd(a0, b0, re0);
+        re1 = _mm512_fmadd_pd(a1, b1, re1);
+        im0 = _mm512_fmadd_pd(_mm512_permute_pd(a0, 0x55), b0, im0);
+        im1 = _mm512_fmadd_pd(_mm512_permute_pd(a1, 0x55), b1, im1);
+    }
+    // The imaginary terms of the even lanes are subtracted
+    const __m512d sinal = _mm512_set_pd(1, -1, 1, -1, 1, -1, 1, -1);
+    complexo resto = dotc_escalar(a + i, b + i, n - i);
+    complexo soma = {_mm512_reduce_add_pd(_mm512_add_pd(re0, re1)) + resto.real,
+                     _mm512_reduce_add_pd(_mm512_mul_pd(_mm512_add_pd(im0, im1), sinal)) + resto.img};
+    return soma;
+}
+
+ALVO_AVX512 static void rot_avx512(complexo *a, complexo *b, double c, complexo s, size_t n)
+{
+    const __m512d vc = _mm512_set1_pd(c);
+    const __m512d vs = _mm512_set_pd(s.img, s.real, s.img, s.real, s.img, s.real, s.img, s.real);
+    const __m512d vsc = _mm512_set_pd(-s.img, s.real, -s.img, s.real, -s.img, s.real, -s.img, s.real);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m512d x = _mm512_loadu_pd(&a[i].real), y = _mm512_loadu_pd(&b[i].real);
+        _mm512_storeu_pd(&a[i].real, _mm512_fmsub_pd(vc, x, cmul_avx512(y, vsc)));
+        _mm512_storeu_pd(&b[i].real, _mm512_fmadd_pd(vc, y, cmul_avx512(x, vs)));
+    }
+    rot_escalar(a + i, b + i, c, s, n - i);
+}
+
+ALVO_AVX512 static double split_power_avx512(const double *ar, const double *ai, size_t n)
+{
+    return power_avx512((const complexo *) ar, n / 2) + power_avx512((const complexo *) ai, n / 2)
+           + quadrados_escalar(ar + n / 2 * 2, n % 2) + quadrados_escalar(ai + n / 2 * 2, n % 2);
+}
+
+ALVO_AVX512 static double split_error_power_avx512(const double *ar, const double *ai, const double *br, const double *bi, size_t n)
+{
+    return error_power_avx512((const complexo *) ar, (const complexo *) br, n / 2) + error_power_avx512((const complexo *) ai, (const complexo *) bi, n / 2)
+           + quadrados_diff_escalar(ar + n / 2 * 2, br + n / 2 * 2, n % 2) + quadrados_diff_escalar(ai + n / 2 * 2, bi + n / 2 * 2, n % 2);
+}
+
+static const simd_kernels kernels_avx512 = {
+    SIMD_AVX512, "avx512f", add_avx512, sub_avx512, conj_avx512, scale_avx512, scale_sign_avx512, llr_qpsk_avx512,
+    mul_avx512, axpy_avx512, power_avx512, error_power_avx512, dotc_avx512, rot_avx512,
+    split_mul_avx512, split_scale_avx512, split_power_avx512, split_error_power_avx512
+};
+
+#endif
+
+static const simd_kernels *kernels_escolhidos = NULL;
+
+/**###SIMD Dispatch Function:
+ * The `simd_get` function returns the kernel table of the best instruction set supported by the host.
+- On the first call the processor is inspected with CPUID (`__builtin_cpu_supports`): AVX-512F is preferred, then AVX2 with FMA, then SSE2, which every x86-64 processor has. Other architectures use the scalar kernels.
+- The environment variable `CMIMO_SIMD` (`scalar`, `sse2`, `avx2` or `avx512`) limits the choice to a lower instruction set, which is useful to compare the kernels on the same host. It never selects an instruction set the host does not support.
+- The choice is made once and the same table is returned afterwards, so a single binary runs the best path on each machine.
+ * @param[out] kernels
+ * */
+const simd_kernels *simd_get(void)
+{
+    if (kernels_escolhidos != NULL)
+    {
+        return kernels_escolhidos;
+    }
+    const simd_kernels *escolha = &kernels_escalar;
+    simd_nivel limite = SIMD_AVX512;
+    const char *env = getenv("CMIMO_SIMD");
+    if (env != NULL)
+    {
+        if (strcmp(env, "scalar") == 0)
+        {
+            limite = SIMD_ESCALAR;
+        }
+        else if (strcmp(env, "sse2") == 0)
+        {
+            limite = SIMD_SSE2;
+        }
+        else if (strcmp(env, "avx2") == 0)
+        {
+            limite = SIMD_AVX2;
+        }
+    }
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (limite >= SIMD_SSE2 && __builtin_cpu_supports("sse2"))
+    {
+        escolha = &kernels_sse2;
+    }
+    if (limite >= SIMD_AVX2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        escolha = &kernels_avx2;
+    }
+    if (limite >= SIMD_AVX512 && __builtin_cpu_supports("avx512f"))
+    {
+        escolha = &kernels_avx512;
+    }
+#endif
+    kernels_escolhidos = escolha;
+    return kernels_escolhidos;
+}
+
+/**Função: Conjunto de instruções escolhido por `simd_get`. */
+simd_nivel simd_get_nivel(void)
+{
+    return simd_get()->nivel;
+}
+
+/**Função: r = a + b, elemento a elemento. `r` pode ser igual a `a` ou `b`. */
+void cvec_add(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    simd_get()->add(r, a, b, n);
+}
+
+/**Função: r = a - b, elemento a elemento. `r` pode ser igual a `a` ou `b`. */
+void cvec_sub(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    simd_get()->sub(r, a, b, n);
+}
+
+/**Função: r = conj(a). `r` pode ser igual a `a`. */
+void cvec_conj(complexo *r, const complexo *a, size_t n)
+{
+    simd_get()->conj(r, a, n);
+}
+
+/**Função: r = k*a, com k real. `r` pode ser igual a `a`. */
+void cvec_scale(complexo *r, const complexo *a, double k, size_t n)
+{
+    simd_get()->scale(r, a, k, n);
+}
+
+/**Função: r = k*a, com k real, e os bits de sinal de cada elemento de `r` em `s`: bit 0 se a parte real é negativa, bit 1 se a parte imaginária é negativa (o bit de sinal do double, como em `signbit`). `r` pode ser igual a `a`. */
+void cvec_scale_sign(complexo *r, unsigned char *s, const complexo *a, double k, size_t n)
+{
+    simd_get()->scale_sign(r, s, a, k, n);
+}
+
+/**Função: LLRs dos dois bits de cada símbolo QPSK: llr[i*passo] = k*Im(a[i]) e llr[i*passo + 1] = -k*Re(a[i]), em float. Com `passo` = 2 os pares são contíguos; um passo maior intercala os pares de vários vetores. */
+void cvec_llr_qpsk(float *llr, size_t passo, const complexo *a, double k, size_t n)
+{
+    simd_get()->llr_qpsk(llr, passo, a, k, n);
+}
+
+/**Função: r = a*b (produto complexo elemento a elemento). `r` pode ser igual a `a` ou `b`. */
+void cvec_mul(complexo *r, const complexo *a, const complexo *b, size_t n)
+{
+    simd_get()->mul(r, a, b, n);
+}
+
+/**Função: r = r + alpha*x (multiplicação-acumulação complexa). */
+void cvec_axpy(complexo *r, complexo alpha, const complexo *x, size_t n)
+{
+    simd_get()->axpy(r, alpha, x, n);
+}
+
+/**Função: Potência (soma de |a|^2) de um vetor complexo. */
+double cvec_power(const complexo *a, size_t n)
+{
+    return simd_get()->power(a, n);
+}
+
+/**Função: Potência do erro (soma de |a - b|^2) entre dois vetores complexos. */
+double cvec_error_power(const complexo *a, const complexo *b, size_t n)
+{
+    return simd_get()->error_power(a, b, n);
+}
+
+/**Função: Produto interno conjugado, soma de conj(a)*b. */
+complexo cvec_dotc(const complexo *a, const complexo *b, size_t n)
+{
+    return simd_get()->dotc(a, b, n);
+}
+
+/**Função: Rotação plana complexa aplicada aos pares (a[i], b[i]), no lugar: a = c*a - conj(s)*b e b = s*a + c*b, com c real. Com c^2 + |s|^2 = 1 a rotação é unitária (`svd.c`). */
+void cvec_rot(complexo *a, complexo *b, double c, complexo s, size_t n)
+{
+    simd_get()->rot(a, b, c, s, n);
+}
+
+/**Função: r = a*b sobre planos separados (produto complexo sem permutações). `r` pode ser igual a `a` ou `b`. */
+void svec_mul(double *rr, double *ri, const double *ar, const double *ai, const double *br, const double *bi, size_t n)
+{
+    simd_get()->split_mul(rr, ri, ar, ai, br, bi, n);
+}
+
+/**Função: r = k*a sobre planos separados, com k real. `r` pode ser igual a `a`. */
+void svec_scale(double *rr, double *ri, const double *ar, const double *ai, double k, size_t n)
+{
+    simd_get()->split_scale(rr, ri, ar, ai, k, n);
+}
+
+/**Função: Potência (soma de |a|^2) de um vetor em planos separados. */
+double svec_power(const double *ar, const double *ai, size_t n)
+{
+    return simd_get()->split_power(ar, ai, n);
+}
+
+/**Função: Potência do erro (soma de |a - b|^2) entre dois vetores em planos separados. */
+double svec_error_power(const double *ar, const double *ai, const double *br, const double *bi, size_t n)
+{
+    return simd_get()->split_error_power(ar, ai, br, bi, n);
+}
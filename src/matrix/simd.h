@@ -0,0 +1,59 @@
+#ifndef _H_SIMD
+#define _H_SIMD
+
+#include <stddef.h>
+#include "matrix.h"
+
+/** Conjunto de instruções vetoriais usado pelos kernels. */
+typedef enum simd_nivel {
+    SIMD_ESCALAR, ///< Código escalar (arquiteturas sem SSE2)
+    SIMD_SSE2,    ///< SSE2, presente em todo processador x86-64
+    SIMD_AVX2,    ///< AVX2 + FMA
+    SIMD_AVX512   ///< AVX-512F
+} simd_nivel;
+
+/** A estrutura `simd_kernels` reúne as implementações de um mesmo conjunto de instruções. Nos kernels `cvec`, os vetores são arrays contíguos de `n` números complexos intercalados (real, imaginário); nos kernels `split_*`, cada vetor é um par de planos contíguos de `n` doubles (partes reais e imaginárias). */
+typedef struct simd_kernels {
+    simd_nivel nivel; ///< Conjunto de instruções desta tabela
+    const char *nome; ///< Nome do conjunto de instruções
+    void (*add)(complexo *r, const complexo *a, const complexo *b, size_t n); ///< r = a + b
+    void (*sub)(complexo *r, const complexo *a, const complexo *b, size_t n); ///< r = a - b
+    void (*conj)(complexo *r, const complexo *a, size_t n); ///< r = conj(a)
+    void (*scale)(complexo *r, const complexo *a, double k, size_t n); ///< r = k*a, com k real
+    void (*scale_sign)(complexo *r, unsigned char *s, const complexo *a, double k, size_t n); ///< r = k*a e os bits de sinal de cada elemento de r em s
+    void (*llr_qpsk)(float *llr, size_t passo, const complexo *a, double k, size_t n); ///< llr[i*passo] = k*Im(a[i]), llr[i*passo+1] = -k*Re(a[i]), em float
+    void (*mul)(complexo *r, const complexo *a, const complexo *b, size_t n); ///< r = a*b, elemento a elemento
+    void (*axpy)(complexo *r, complexo alpha, const complexo *x, size_t n); ///< r = r + alpha*x
+    double (*power)(const complexo *a, size_t n); ///< soma de |a|^2
+    double (*error_power)(const complexo *a, const complexo *b, size_t n); ///< soma de |a - b|^2
+    complexo (*dotc)(const complexo *a, const complexo *b, size_t n); ///< soma de conj(a)*b
+    void (*rot)(complexo *a, complexo *b, double c, complexo s, size_t n); ///< a = c*a - conj(s)*b e b = s*a + c*b, no lugar
+    void (*split_mul)(double *rr, double *ri, const double *ar, const double *ai, const double *br, const double *bi, size_t n); ///< r = a*b sobre planos separados
+    void (*split_scale)(double *rr, double *ri, const double *ar, const double *ai, double k, size_t n); ///< r = k*a sobre planos separados
+    double (*split_power)(const double *ar, const double *ai, size_t n); ///< soma de |a|^2 sobre planos separados
+    double (*split_error_power)(const double *ar, const double *ai, const double *br, const double *bi, size_t n); ///< soma de |a - b|^2 sobre planos separados
+} simd_kernels;
+
+//Função: Tabela de kernels do melhor conjunto de instruções disponível (escolhido uma vez, por CPUID).
+const simd_kernels *simd_get(void);
+//Função: Conjunto de instruções escolhido.
+simd_nivel simd_get_nivel(void);
+//Funções: Operações vetoriais despachadas para a tabela escolhida.
+void cvec_add(complexo *r, const complexo *a, const complexo *b, size_t n);
+void cvec_sub(complexo *r, const complexo *a, const complexo *b, size_t n);
+void cvec_conj(complexo *r, const complexo *a, size_t n);
+void cvec_scale(complexo *r, const complexo *a, double k, size_t n);
+void cvec_scale_sign(complexo *r, unsigned char *s, const complexo *a, double k, size_t n);
+void cvec_llr_qpsk(float *llr, size_t passo, const complexo *a, double k, size_t n);
+void cvec_mul(complexo *r, const complexo *a, const complexo *b, size_t n);
+void cvec_axpy(complexo *r, complexo alpha, const complexo *x, size_t n);
+double cvec_power(const complexo *a, size_t n);
+double cvec_error_power(const complexo *a, const complexo *b, size_t n);
+complexo cvec_dotc(const complexo *a, const complexo *b, size_t n);
+void cvec_rot(complexo *a, complexo *b, double c, complexo s, size_t n);
+//Funções: Operações vetoriais sobre planos separados (real e imaginário) contíguos.
+void svec_mul(double *rr, double *ri, const double *ar, const double *ai, const double *br, const double *bi, size_t n);
+void svec_scale(double *rr, double *ri, const double *ar, const double *ai, double k, size_t n);
+double svec_power(const double *ar, const double *ai, size_t n);
+double svec_error_power(const double *ar, const double *ai, const double *br, const double *bi, size_t n);
+#endif
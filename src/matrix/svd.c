@@ -0,0 +1,625 @@
+/// @file svd.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "svd.h"
+#include "simd.h"
+#include "gemm.h"
+#include "arena.h"
+
+/** Um valor singular e a linha da matriz de trabalho de onde ele saiu, para a ordenação. */
+typedef struct svd_valor {
+    double s; ///< Valor singular
+    int linha; ///< Linha de origem
+} svd_valor;
+
+/* Decreasing singular values; ties keep the order of the rows, so the result does not depend on qsort. */
+static int svd_compara(const void *a, const void *b)
+{
+    const svd_valor *x = a, *y = b;
+    if (x->s != y->s)
+    {
+        return (x->s < y->s) ? 1 : -1;
+    }
+    return x->linha - y->linha;
+}
+
+/**
+ * @brief Rotates rows p and q of W so that they become orthogonal, and applies the same rotation to Q.
+ *
+ * With alpha = |w_p|^2, beta = |w_q|^2 and g = <w_p, w_q> = |g| e^(i phi), the rotation is the real
+ * Jacobi rotation of the 2x2 Gram matrix [alpha |g|; |g| beta] with the phase of g moved into its
+ * sine, which keeps it unitary. The squared norms of the two rows are updated without a new pass.
+ *
+ * A row whose squared norm is at most `nulo` is zero to the rounding of A and is left alone: every
+ * rotation against a large row refills it with rounding errors of that row, so it would never
+ * become orthogonal to it.
+ *
+ * @return 1 if the rows were rotated, 0 if they were already orthogonal to the tolerance or one of them is negligible.
+ */
+static int svd_rotaciona(cmatrix *W, cmatrix *Q, double *norma, int p, int q, double tol, double nulo)
+{
+    if (norma[p] <= nulo || norma[q] <= nulo)
+    {
+        return 0;
+    }
+    complexo *wp = W->data + (size_t) p * W->ld, *wq = W->data + (size_t) q * W->ld;
+    complexo g = cvec_dotc(wp, wq, W->colunas);
+    double modulo = hypot(g.real, g.img);
+    if (modulo == 0 || modulo <= tol * sqrt(norma[p] * norma[q]))
+    {
+        return 0;
+    }
+    double zeta = (norma[q] - norma[p]) / (2 * modulo);
+    double t = (zeta >= 0 ? 1.0 : -1.0) / (fabs(zeta) + sqrt(1 + zeta * zeta));
+    double c = 1 / sqrt(1 + t * t);
+    complexo s = {c * t * g.real / modulo, c * t * g.img / modulo};
+    cvec_rot(wp, wq, c, s, W->colunas);
+    cvec_rot(Q->data + (size_t) p * Q->ld, Q->data + (size_t) q * Q->ld, c, s, Q->colunas);
+    norma[p] = fmax(norma[p] - t * modulo, 0);
+    norma[q] = norma[q] + t * modulo;
+    return 1;
+}
+
+/**
+ * @brief Sets column j of X to a unit vector orthogonal to its columns 0 to j-1, which are orthonormal.
+ *
+ * The candidates are the coordinate vectors, orthogonalized twice by classical Gram-Schmidt; the
+ * first one that keeps at least half of its norm is taken, or the best one if none does.
+ *
+ * @param x, melhor Workspaces of `X->linhas` values.
+ */
+static void svd_completa(cmatrix *X, int j, complexo *x, complexo *melhor)
+{
+    int n = X->linhas;
+    double maior = -1;
+    for (int e = 0; e < n && maior < 0.5; e++)
+    {
+        memset(x, 0, n * sizeof(complexo));
+        x[e].real = 1;
+        for (int passo = 0; passo < 2; passo++)
+        {
+            for (int c = 0; c < j; c++)
+            {
+                complexo h = {0, 0};
+                for (int l = 0; l < n; l++)
+                {
+                    complexo u = CMATRIX_AT(*X, l, c);
+                    h.real += u.real * x[l].real + u.img * x[l].img;
+                    h.img += u.real * x[l].img - u.img * x[l].real;
+                }
+                for (int l = 0; l < n; l++)
+                {
+                    complexo u = CMATRIX_AT(*X, l, c);
+                    x[l].real -= h.real * u.real - h.img * u.img;
+                    x[l].img -= h.real * u.img + h.img * u.real;
+                }
+            }
+        }
+        double norma = cvec_power(x, n);
+        if (norma > maior)
+        {
+            maior = norma;
+            memcpy(melhor, x, n * sizeof(complexo));
+        }
+    }
+    double inv = 1 / sqrt(maior);
+    for (int l = 0; l < n; l++)
+    {
+        CMATRIX_AT(*X, l, j).real = inv * melhor[l].real;
+        CMATRIX_AT(*X, l, j).img = inv * melhor[l].img;
+    }
+}
+
+static int svd_autovetores(cmatrix *G, int r, double *lambda, cmatrix *Y);
+
+/**
+ * @brief Starts the Jacobi method from the eigenvectors of the Gram matrix W W^H instead of the identity.
+ *
+ * With W W^H = Y^H diag(lambda) Y, the rows of conj(Y) W are orthogonal up to the rounding of the
+ * eigen-decomposition, so the sweeps that follow only remove that error, in one to three sweeps
+ * where a random matrix takes about ten from the identity. Jacobi still decides the result: the
+ * preconditioner changes the starting point, not the stopping test.
+ *
+ * @param[in,out] W The rows to be made orthogonal, replaced by conj(Y) W.
+ * @param[out] Q Receives conj(Y), the first factor of the accumulated rotations.
+ * @return 0 on success, or -1 if the QL method did not converge (W is then unchanged).
+ */
+static int svd_precondiciona(cmatrix *W, cmatrix *Q)
+{
+    int k = W->linhas;
+    complexo um = {1, 0}, zero = {0, 0};
+    cmatrix G = cmatrix_alloc(k, k);
+    double *lambda = (double *) arena_malloc(k * sizeof(double));
+    cmatrix_gemm(GEMM_N, W, GEMM_H, W, um, zero, &G);
+    int status = svd_autovetores(&G, k, lambda, Q);
+    if (status == 0)
+    {
+        for (int l = 0; l < k; l++)
+        {
+            complexo *q = Q->data + (size_t) l * Q->ld;
+            cvec_conj(q, q, k);
+        }
+        cmatrix P = cmatrix_alloc(k, W->colunas);
+        cmatrix_gemm(GEMM_N, Q, GEMM_N, W, um, zero, &P);
+        cmatrix antiga = *W;
+        *W = P;
+        cmatrix_free(&antiga);
+    }
+    arena_free(lambda);
+    cmatrix_free(&G);
+    return status;
+}
+
+/**###Complex SVD Function:
+ * The `cmatrix_svd` function computes the reduced singular value decomposition A = U diag(S) V^H of a complex `m x n` matrix, with k = min(m, n) singular values in decreasing order. `U` must be `m x k` and `V` must be `n x k`; `S` receives k values.
+- The method is the one-sided Jacobi method of Hestenes on the k rows of A (when m <= n) or of A^H (when m > n). Pairs of rows are rotated until they are all orthogonal to the working precision; the rotations are accumulated in a `k x k` unitary matrix, and the orthogonal rows are then the right (or left) singular vectors scaled by the singular values. Working on rows keeps every vector contiguous, so each rotation is a conjugated dot product (`cvec_dotc`) and two plane rotations (`cvec_rot`).
+- Each sweep visits the rows in decreasing order of norm (de Rijk's ordering), in blocks of `SVD_BLOCO` rows: all the pairs between two blocks are rotated while their rows are in the cache, instead of streaming the whole matrix once per row.
+- From `SVD_PRECONDICIONA` singular values on, the rotations start from the eigenvectors of the `k x k` Gram matrix (one `cmatrix_gemm`, the tridiagonal reduction and QL method of `cmatrix_svd_truncada`, and one more product) instead of the identity. The rows are then orthogonal up to the rounding of the eigen-decomposition and the sweeps converge quadratically from the first one: a random 512 x 1024 matrix needs a single sweep, which finds nothing left to rotate, instead of eleven, and is decomposed about three times faster in `bench_svd`.
+- The decomposition works on the complex matrix itself, unlike the real-only `gsl_linalg_SV_decomp`, and Jacobi computes the small singular values with high relative accuracy.
+- Rows whose norm falls to the rounding level of the largest one (rank-deficient matrices) are not rotated: their singular values are returned as 0, and their singular vectors of the long side, which A does not determine, complete the others to an orthonormal set.
+- The workspace comes from `arena_malloc`, so inside an active arena the decomposition does not call `malloc`.
+ * @param[in] A
+ * @param[out] U, S, V
+ * @return 0 on success, or -1 if the dimensions do not match or the method did not converge in `SVD_MAX_VARREDURAS` sweeps (the factors are still filled with the last iterate).
+ * */
+int cmatrix_svd(const cmatrix *A, cmatrix *U, double *S, cmatrix *V)
+{
+    int m = A->linhas, n = A->colunas;
+    int larga = (m <= n);
+    int k = larga ? m : n, comprimento = larga ? n : m;
+    if (U->linhas != m || U->colunas != k || V->linhas != n || V->colunas != k)
+    {
+        printf("\nError: The SVD factors have incompatible dimensions\n");
+        return -1;
+    }
+
+    // W holds the rows to be made orthogonal and Q the product of the rotations (Q^H of the
+    // decomposition W0 = Q W), starting from the identity or, for large matrices, from the
+    // eigenvectors of the Gram matrix
+    cmatrix W = cmatrix_alloc(k, comprimento);
+    cmatrix Q = cmatrix_alloc(k, k);
+    double *norma = (double *) arena_malloc(k * sizeof(double));
+    svd_valor *valores = (svd_valor *) arena_malloc(k * sizeof(svd_valor));
+    if (larga)
+    {
+        for (int l = 0; l < k; l++)
+        {
+            memcpy(W.data + (size_t) l * W.ld, A->data + (size_t) l * A->ld, comprimento * sizeof(complexo));
+        }
+    }
+    else
+    {
+        cmatrix_hermitiana_into(&W, A);
+    }
+    if (k < SVD_PRECONDICIONA || svd_precondiciona(&W, &Q) != 0)
+    {
+        for (int l = 0; l < k; l++)
+        {
+            memset(Q.data + (size_t) l * Q.ld, 0, k * sizeof(complexo));
+            CMATRIX_AT(Q, l, l).real = 1;
+        }
+    }
+
+    const double tol = DBL_EPSILON * sqrt((double) comprimento);
+    int convergiu = 0;
+    for (int varredura = 0; varredura < SVD_MAX_VARREDURAS && !convergiu; varredura++)
+    {
+        // The norms are updated by every rotation; recomputing them once per sweep bounds the drift.
+        // The pairs are visited in decreasing order of norm, which keeps the larger row of each
+        // pair the larger one and saves a few sweeps
+        for (int l = 0; l < k; l++)
+        {
+            norma[l] = cvec_power(W.data + (size_t) l * W.ld, comprimento);
+            valores[l].s = norma[l];
+            valores[l].linha = l;
+        }
+        qsort(valores, k, sizeof(svd_valor), svd_compara);
+        // Rows below the rounding level of the largest one are numerically zero
+        double nulo = valores[0].s * tol * tol;
+        int rotacoes = 0;
+        for (int b0 = 0; b0 < k; b0 += SVD_BLOCO)
+        {
+            int b1 = (b0 + SVD_BLOCO < k) ? b0 + SVD_BLOCO : k;
+            for (int c0 = b0; c0 < k; c0 += SVD_BLOCO)
+            {
+                int c1 = (c0 + SVD_BLOCO < k) ? c0 + SVD_BLOCO : k;
+                for (int p = b0; p < b1; p++)
+                {
+                    for (int q = (c0 == b0) ? p + 1 : c0; q < c1; q++)
+                    {
+                        rotacoes += svd_rotaciona(&W, &Q, norma, valores[p].linha, valores[q].linha, tol, nulo);
+                    }
+                }
+            }
+        }
+        convergiu = (rotacoes == 0);
+    }
+
+    for (int l = 0; l < k; l++)
+    {
+        valores[l].s = sqrt(cvec_power(W.data + (size_t) l * W.ld, comprimento));
+        valores[l].linha = l;
+    }
+    qsort(valores, k, sizeof(svd_valor), svd_compara);
+
+    // Row i of W is s_i times the conjugate of a singular vector of the long side, and row i of
+    // Q^H the conjugate of the matching singular vector of the short side
+    cmatrix *longo = larga ? V : U, *curto = larga ? U : V;
+    for (int j = 0; j < k; j++)
+    {
+        int i = valores[j].linha;
+        // A row at the rounding level of the largest one holds no direction of A
+        int nula = (valores[j].s <= tol * valores[0].s);
+        double inv = nula ? 0 : 1 / valores[j].s;
+        const complexo *w = W.data + (size_t) i * W.ld, *q = Q.data + (size_t) i * Q.ld;
+        S[j] = nula ? 0 : valores[j].s;
+        for (int l = 0; l < comprimento; l++)
+        {
+            CMATRIX_AT(*longo, l, j).real = inv * w[l].real;
+            CMATRIX_AT(*longo, l, j).img = -inv * w[l].img;
+        }
+        for (int l = 0; l < k; l++)
+        {
+            CMATRIX_AT(*curto, l, j).real = q[l].real;
+            CMATRIX_AT(*curto, l, j).img = -q[l].img;
+        }
+    }
+    // The null singular values come last, so each of their vectors is completed against all the others
+    if (S[k - 1] == 0)
+    {
+        complexo *x = (complexo *) arena_malloc(2 * comprimento * sizeof(complexo));
+        for (int j = 0; j < k; j++)
+        {
+            if (S[j] == 0)
+            {
+                svd_completa(longo, j, x, x + comprimento);
+            }
+        }
+        arena_free(x);
+    }
+
+    arena_free(valores);
+    arena_free(norma);
+    cmatrix_free(&Q);
+    cmatrix_free(&W);
+    if (!convergiu)
+    {
+        printf("\nWarning: The SVD did not converge in %d sweeps\n", SVD_MAX_VARREDURAS);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reduces the Hermitian matrix G (k x k, both triangles stored) to a real symmetric tridiagonal matrix T = Q^H G Q.
+ *
+ * Q = H_0 H_1 ... H_(k-2), with the Householder reflector H_j = I - tau_j v_j v_j^H acting on the
+ * entries j+1 to k-1 (as in LAPACK's zhetd2). Each reflector makes the column j real on the
+ * subdiagonal and zero under it; v_j is left in row j of G, from column j + 1, and tau_j in tau.
+ * Every update of the trailing block goes through its rows, so the products are `cvec_dotc` and
+ * `cvec_axpy` on contiguous vectors.
+ *
+ * @param[out] d, e The diagonal and the subdiagonal of T (e[j] between j and j + 1, e[k - 1] = 0).
+ * @param[out] tau The k - 1 scalars of the reflectors (0 when the column was already reduced).
+ * @param x, xc, vc Workspaces of k values.
+ */
+static void svd_tridiagonaliza(cmatrix *G, double *d, double *e, complexo *tau, complexo *x, complexo *xc, complexo *vc)
+{
+    int k = G->linhas;
+    for (int j = 0; j < k - 1; j++)
+    {
+        int n = k - j - 1;
+        complexo *v = G->data + (size_t) j * G->ld + j + 1;
+        d[j] = CMATRIX_AT(*G, j, j).real;
+
+        // The column below the diagonal is the conjugate of the row, which holds v from now on
+        cvec_conj(v, v, n);
+        complexo alfa = v[0];
+        double resto = cvec_power(v + 1, n - 1);
+        if (resto == 0 && alfa.img == 0)
+        {
+            tau[j].real = 0;
+            tau[j].img = 0;
+            e[j] = alfa.real;
+            continue;
+        }
+        double beta = -copysign(sqrt(alfa.real * alfa.real + alfa.img * alfa.img + resto), alfa.real);
+        tau[j].real = (beta - alfa.real) / beta;
+        tau[j].img = -alfa.img / beta;
+        // v = x / (alfa - beta), with v[0] = 1
+        double dr = alfa.real - beta, di = alfa.img, q = dr * dr + di * di;
+        complexo escala = {dr / q, -di / q};
+        for (int i = 1; i < n; i++)
+        {
+            v[i] = multcomp(escala, v[i]);
+        }
+        v[0].real = 1;
+        v[0].img = 0;
+        e[j] = beta;
+
+        // x = tau A v and w = x - (tau / 2) (x^H v) v, then A = A - v w^H - w v^H on the trailing block
+        cvec_conj(vc, v, n);
+        for (int i = 0; i < n; i++)
+        {
+            x[i] = multcomp(tau[j], cvec_dotc(vc, G->data + (size_t) (j + 1 + i) * G->ld + j + 1, n));
+        }
+        complexo meio = multcomp(tau[j], cvec_dotc(x, v, n));
+        meio.real *= -0.5;
+        meio.img *= -0.5;
+        cvec_axpy(x, meio, v, n);
+        cvec_conj(xc, x, n);
+        for (int i = 0; i < n; i++)
+        {
+            complexo *linha = G->data + (size_t) (j + 1 + i) * G->ld + j + 1;
+            cvec_axpy(linha, (complexo){-v[i].real, -v[i].img}, xc, n);
+            cvec_axpy(linha, (complexo){-x[i].real, -x[i].img}, vc, n);
+        }
+    }
+    d[k - 1] = CMATRIX_AT(*G, k - 1, k - 1).real;
+    e[k - 1] = 0;
+}
+
+/**
+ * @brief Eigenvalues and eigenvectors of a real symmetric tridiagonal matrix by the implicit QL method.
+ *
+ * The method of `tql2` (EISPACK) with Wilkinson's shift. The rotations act on the eigenvectors as rows of Z
+ * (k x k, from the identity), so they run over contiguous memory; on return row i of Z is the
+ * eigenvector of d[i]. The eigenvalues are not sorted.
+ *
+ * @return 0 on success, or -1 if an eigenvalue did not converge in `SVD_MAX_ITERACOES` iterations.
+ */
+static int svd_tridiagonal_ql(double *d, double *e, double *Z, int k)
+{
+    // An off-diagonal entry is negligible next to the norm of the matrix, as in tql2: a test
+    // relative to its neighbours alone never deflates the eigenvalues that are zero up to rounding
+    double norma = 0;
+    for (int l = 0; l < k; l++)
+    {
+        norma = fmax(norma, fabs(d[l]) + fabs(e[l]));
+    }
+    for (int l = 0; l < k; l++)
+    {
+        int iteracoes = 0, m;
+        do
+        {
+            for (m = l; m < k - 1; m++)
+            {
+                if (fabs(e[m]) <= DBL_EPSILON * norma)
+                {
+                    break;
+                }
+            }
+            if (m == l)
+            {
+                break;
+            }
+            if (iteracoes++ == SVD_MAX_ITERACOES)
+            {
+                return -1;
+            }
+            double g = (d[l + 1] - d[l]) / (2 * e[l]);
+            double r = hypot(g, 1);
+            g = d[m] - d[l] + e[l] / (g + copysign(r, g));
+            double s = 1, c = 1, p = 0;
+            int i;
+            for (i = m - 1; i >= l; i--)
+            {
+                double f = s * e[i], b = c * e[i];
+                e[i + 1] = r = hypot(f, g);
+                if (r == 0)
+                {
+                    d[i + 1] -= p;
+                    e[m] = 0;
+                    break;
+                }
+                s = f / r;
+                c = g / r;
+                g = d[i + 1] - p;
+                r = (d[i] - g) * s + 2 * c * b;
+                p = s * r;
+                d[i + 1] = g + p;
+                g = c * r - b;
+                double *zi = Z + (size_t) i * k, *zj = zi + k;
+                for (int t = 0; t < k; t++)
+                {
+                    double zt = zj[t];
+                    zj[t] = s * zi[t] + c * zt;
+                    zi[t] = c * zi[t] - s * zt;
+                }
+            }
+            if (r == 0 && i >= l)
+            {
+                continue;
+            }
+            d[l] -= p;
+            e[l] = g;
+            e[m] = 0;
+        } while (m != l);
+    }
+    return 0;
+}
+
+/**
+ * @brief The r largest eigenvalues of the Hermitian matrix G (k x k, overwritten) and their eigenvectors.
+ *
+ * G is reduced to tridiagonal form (`svd_tridiagonaliza`) and diagonalized by `svd_tridiagonal_ql`;
+ * only the r eigenvectors kept are carried back through the reflectors.
+ *
+ * @param[out] lambda The r largest eigenvalues, in decreasing order.
+ * @param[out] Y An `r x k` matrix whose row j is the eigenvector of lambda[j].
+ * @return 0 on success, or -1 if the QL method did not converge.
+ */
+static int svd_autovetores(cmatrix *G, int r, double *lambda, cmatrix *Y)
+{
+    int k = G->linhas;
+    double *d = (double *) arena_malloc(2 * k * sizeof(double));
+    double *e = d + k;
+    complexo *tau = (complexo *) arena_malloc(4 * k * sizeof(complexo));
+    double *Z = (double *) arena_malloc((size_t) k * k * sizeof(double));
+    svd_valor *valores = (svd_valor *) arena_malloc(k * sizeof(svd_valor));
+    svd_tridiagonaliza(G, d, e, tau, tau + k, tau + 2 * k, tau + 3 * k);
+    memset(Z, 0, (size_t) k * k * sizeof(double));
+    for (int l = 0; l < k; l++)
+    {
+        Z[(size_t) l * k + l] = 1;
+    }
+    int status = svd_tridiagonal_ql(d, e, Z, k);
+    for (int l = 0; l < k; l++)
+    {
+        valores[l].s = d[l];
+        valores[l].linha = l;
+    }
+    qsort(valores, k, sizeof(svd_valor), svd_compara);
+
+    // The eigenvector of T, then Q times it
+    for (int j = 0; j < r; j++)
+    {
+        complexo *y = Y->data + (size_t) j * Y->ld;
+        const double *z = Z + (size_t) valores[j].linha * k;
+        for (int l = 0; l < k; l++)
+        {
+            y[l].real = z[l];
+            y[l].img = 0;
+        }
+        for (int i = k - 2; i >= 0; i--)
+        {
+            if (tau[i].real == 0 && tau[i].img == 0)
+            {
+                continue;
+            }
+            const complexo *v = G->data + (size_t) i * G->ld + i + 1;
+            complexo h = multcomp(tau[i], cvec_dotc(v, y + i + 1, k - i - 1));
+            cvec_axpy(y + i + 1, (complexo){-h.real, -h.img}, v, k - i - 1);
+        }
+        lambda[j] = valores[j].s;
+    }
+
+    arena_free(valores);
+    arena_free(Z);
+    arena_free(tau);
+    arena_free(d);
+    return status;
+}
+
+/**
+ * @brief Truncated SVD from the eigenvectors of the smaller Gram matrix, G = A A^H (m <= n) or A^H A (m > n).
+ *
+ * G is formed by `cmatrix_gemm` and diagonalized by `svd_autovetores`, which carries only the r
+ * largest eigenvectors back through the reflectors; the singular vectors of the long side come from
+ * one more product, A^H U S^-1 or A V S^-1.
+ */
+static int svd_gram(const cmatrix *A, int r, cmatrix *U, double *S, cmatrix *V)
+{
+    int m = A->linhas, n = A->colunas;
+    int larga = (m <= n);
+    int k = larga ? m : n;
+    complexo um = {1, 0}, zero = {0, 0};
+
+    cmatrix G = cmatrix_alloc(k, k);
+    if (larga)
+    {
+        cmatrix_gemm(GEMM_N, A, GEMM_H, A, um, zero, &G);
+    }
+    else
+    {
+        cmatrix_gemm(GEMM_H, A, GEMM_N, A, um, zero, &G);
+    }
+
+    // Row j of Y is the eigenvector of the j-th largest eigenvalue
+    cmatrix Y = cmatrix_alloc(r, k);
+    int status = svd_autovetores(&G, r, S, &Y);
+    // An eigenvalue at the rounding level of G carries no direction of A: its singular value is
+    // zero, as for an exactly singular matrix, instead of the square root of the rounding error
+    double piso = k * DBL_EPSILON * S[0];
+    for (int j = 0; j < r; j++)
+    {
+        S[j] = S[j] > piso ? sqrt(S[j]) : 0;
+    }
+
+    // The short side is Y^T; the long side is A^H conj(Y)^T S^-1 (wide) or A Y^T S^-1 (tall)
+    cmatrix *longo = larga ? V : U, *curto = larga ? U : V;
+    int comprimento = larga ? n : m;
+    cmatrix P = larga ? cmatrix_alloc(r, comprimento) : cmatrix_alloc(comprimento, r);
+    if (larga)
+    {
+        cmatrix_gemm(GEMM_C, &Y, GEMM_N, A, um, zero, &P);
+    }
+    else
+    {
+        cmatrix_gemm(GEMM_N, A, GEMM_T, &Y, um, zero, &P);
+    }
+    for (int j = 0; j < r; j++)
+    {
+        double inv = S[j] > 0 ? 1 / S[j] : 0;
+        for (int l = 0; l < k; l++)
+        {
+            CMATRIX_AT(*curto, l, j) = CMATRIX_AT(Y, j, l);
+        }
+        for (int l = 0; l < comprimento; l++)
+        {
+            complexo p = larga ? CMATRIX_AT(P, j, l) : CMATRIX_AT(P, l, j);
+            CMATRIX_AT(*longo, l, j).real = inv * p.real;
+            CMATRIX_AT(*longo, l, j).img = (larga ? -inv : inv) * p.img;
+        }
+    }
+
+    cmatrix_free(&P);
+    cmatrix_free(&Y);
+    cmatrix_free(&G);
+    if (status != 0)
+    {
+        printf("\nWarning: The tridiagonal QL method did not converge in %d iterations, using Jacobi\n", SVD_MAX_ITERACOES);
+    }
+    return status;
+}
+
+/**###Truncated SVD Function:
+ * The `cmatrix_svd_truncada` function computes the `r` largest singular triplets of a complex `m x n` matrix A, A ~ U diag(S) V^H, in decreasing order, with 1 <= r <= k = min(m, n). `U` must be `m x r` and `V` must be `n x r`; `S` receives r values. With r = k it is the reduced SVD of `cmatrix_svd`.
+- When one side of A is at least `SVD_GRAM_RAZAO` times the other, the triplets are first taken from the Hermitian eigen-decomposition of the `k x k` Gram matrix (A A^H for wide matrices, A^H A for tall ones): one product, a Householder reduction to tridiagonal form and the implicit QL method, all O(k^3) with small constants, without the O(k^2 max(m, n)) Jacobi sweep that `cmatrix_svd` still runs after the same eigen-decomposition. Only the r vectors kept are carried back through the reflectors and multiplied by A.
+- The Gram matrix squares the condition number: the relative error of s_j and the loss of orthogonality of the singular vectors grow as DBL_EPSILON (s_1 / s_j)^2. The result is kept only when s_r > `SVD_GRAM_LIMIAR` s_1, which bounds them near 1e-12; otherwise (ill-conditioned or rank-deficient matrices, or a QL failure) A is decomposed by the one-sided Jacobi of `cmatrix_svd`, as it is when A is close to square, and its first r columns are kept.
+- With r = k it is the reduced SVD of `cmatrix_svd`, up to the phase of each pair of singular vectors and to the accuracy above.
+- The workspace comes from `arena_malloc`, as in `cmatrix_svd`.
+ * @param[in] A, r
+ * @param[out] U, S, V
+ * @return 0 on success, or -1 if the dimensions do not match or the method did not converge.
+ * */
+int cmatrix_svd_truncada(const cmatrix *A, int r, cmatrix *U, double *S, cmatrix *V)
+{
+    int m = A->linhas, n = A->colunas;
+    int k = (m <= n) ? m : n, comprimento = (m <= n) ? n : m;
+    if (r < 1 || r > k || U->linhas != m || U->colunas != r || V->linhas != n || V->colunas != r)
+    {
+        printf("\nError: The SVD factors have incompatible dimensions\n");
+        return -1;
+    }
+    if (comprimento >= SVD_GRAM_RAZAO * k && svd_gram(A, r, U, S, V) == 0 && S[r - 1] > SVD_GRAM_LIMIAR * S[0])
+    {
+        return 0;
+    }
+    if (r == k)
+    {
+        return cmatrix_svd(A, U, S, V);
+    }
+
+    cmatrix Uk = cmatrix_alloc(m, k);
+    cmatrix Vk = cmatrix_alloc(n, k);
+    double *Sk = (double *) arena_malloc(k * sizeof(double));
+    int status = cmatrix_svd(A, &Uk, Sk, &Vk);
+    memcpy(S, Sk, r * sizeof(double));
+    for (int l = 0; l < m; l++)
+    {
+        memcpy(U->data + (size_t) l * U->ld, Uk.data + (size_t) l * Uk.ld, r * sizeof(complexo));
+    }
+    for (int l = 0; l < n; l++)
+    {
+        memcpy(V->data + (size_t) l * V->ld, Vk.data + (size_t) l * Vk.ld, r * sizeof(complexo));
+    }
+    arena_free(Sk);
+    cmatrix_free(&Vk);
+    cmatrix_free(&Uk);
+    return status;
+}
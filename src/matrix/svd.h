@@ -0,0 +1,23 @@
+#ifndef _H_SVD
+#define _H_SVD
+
+#include "matrix.h"
+
+/** Número máximo de varreduras do método de Jacobi antes de desistir da convergência. */
+#define SVD_MAX_VARREDURAS 30
+/** Linhas de cada bloco da varredura: os pares de dois blocos são rodados juntos, enquanto as linhas deles estão na cache L2. */
+#define SVD_BLOCO 16
+/** Menor número de valores singulares a partir do qual o método de Jacobi parte dos autovetores da matriz de Gram em vez da identidade. */
+#define SVD_PRECONDICIONA 64
+/** Número máximo de iterações do método QL para cada autovalor da matriz tridiagonal. */
+#define SVD_MAX_ITERACOES 30
+/** Razão mínima entre o lado maior e o menor da matriz para a SVD truncada tentar a matriz de Gram. */
+#define SVD_GRAM_RAZAO 2
+/** Menor razão s_min / s_max dos valores guardados que a SVD truncada aceita da matriz de Gram, cujo erro cresce com (s_max / s_min)^2; abaixo dela a matriz é decomposta por Jacobi. */
+#define SVD_GRAM_LIMIAR 1e-2
+
+//Função: Decomposição em valores singulares reduzida de uma matriz complexa, A = U diag(S) V^H, com os valores singulares em ordem decrescente.
+int cmatrix_svd(const cmatrix *A, cmatrix *U, double *S, cmatrix *V);
+//Função: Os r maiores valores singulares de uma matriz complexa e seus vetores singulares, pela matriz de Gram quando a matriz é bem retangular.
+int cmatrix_svd_truncada(const cmatrix *A, int r, cmatrix *U, double *S, cmatrix *V);
+#endif